@@ -32,6 +32,8 @@
 #include "pitch.h"
 #include "kiss_fft.h"
 #include "mdct.h"
+#include "mathops.h"
+#include "bands.h"
 
 #if defined(OPUS_HAVE_RTCD)
 
@@ -52,6 +54,69 @@ void (*const DUAL_INNER_PROD_IMPL[OPUS_ARCHMASK+1])(const opus_val16 *x, const o
 };
 # endif
 
+# if defined(OPUS_ARM_MAY_HAVE_NEON_INTR) && !defined(OPUS_ARM_PRESUME_NEON_INTR)
+#  if defined(FIXED_POINT)
+void (*const CELT_BAND_SUMSQ_IMPL[OPUS_ARCHMASK+1])(const celt_sig *X,
+      opus_val32 *sum, int *shift, const opus_int16 *eBands, const opus_int16 *logN,
+      int start, int end, int LM) = {
+  celt_band_sumsq_c,   /* ARMv4 */
+  celt_band_sumsq_c,   /* EDSP */
+  celt_band_sumsq_c,   /* Media */
+  celt_band_sumsq_neon /* NEON */
+};
+
+void (*const CELT_BAND_NORMALISE_IMPL[OPUS_ARCHMASK+1])(const celt_sig *freq,
+      celt_norm *X, const opus_val16 *g, const int *shift, const opus_int16 *eBands,
+      int start, int end, int M) = {
+  celt_band_normalise_c,   /* ARMv4 */
+  celt_band_normalise_c,   /* EDSP */
+  celt_band_normalise_c,   /* Media */
+  celt_band_normalise_neon /* NEON */
+};
+
+void (*const CELT_BAND_DENORMALISE_IMPL[OPUS_ARCHMASK+1])(const celt_norm *X,
+      celt_sig *freq, const opus_val16 *g, const int *shift, const opus_int16 *eBands,
+      int start, int end, int M) = {
+  celt_band_denormalise_c,   /* ARMv4 */
+  celt_band_denormalise_c,   /* EDSP */
+  celt_band_denormalise_c,   /* Media */
+  celt_band_denormalise_neon /* NEON */
+};
+#  else
+void (*const CELT_BAND_SCALE_IMPL[OPUS_ARCHMASK+1])(const float *in,
+      float *out, const opus_val16 *g, const opus_int16 *eBands, int start, int end, int M) = {
+  celt_band_scale_c,   /* ARMv4 */
+  celt_band_scale_c,   /* EDSP */
+  celt_band_scale_c,   /* Media */
+  celt_band_scale_neon /* NEON */
+};
+#  endif
+# endif
+
+# if defined(OPUS_ARM_MAY_HAVE_NEON_INTR) && !defined(OPUS_ARM_PRESUME_NEON_INTR) && \
+  !defined(DISABLE_FLOAT_API)
+void (*const CELT_FLOAT2INT16_IMPL[OPUS_ARCHMASK+1])(const float *in, opus_int16 *out, int cnt) = {
+  celt_float2int16_c,   /* ARMv4 */
+  celt_float2int16_c,   /* EDSP */
+  celt_float2int16_c,   /* Media */
+  celt_float2int16_neon /* NEON */
+};
+
+void (*const CELT_INT16TOFLOAT_IMPL[OPUS_ARCHMASK+1])(const opus_int16 *in, float *out, int cnt) = {
+  celt_int16tofloat_c,   /* ARMv4 */
+  celt_int16tofloat_c,   /* EDSP */
+  celt_int16tofloat_c,   /* Media */
+  celt_int16tofloat_neon /* NEON */
+};
+
+int (*const CELT_LIMIT2_CHECKWITHIN1_IMPL[OPUS_ARCHMASK+1])(float *samples, int cnt) = {
+  celt_limit2_checkwithin1_c,   /* ARMv4 */
+  celt_limit2_checkwithin1_c,   /* EDSP */
+  celt_limit2_checkwithin1_c,   /* Media */
+  celt_limit2_checkwithin1_neon /* NEON */
+};
+# endif
+
 # if defined(FIXED_POINT)
 #  if ((defined(OPUS_ARM_MAY_HAVE_NEON) && !defined(OPUS_ARM_PRESUME_NEON)) || \
     (defined(OPUS_ARM_MAY_HAVE_MEDIA) && !defined(OPUS_ARM_PRESUME_MEDIA)) || \
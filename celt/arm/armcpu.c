@@ -35,6 +35,7 @@
 
 #include "armcpu.h"
 #include "cpu_support.h"
+#include "cpu_cache.h"
 #include "os_support.h"
 #include "opus_types.h"
 #include "arch.h"
@@ -156,7 +157,7 @@ opus_uint32 opus_cpu_capabilities(void)
    "your platform.  Reconfigure with --disable-rtcd (or send patches)."
 #endif
 
-int opus_select_arch(void)
+static int opus_select_arch_impl(void)
 {
   opus_uint32 flags = opus_cpu_capabilities();
   int arch = 0;
@@ -184,4 +185,18 @@ int opus_select_arch(void)
   return arch;
 }
 
+/* On Linux the capabilities come from parsing /proc/cpuinfo, and this is
+   called on every encoder and decoder init and reset */
+OPUS_ARCH_CACHE(arch_cache);
+
+int opus_select_arch(void)
+{
+  int arch = OPUS_ARCH_CACHE_LOAD(arch_cache) - 1;
+  if(arch < 0) {
+    arch = opus_select_arch_impl();
+    OPUS_ARCH_CACHE_STORE(arch_cache, arch + 1);
+  }
+  return arch;
+}
+
 #endif
@@ -0,0 +1,88 @@
+/* Copyright (c) 2026 Opus contributors */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#if !defined(BANDS_ARM_H)
+# define BANDS_ARM_H
+
+# include "cpu_support.h"
+
+# if defined(OPUS_ARM_MAY_HAVE_NEON_INTR)
+#  if defined(FIXED_POINT)
+void celt_band_sumsq_neon(const celt_sig *X, opus_val32 *sum, int *shift,
+      const opus_int16 *eBands, const opus_int16 *logN, int start, int end, int LM);
+void celt_band_normalise_neon(const celt_sig * OPUS_RESTRICT freq,
+      celt_norm * OPUS_RESTRICT X, const opus_val16 *g, const int *shift,
+      const opus_int16 *eBands, int start, int end, int M);
+void celt_band_denormalise_neon(const celt_norm * OPUS_RESTRICT X,
+      celt_sig * OPUS_RESTRICT freq, const opus_val16 *g, const int *shift,
+      const opus_int16 *eBands, int start, int end, int M);
+#  else
+void celt_band_scale_neon(const float * OPUS_RESTRICT in, float * OPUS_RESTRICT out,
+      const opus_val16 *g, const opus_int16 *eBands, int start, int end, int M);
+#  endif
+
+#  if defined(OPUS_HAVE_RTCD) && !defined(OPUS_ARM_PRESUME_NEON_INTR)
+#   define OVERRIDE_CELT_BAND_KERNELS (1)
+#   if defined(FIXED_POINT)
+extern void (*const CELT_BAND_SUMSQ_IMPL[OPUS_ARCHMASK+1])(const celt_sig *X,
+      opus_val32 *sum, int *shift, const opus_int16 *eBands, const opus_int16 *logN,
+      int start, int end, int LM);
+extern void (*const CELT_BAND_NORMALISE_IMPL[OPUS_ARCHMASK+1])(const celt_sig *freq,
+      celt_norm *X, const opus_val16 *g, const int *shift, const opus_int16 *eBands,
+      int start, int end, int M);
+extern void (*const CELT_BAND_DENORMALISE_IMPL[OPUS_ARCHMASK+1])(const celt_norm *X,
+      celt_sig *freq, const opus_val16 *g, const int *shift, const opus_int16 *eBands,
+      int start, int end, int M);
+#    define celt_band_sumsq(X, sum, shift, eBands, logN, start, end, LM, arch) \
+   ((*CELT_BAND_SUMSQ_IMPL[(arch)&OPUS_ARCHMASK])(X, sum, shift, eBands, logN, start, end, LM))
+#    define celt_band_normalise(freq, X, g, shift, eBands, start, end, M, arch) \
+   ((*CELT_BAND_NORMALISE_IMPL[(arch)&OPUS_ARCHMASK])(freq, X, g, shift, eBands, start, end, M))
+#    define celt_band_denormalise(X, freq, g, shift, eBands, start, end, M, arch) \
+   ((*CELT_BAND_DENORMALISE_IMPL[(arch)&OPUS_ARCHMASK])(X, freq, g, shift, eBands, start, end, M))
+#   else
+extern void (*const CELT_BAND_SCALE_IMPL[OPUS_ARCHMASK+1])(const float *in,
+      float *out, const opus_val16 *g, const opus_int16 *eBands, int start, int end, int M);
+#    define celt_band_scale(in, out, g, eBands, start, end, M, arch) \
+   ((*CELT_BAND_SCALE_IMPL[(arch)&OPUS_ARCHMASK])(in, out, g, eBands, start, end, M))
+#   endif
+#  elif defined(OPUS_ARM_PRESUME_NEON_INTR)
+#   define OVERRIDE_CELT_BAND_KERNELS (1)
+#   if defined(FIXED_POINT)
+#    define celt_band_sumsq(X, sum, shift, eBands, logN, start, end, LM, arch) \
+   ((void)(arch), celt_band_sumsq_neon(X, sum, shift, eBands, logN, start, end, LM))
+#    define celt_band_normalise(freq, X, g, shift, eBands, start, end, M, arch) \
+   ((void)(arch), celt_band_normalise_neon(freq, X, g, shift, eBands, start, end, M))
+#    define celt_band_denormalise(X, freq, g, shift, eBands, start, end, M, arch) \
+   ((void)(arch), celt_band_denormalise_neon(X, freq, g, shift, eBands, start, end, M))
+#   else
+#    define celt_band_scale(in, out, g, eBands, start, end, M, arch) \
+   ((void)(arch), celt_band_scale_neon(in, out, g, eBands, start, end, M))
+#   endif
+#  endif
+# endif
+
+#endif
@@ -0,0 +1,178 @@
+/* Copyright (c) 2026 Opus contributors */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <arm_neon.h>
+#include "../bands.h"
+#include "../mathops.h"
+
+/* Same structure as the SSE2 versions: 8 bins at a time within each band,
+   with the C expression for what is left at the end of the band. The
+   variable shifts use vshlq_s32(), which shifts right (arithmetically) for
+   negative counts, so VSHR32(x,s) is vshlq_s32(x,-s). */
+
+#ifdef FIXED_POINT
+
+void celt_band_sumsq_neon(const celt_sig *X, opus_val32 *sum, int *shift,
+      const opus_int16 *eBands, const opus_int16 *logN, int start, int end, int LM)
+{
+   int i;
+   for (i=start;i<end;i++)
+   {
+      int j;
+      int band_start, band_end;
+      int sh = 0;
+      opus_val32 maxval, minval;
+      opus_val32 s = 0;
+      int32x4_t vmax, vmin;
+      int32x2_t max2, min2;
+      band_start = eBands[i]<<LM;
+      band_end = eBands[i+1]<<LM;
+      vmax = vmin = vdupq_n_s32(0);
+      for (j=band_start;j<band_end-3;j+=4)
+      {
+         int32x4_t x = vld1q_s32(X+j);
+         vmax = vmaxq_s32(vmax, x);
+         vmin = vminq_s32(vmin, x);
+      }
+      max2 = vpmax_s32(vget_low_s32(vmax), vget_high_s32(vmax));
+      min2 = vpmin_s32(vget_low_s32(vmin), vget_high_s32(vmin));
+      maxval = vget_lane_s32(vpmax_s32(max2, max2), 0);
+      minval = vget_lane_s32(vpmin_s32(min2, min2), 0);
+      for (;j<band_end;j++)
+      {
+         maxval = MAX32(maxval, X[j]);
+         minval = MIN32(minval, X[j]);
+      }
+      maxval = MAX32(maxval, -minval);
+      if (maxval > 0)
+      {
+         int32x4_t acc, vsh;
+         int32x2_t acc2;
+         sh = celt_ilog2(maxval) - 14 + (((logN[i]>>BITRES)+LM+1)>>1);
+         vsh = vdupq_n_s32(-sh);
+         acc = vdupq_n_s32(0);
+         for (j=band_start;j<band_end-7;j+=8)
+         {
+            int16x4_t x0, x1;
+            /* vmovn_s32() truncates like EXTRACT16() */
+            x0 = vmovn_s32(vshlq_s32(vld1q_s32(X+j), vsh));
+            x1 = vmovn_s32(vshlq_s32(vld1q_s32(X+j+4), vsh));
+            acc = vmlal_s16(acc, x0, x0);
+            acc = vmlal_s16(acc, x1, x1);
+         }
+         acc2 = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+         acc2 = vpadd_s32(acc2, acc2);
+         s = vget_lane_s32(acc2, 0);
+         for (;j<band_end;j++)
+            s = MAC16_16(s, EXTRACT16(VSHR32(X[j],sh)), EXTRACT16(VSHR32(X[j],sh)));
+      }
+      shift[i] = sh;
+      sum[i] = s;
+   }
+}
+
+void celt_band_normalise_neon(const celt_sig * OPUS_RESTRICT freq,
+      celt_norm * OPUS_RESTRICT X, const opus_val16 *g, const int *shift,
+      const opus_int16 *eBands, int start, int end, int M)
+{
+   int i;
+   for (i=start;i<end;i++)
+   {
+      int j;
+      int band_end;
+      int32x4_t sh;
+      int16x4_t gain;
+      j = M*eBands[i];
+      band_end = M*eBands[i+1];
+      sh = vdupq_n_s32(-shift[i]);
+      gain = vdup_n_s16(g[i]);
+      for (;j<band_end-7;j+=8)
+      {
+         int32x4_t p0, p1;
+         p0 = vmull_s16(vmovn_s32(vshlq_s32(vld1q_s32(freq+j), sh)), gain);
+         p1 = vmull_s16(vmovn_s32(vshlq_s32(vld1q_s32(freq+j+4), sh)), gain);
+         vst1q_s16(X+j, vcombine_s16(vmovn_s32(vshrq_n_s32(p0, 15)),
+               vmovn_s32(vshrq_n_s32(p1, 15))));
+      }
+      for (;j<band_end;j++)
+         X[j] = MULT16_16_Q15(VSHR32(freq[j],shift[i]),g[i]);
+   }
+}
+
+void celt_band_denormalise_neon(const celt_norm * OPUS_RESTRICT X,
+      celt_sig * OPUS_RESTRICT freq, const opus_val16 *g, const int *shift,
+      const opus_int16 *eBands, int start, int end, int M)
+{
+   int i;
+   for (i=start;i<end;i++)
+   {
+      int j;
+      int band_end;
+      int32x4_t sh;
+      int16x4_t gain;
+      j = M*eBands[i];
+      band_end = M*eBands[i+1];
+      sh = vdupq_n_s32(-shift[i]);
+      gain = vdup_n_s16(g[i]);
+      for (;j<band_end-7;j+=8)
+      {
+         int16x8_t x = vld1q_s16(X+j);
+         vst1q_s32(freq+j, vshlq_s32(vmull_s16(vget_low_s16(x), gain), sh));
+         vst1q_s32(freq+j+4, vshlq_s32(vmull_s16(vget_high_s16(x), gain), sh));
+      }
+      for (;j<band_end;j++)
+         freq[j] = VSHR32(MULT16_16(X[j],g[i]),shift[i]);
+   }
+}
+
+#else
+
+void celt_band_scale_neon(const float * OPUS_RESTRICT in, float * OPUS_RESTRICT out,
+      const opus_val16 *g, const opus_int16 *eBands, int start, int end, int M)
+{
+   int i;
+   for (i=start;i<end;i++)
+   {
+      int j;
+      int band_end;
+      j = M*eBands[i];
+      band_end = M*eBands[i+1];
+      for (;j<band_end-7;j+=8)
+      {
+         vst1q_f32(out+j, vmulq_n_f32(vld1q_f32(in+j), g[i]));
+         vst1q_f32(out+j+4, vmulq_n_f32(vld1q_f32(in+j+4), g[i]));
+      }
+      for (;j<band_end;j++)
+         out[j] = in[j]*g[i];
+   }
+}
+
+#endif
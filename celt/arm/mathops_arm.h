@@ -0,0 +1,55 @@
+/* Copyright (c) 2026 Opus contributors */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#if !defined(MATHOPS_ARM_H)
+# define MATHOPS_ARM_H
+
+# include "cpu_support.h"
+
+# if defined(OPUS_ARM_MAY_HAVE_NEON_INTR) && !defined(DISABLE_FLOAT_API)
+void celt_float2int16_neon(const float * OPUS_RESTRICT in, opus_int16 * OPUS_RESTRICT out, int cnt);
+void celt_int16tofloat_neon(const opus_int16 * OPUS_RESTRICT in, float * OPUS_RESTRICT out, int cnt);
+int celt_limit2_checkwithin1_neon(float *samples, int cnt);
+
+#  if defined(OPUS_HAVE_RTCD) && !defined(OPUS_ARM_PRESUME_NEON_INTR)
+extern void (*const CELT_FLOAT2INT16_IMPL[OPUS_ARCHMASK+1])(const float *in, opus_int16 *out, int cnt);
+extern void (*const CELT_INT16TOFLOAT_IMPL[OPUS_ARCHMASK+1])(const opus_int16 *in, float *out, int cnt);
+extern int (*const CELT_LIMIT2_CHECKWITHIN1_IMPL[OPUS_ARCHMASK+1])(float *samples, int cnt);
+#   define OVERRIDE_FLOAT2INT16 (1)
+#   define OVERRIDE_LIMIT2_CHECKWITHIN1 (1)
+#   define celt_float2int16(in, out, cnt, arch) ((*CELT_FLOAT2INT16_IMPL[(arch)&OPUS_ARCHMASK])(in, out, cnt))
+#   define celt_int16tofloat(in, out, cnt, arch) ((*CELT_INT16TOFLOAT_IMPL[(arch)&OPUS_ARCHMASK])(in, out, cnt))
+#   define celt_limit2_checkwithin1(samples, cnt, arch) ((*CELT_LIMIT2_CHECKWITHIN1_IMPL[(arch)&OPUS_ARCHMASK])(samples, cnt))
+#  elif defined(OPUS_ARM_PRESUME_NEON_INTR)
+#   define OVERRIDE_FLOAT2INT16 (1)
+#   define OVERRIDE_LIMIT2_CHECKWITHIN1 (1)
+#   define celt_float2int16(in, out, cnt, arch) ((void)(arch), celt_float2int16_neon(in, out, cnt))
+#   define celt_int16tofloat(in, out, cnt, arch) ((void)(arch), celt_int16tofloat_neon(in, out, cnt))
+#   define celt_limit2_checkwithin1(samples, cnt, arch) ((void)(arch), celt_limit2_checkwithin1_neon(samples, cnt))
+#  endif
+# endif
+
+#endif
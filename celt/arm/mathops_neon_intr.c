@@ -0,0 +1,110 @@
+/* Copyright (c) 2026 Opus contributors */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <arm_neon.h>
+#include "../mathops.h"
+#include "../float_cast.h"
+
+#ifndef DISABLE_FLOAT_API
+
+/* Same result as FLOAT2INT16() on each sample. The lower clamp is a
+   compare and select like MAX32(), so NaNs saturate to -32768 as in C. The
+   rounding uses the 1.5*2^23 trick, which rounds to nearest even like
+   float2int() on ARMv7 as well, where vcvtq_s32_f32() truncates. */
+void celt_float2int16_neon(const float * OPUS_RESTRICT in, opus_int16 * OPUS_RESTRICT out, int cnt)
+{
+   int i;
+   const float32x4_t min = vdupq_n_f32(-32768.f);
+   const float32x4_t max = vdupq_n_f32(32767.f);
+   const float32x4_t magic = vdupq_n_f32(12582912.f);
+   for (i=0;i<cnt-7;i+=8)
+   {
+      float32x4_t x0, x1;
+      int32x4_t i0, i1;
+      x0 = vmulq_n_f32(vld1q_f32(in+i), CELT_SIG_SCALE);
+      x1 = vmulq_n_f32(vld1q_f32(in+i+4), CELT_SIG_SCALE);
+      x0 = vminq_f32(vbslq_f32(vcgtq_f32(x0, min), x0, min), max);
+      x1 = vminq_f32(vbslq_f32(vcgtq_f32(x1, min), x1, min), max);
+      i0 = vcvtq_s32_f32(vsubq_f32(vaddq_f32(x0, magic), magic));
+      i1 = vcvtq_s32_f32(vsubq_f32(vaddq_f32(x1, magic), magic));
+      vst1q_s16(out+i, vcombine_s16(vmovn_s32(i0), vmovn_s32(i1)));
+   }
+   for (;i<cnt;i++)
+      out[i] = FLOAT2INT16(in[i]);
+}
+
+void celt_int16tofloat_neon(const opus_int16 * OPUS_RESTRICT in, float * OPUS_RESTRICT out, int cnt)
+{
+   int i;
+   for (i=0;i<cnt-7;i+=8)
+   {
+      int16x8_t x = vld1q_s16(in+i);
+      vst1q_f32(out+i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), 1.f/32768.f));
+      vst1q_f32(out+i+4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), 1.f/32768.f));
+   }
+   for (;i<cnt;i++)
+      out[i] = (1.f/32768.f)*in[i];
+}
+
+/* vminq_f32() and vmaxq_f32() return NaN when either operand is a NaN, and
+   vcagtq_f32() is false for it, so NaNs are left in place and count as
+   within +/-1 like in the C version. */
+int celt_limit2_checkwithin1_neon(float *samples, int cnt)
+{
+   int i;
+   int within1;
+   const float32x4_t two = vdupq_n_f32(2.f);
+   const float32x4_t mtwo = vdupq_n_f32(-2.f);
+   const float32x4_t one = vdupq_n_f32(1.f);
+   uint32x4_t over = vdupq_n_u32(0);
+   uint32x2_t over2;
+   for (i=0;i<cnt-7;i+=8)
+   {
+      float32x4_t x0, x1;
+      x0 = vmaxq_f32(mtwo, vminq_f32(two, vld1q_f32(samples+i)));
+      x1 = vmaxq_f32(mtwo, vminq_f32(two, vld1q_f32(samples+i+4)));
+      vst1q_f32(samples+i, x0);
+      vst1q_f32(samples+i+4, x1);
+      over = vorrq_u32(over, vcagtq_f32(x0, one));
+      over = vorrq_u32(over, vcagtq_f32(x1, one));
+   }
+   over2 = vorr_u32(vget_low_u32(over), vget_high_u32(over));
+   within1 = (vget_lane_u32(over2, 0) | vget_lane_u32(over2, 1)) == 0;
+   for (;i<cnt;i++)
+   {
+      float x = MAX16(-2.f, MIN16(2.f, samples[i]));
+      samples[i] = x;
+      if (x > 1 || x < -1)
+         within1 = 0;
+   }
+   return within1;
+}
+
+#endif
@@ -91,70 +91,113 @@ int bitexact_log2tan(int isin,int icos)
 }
 
 #ifdef FIXED_POINT
+void celt_band_sumsq_c(const celt_sig *X, opus_val32 *sum, int *shift,
+      const opus_int16 *eBands, const opus_int16 *logN, int start, int end, int LM)
+{
+   int i, j;
+   for (i=start;i<end;i++)
+   {
+      opus_val32 maxval;
+      opus_val32 s = 0;
+      int sh = 0;
+      maxval = celt_maxabs32(&X[eBands[i]<<LM], (eBands[i+1]-eBands[i])<<LM);
+      if (maxval > 0)
+      {
+         sh = celt_ilog2(maxval) - 14 + (((logN[i]>>BITRES)+LM+1)>>1);
+         for (j=eBands[i]<<LM;j<eBands[i+1]<<LM;j++)
+            s = MAC16_16(s, EXTRACT16(VSHR32(X[j],sh)), EXTRACT16(VSHR32(X[j],sh)));
+      }
+      shift[i] = sh;
+      sum[i] = s;
+   }
+}
+
+void celt_band_normalise_c(const celt_sig * OPUS_RESTRICT freq,
+      celt_norm * OPUS_RESTRICT X, const opus_val16 *g, const int *shift,
+      const opus_int16 *eBands, int start, int end, int M)
+{
+   int i, j;
+   for (i=start;i<end;i++)
+   {
+      for (j=M*eBands[i];j<M*eBands[i+1];j++)
+         X[j] = MULT16_16_Q15(VSHR32(freq[j],shift[i]),g[i]);
+   }
+}
+
+void celt_band_denormalise_c(const celt_norm * OPUS_RESTRICT X,
+      celt_sig * OPUS_RESTRICT freq, const opus_val16 *g, const int *shift,
+      const opus_int16 *eBands, int start, int end, int M)
+{
+   int i, j;
+   for (i=start;i<end;i++)
+   {
+      for (j=M*eBands[i];j<M*eBands[i+1];j++)
+         freq[j] = VSHR32(MULT16_16(X[j],g[i]),shift[i]);
+   }
+}
+
 /* Compute the amplitude (sqrt energy) in each of the bands */
 void compute_band_energies(const CELTMode *m, const celt_sig *X, celt_ener *bandE, int end, int C, int LM, int arch)
 {
    int i, c, N;
    const opus_int16 *eBands = m->eBands;
-   (void)arch;
+   VARDECL(int, shift);
+   VARDECL(opus_val32, sum);
+   SAVE_STACK;
    N = m->shortMdctSize<<LM;
+   ALLOC(shift, m->nbEBands, int);
+   ALLOC(sum, m->nbEBands, opus_val32);
    c=0; do {
+      celt_band_sumsq(X+c*N, sum, shift, eBands, m->logN, 0, end, LM, arch);
       for (i=0;i<end;i++)
       {
-         int j;
-         opus_val32 maxval=0;
-         opus_val32 sum = 0;
-
-         maxval = celt_maxabs32(&X[c*N+(eBands[i]<<LM)], (eBands[i+1]-eBands[i])<<LM);
-         if (maxval > 0)
-         {
-            int shift = celt_ilog2(maxval) - 14 + (((m->logN[i]>>BITRES)+LM+1)>>1);
-            j=eBands[i]<<LM;
-            if (shift>0)
-            {
-               do {
-                  sum = MAC16_16(sum, EXTRACT16(SHR32(X[j+c*N],shift)),
-                        EXTRACT16(SHR32(X[j+c*N],shift)));
-               } while (++j<eBands[i+1]<<LM);
-            } else {
-               do {
-                  sum = MAC16_16(sum, EXTRACT16(SHL32(X[j+c*N],-shift)),
-                        EXTRACT16(SHL32(X[j+c*N],-shift)));
-               } while (++j<eBands[i+1]<<LM);
-            }
-            /* We're adding one here to ensure the normalized band isn't larger than unity norm */
-            bandE[i+c*m->nbEBands] = EPSILON+VSHR32(EXTEND32(celt_sqrt(sum)),-shift);
-         } else {
-            bandE[i+c*m->nbEBands] = EPSILON;
-         }
+         /* We're adding one here to ensure the normalized band isn't larger than unity norm.
+            A silent band has sum[i] = 0 and gets EPSILON. */
+         bandE[i+c*m->nbEBands] = EPSILON+VSHR32(EXTEND32(celt_sqrt(sum[i])),-shift[i]);
          /*printf ("%f ", bandE[i+c*m->nbEBands]);*/
       }
    } while (++c<C);
    /*printf ("\n");*/
+   RESTORE_STACK;
 }
 
 /* Normalise each band such that the energy is one. */
-void normalise_bands(const CELTMode *m, const celt_sig * OPUS_RESTRICT freq, celt_norm * OPUS_RESTRICT X, const celt_ener *bandE, int end, int C, int M)
+void normalise_bands(const CELTMode *m, const celt_sig * OPUS_RESTRICT freq, celt_norm * OPUS_RESTRICT X, const celt_ener *bandE, int end, int C, int M, int arch)
 {
    int i, c, N;
    const opus_int16 *eBands = m->eBands;
+   VARDECL(opus_val16, g);
+   VARDECL(int, shift);
+   SAVE_STACK;
    N = M*m->shortMdctSize;
+   ALLOC(g, m->nbEBands, opus_val16);
+   ALLOC(shift, m->nbEBands, int);
    c=0; do {
       i=0; do {
-         opus_val16 g;
-         int j,shift;
+         int sh;
          opus_val16 E;
-         shift = celt_zlog2(bandE[i+c*m->nbEBands])-13;
-         E = VSHR32(bandE[i+c*m->nbEBands], shift);
-         g = EXTRACT16(celt_rcp(SHL32(E,3)));
-         j=M*eBands[i]; do {
-            X[j+c*N] = MULT16_16_Q15(VSHR32(freq[j+c*N],shift-1),g);
-         } while (++j<M*eBands[i+1]);
+         sh = celt_zlog2(bandE[i+c*m->nbEBands])-13;
+         E = VSHR32(bandE[i+c*m->nbEBands], sh);
+         g[i] = EXTRACT16(celt_rcp(SHL32(E,3)));
+         shift[i] = sh-1;
       } while (++i<end);
+      celt_band_normalise(freq+c*N, X+c*N, g, shift, eBands, 0, end, M, arch);
    } while (++c<C);
+   RESTORE_STACK;
 }
 
 #else /* FIXED_POINT */
+void celt_band_scale_c(const float * OPUS_RESTRICT in, float * OPUS_RESTRICT out,
+      const opus_val16 *g, const opus_int16 *eBands, int start, int end, int M)
+{
+   int i, j;
+   for (i=start;i<end;i++)
+   {
+      for (j=M*eBands[i];j<M*eBands[i+1];j++)
+         out[j] = in[j]*g[i];
+   }
+}
+
 /* Compute the amplitude (sqrt energy) in each of the bands */
 void compute_band_energies(const CELTMode *m, const celt_sig *X, celt_ener *bandE, int end, int C, int LM, int arch)
 {
@@ -174,20 +217,20 @@ void compute_band_energies(const CELTMode *m, const celt_sig *X, celt_ener *band
 }
 
 /* Normalise each band such that the energy is one. */
-void normalise_bands(const CELTMode *m, const celt_sig * OPUS_RESTRICT freq, celt_norm * OPUS_RESTRICT X, const celt_ener *bandE, int end, int C, int M)
+void normalise_bands(const CELTMode *m, const celt_sig * OPUS_RESTRICT freq, celt_norm * OPUS_RESTRICT X, const celt_ener *bandE, int end, int C, int M, int arch)
 {
    int i, c, N;
    const opus_int16 *eBands = m->eBands;
+   VARDECL(opus_val16, g);
+   SAVE_STACK;
    N = M*m->shortMdctSize;
+   ALLOC(g, m->nbEBands, opus_val16);
    c=0; do {
       for (i=0;i<end;i++)
-      {
-         int j;
-         opus_val16 g = 1.f/(1e-27f+bandE[i+c*m->nbEBands]);
-         for (j=M*eBands[i];j<M*eBands[i+1];j++)
-            X[j+c*N] = freq[j+c*N]*g;
-      }
+         g[i] = 1.f/(1e-27f+bandE[i+c*m->nbEBands]);
+      celt_band_scale(freq+c*N, X+c*N, g, eBands, 0, end, M, arch);
    } while (++c<C);
+   RESTORE_STACK;
 }
 
 #endif /* FIXED_POINT */
@@ -195,13 +238,16 @@ void normalise_bands(const CELTMode *m, const celt_sig * OPUS_RESTRICT freq, cel
 /* De-normalise the energy to produce the synthesis from the unit-energy bands */
 void denormalise_bands(const CELTMode *m, const celt_norm * OPUS_RESTRICT X,
       celt_sig * OPUS_RESTRICT freq, const opus_val16 *bandLogE, int start,
-      int end, int M, int downsample, int silence)
+      int end, int M, int downsample, int silence, int arch)
 {
    int i, N;
    int bound;
-   celt_sig * OPUS_RESTRICT f;
-   const celt_norm * OPUS_RESTRICT x;
    const opus_int16 *eBands = m->eBands;
+   VARDECL(opus_val16, g);
+#ifdef FIXED_POINT
+   VARDECL(int, shift);
+#endif
+   SAVE_STACK;
    N = M*m->shortMdctSize;
    bound = M*eBands[end];
    if (downsample!=1)
@@ -211,57 +257,51 @@ void denormalise_bands(const CELTMode *m, const celt_norm * OPUS_RESTRICT X,
       bound = 0;
       start = end = 0;
    }
-   f = freq;
-   x = X+M*eBands[start];
+   ALLOC(g, m->nbEBands, opus_val16);
+#ifdef FIXED_POINT
+   ALLOC(shift, m->nbEBands, int);
+#endif
    for (i=0;i<M*eBands[start];i++)
-      *f++ = 0;
+      freq[i] = 0;
    for (i=start;i<end;i++)
    {
-      int j, band_end;
-      opus_val16 g;
       opus_val16 lg;
-#ifdef FIXED_POINT
-      int shift;
-#endif
-      j=M*eBands[i];
-      band_end = M*eBands[i+1];
       lg = SATURATE16(ADD32(bandLogE[i], SHL32((opus_val32)eMeans[i],6)));
 #ifndef FIXED_POINT
-      g = celt_exp2(MIN32(32.f, lg));
+      g[i] = celt_exp2(MIN32(32.f, lg));
 #else
       /* Handle the integer part of the log energy */
-      shift = 16-(lg>>DB_SHIFT);
-      if (shift>31)
+      shift[i] = 16-(lg>>DB_SHIFT);
+      if (shift[i]>31)
       {
-         shift=0;
-         g=0;
+         shift[i]=0;
+         g[i]=0;
       } else {
          /* Handle the fractional part. */
-         g = celt_exp2_frac(lg&((1<<DB_SHIFT)-1));
+         g[i] = celt_exp2_frac(lg&((1<<DB_SHIFT)-1));
       }
-      /* Handle extreme gains with negative shift. */
-      if (shift<0)
+      /* Handle extreme gains with negative shift. For shift <= -2 and
+         g > 16384 we'd be likely to overflow, so we're capping the gain
+         here, which is equivalent to a cap of 18 on lg. This shouldn't
+         trigger unless the bitstream is already corrupted. */
+      if (shift[i] <= -2)
       {
-         /* For shift <= -2 and g > 16384 we'd be likely to overflow, so we're
-            capping the gain here, which is equivalent to a cap of 18 on lg.
-            This shouldn't trigger unless the bitstream is already corrupted. */
-         if (shift <= -2)
-         {
-            g = 16384;
-            shift = -2;
-         }
-         do {
-            *f++ = SHL32(MULT16_16(*x++, g), -shift);
-         } while (++j<band_end);
-      } else
+         g[i] = 16384;
+         shift[i] = -2;
+      }
 #endif
-         /* Be careful of the fixed-point "else" just above when changing this code */
-         do {
-            *f++ = SHR32(MULT16_16(*x++, g), shift);
-         } while (++j<band_end);
    }
    celt_assert(start <= end);
+   if (start < end)
+   {
+#ifdef FIXED_POINT
+      celt_band_denormalise(X, freq, g, shift, eBands, start, end, M, arch);
+#else
+      celt_band_scale(X, freq, g, eBands, start, end, M, arch);
+#endif
+   }
    OPUS_CLEAR(&freq[bound], N-bound);
+   RESTORE_STACK;
 }
 
 /* This prevents energy collapse for transients with multiple short MDCTs */
@@ -1056,8 +1096,11 @@ static unsigned quant_partition(struct band_ctx *ctx, celt_norm *X,
          if (encode)
          {
             cm = alg_quant(X, N, K, spread, B, ec, gain, ctx->resynth, ctx->arch);
-         } else {
+         } else if (ctx->resynth) {
             cm = alg_unquant(X, N, K, spread, B, ec, gain);
+         } else {
+            /* Band is not reconstructed, only keep the decoder in sync */
+            cm = alg_skip(N, K, B, ec);
          }
       } else {
          /* If there's no pulse, fill the band anyway */
@@ -1097,6 +1140,18 @@ static unsigned quant_partition(struct band_ctx *ctx, celt_norm *X,
                }
                renormalise_vector(X, N, gain, ctx->arch);
             }
+         } else if (!encode) {
+            /* Band is not reconstructed, but the seed and the collapse mask
+               must advance as above for the bands that are. */
+            unsigned cm_mask;
+            cm_mask = (unsigned)(1UL<<B)-1;
+            fill &= cm_mask;
+            if (fill)
+            {
+               for (j=0;j<N;j++)
+                  ctx->seed = celt_lcg_rand(ctx->seed);
+               cm = lowband == NULL ? cm_mask : (unsigned)fill;
+            }
          }
       }
    }
@@ -1187,11 +1242,12 @@ static unsigned quant_band(struct band_ctx *ctx, celt_norm *X,
 
    cm = quant_partition(ctx, X, N, b, B, lowband, LM, gain, fill);
 
-   /* This code is used by the decoder and by the resynthesis-enabled encoder */
-   if (ctx->resynth)
+   /* This code is used by the decoder and by the resynthesis-enabled encoder.
+      Bands the decoder does not reconstruct only update the collapse mask. */
+   if (ctx->resynth || !encode)
    {
       /* Undo the sample reorganization going from time order to frequency order */
-      if (B0>1)
+      if (B0>1 && ctx->resynth)
          interleave_hadamard(X, N_B>>recombine, B0<<recombine, longBlocks);
 
       /* Undo time-freq changes that we did earlier */
@@ -1202,7 +1258,8 @@ static unsigned quant_band(struct band_ctx *ctx, celt_norm *X,
          B >>= 1;
          N_B <<= 1;
          cm |= cm>>B;
-         haar1(X, N_B, B);
+         if (ctx->resynth)
+            haar1(X, N_B, B);
       }
 
       for (k=0;k<recombine;k++)
@@ -1212,12 +1269,13 @@ static unsigned quant_band(struct band_ctx *ctx, celt_norm *X,
                0xC0,0xC3,0xCC,0xCF,0xF0,0xF3,0xFC,0xFF
          };
          cm = bit_deinterleave_table[cm];
-         haar1(X, N0>>k, 1<<k);
+         if (ctx->resynth)
+            haar1(X, N0>>k, 1<<k);
       }
       B<<=recombine;
 
       /* Scale output for later folding */
-      if (lowband_out)
+      if (lowband_out && ctx->resynth)
       {
          int j;
          opus_val16 n;
@@ -1398,7 +1456,7 @@ void quant_all_bands(int encode, const CELTMode *m, int start, int end,
       const celt_ener *bandE, int *pulses, int shortBlocks, int spread,
       int dual_stereo, int intensity, int *tf_res, opus_int32 total_bits,
       opus_int32 balance, ec_ctx *ec, int LM, int codedBands,
-      opus_uint32 *seed, int complexity, int arch, int disable_inv)
+      opus_uint32 *seed, int complexity, int arch, int disable_inv, int resynth_end)
 {
    int i;
    opus_int32 remaining_bits;
@@ -1483,6 +1541,7 @@ void quant_all_bands(int encode, const CELTMode *m, int start, int end,
       int last;
 
       ctx.i = i;
+      ctx.resynth = resynth && i < resynth_end;
       last = (i==end-1);
 
       X = X_+M*eBands[i];
@@ -1519,6 +1578,21 @@ void quant_all_bands(int encode, const CELTMode *m, int start, int end,
 
       tf_change = tf_res[i];
       ctx.tf_change = tf_change;
+      if (i >= resynth_end)
+      {
+         /* The decoder only parses this band. Clear what it would have
+            written, since the N=2 stereo case and folding into the next
+            bands still read it. */
+         OPUS_CLEAR(X, N);
+         if (Y!=NULL)
+            OPUS_CLEAR(Y, N);
+         if (!last)
+         {
+            OPUS_CLEAR(norm+M*eBands[i]-norm_offset, N);
+            if (dual_stereo)
+               OPUS_CLEAR(norm2+M*eBands[i]-norm_offset, N);
+         }
+      }
       if (i>=m->effEBands)
       {
          X=norm;
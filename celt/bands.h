@@ -54,7 +54,7 @@ void compute_band_energies(const CELTMode *m, const celt_sig *X, celt_ener *band
  * @param X Spectrum (returned normalised)
  * @param bandE Square root of the energy for each band
  */
-void normalise_bands(const CELTMode *m, const celt_sig * OPUS_RESTRICT freq, celt_norm * OPUS_RESTRICT X, const celt_ener *bandE, int end, int C, int M);
+void normalise_bands(const CELTMode *m, const celt_sig * OPUS_RESTRICT freq, celt_norm * OPUS_RESTRICT X, const celt_ener *bandE, int end, int C, int M, int arch);
 
 /** Denormalise each band of X to restore full amplitude
  * @param m Mode data
@@ -63,7 +63,53 @@ void normalise_bands(const CELTMode *m, const celt_sig * OPUS_RESTRICT freq, cel
  */
 void denormalise_bands(const CELTMode *m, const celt_norm * OPUS_RESTRICT X,
       celt_sig * OPUS_RESTRICT freq, const opus_val16 *bandE, int start,
-      int end, int M, int downsample, int silence);
+      int end, int M, int downsample, int silence, int arch);
+
+/* Inner loops of the three functions above, run over bands start..end-1 of
+   one channel. Band i covers bins M*eBands[i] to M*eBands[i+1]-1, with
+   M=1<<LM. */
+#ifdef FIXED_POINT
+/** Picks the shift[i] that brings band i of X below 2^15 (0 for a silent
+    band) and returns the energy of the shifted band in sum[i]. */
+void celt_band_sumsq_c(const celt_sig *X, opus_val32 *sum, int *shift,
+      const opus_int16 *eBands, const opus_int16 *logN, int start, int end, int LM);
+
+/** X[j] = MULT16_16_Q15(VSHR32(freq[j],shift[i]),g[i]) */
+void celt_band_normalise_c(const celt_sig * OPUS_RESTRICT freq,
+      celt_norm * OPUS_RESTRICT X, const opus_val16 *g, const int *shift,
+      const opus_int16 *eBands, int start, int end, int M);
+
+/** freq[j] = VSHR32(MULT16_16(X[j],g[i]),shift[i]) */
+void celt_band_denormalise_c(const celt_norm * OPUS_RESTRICT X,
+      celt_sig * OPUS_RESTRICT freq, const opus_val16 *g, const int *shift,
+      const opus_int16 *eBands, int start, int end, int M);
+#else
+/** out[j] = in[j]*g[i] */
+void celt_band_scale_c(const float * OPUS_RESTRICT in, float * OPUS_RESTRICT out,
+      const opus_val16 *g, const opus_int16 *eBands, int start, int end, int M);
+#endif
+
+#if defined(OPUS_X86_MAY_HAVE_SSE2)
+#include "x86/bands_sse.h"
+#endif
+
+#if defined(OPUS_ARM_MAY_HAVE_NEON_INTR)
+#include "arm/bands_arm.h"
+#endif
+
+#ifndef OVERRIDE_CELT_BAND_KERNELS
+#ifdef FIXED_POINT
+#define celt_band_sumsq(X, sum, shift, eBands, logN, start, end, LM, arch) \
+   ((void)(arch), celt_band_sumsq_c(X, sum, shift, eBands, logN, start, end, LM))
+#define celt_band_normalise(freq, X, g, shift, eBands, start, end, M, arch) \
+   ((void)(arch), celt_band_normalise_c(freq, X, g, shift, eBands, start, end, M))
+#define celt_band_denormalise(X, freq, g, shift, eBands, start, end, M, arch) \
+   ((void)(arch), celt_band_denormalise_c(X, freq, g, shift, eBands, start, end, M))
+#else
+#define celt_band_scale(in, out, g, eBands, start, end, M, arch) \
+   ((void)(arch), celt_band_scale_c(in, out, g, eBands, start, end, M))
+#endif
+#endif
 
 #define SPREAD_NONE       (0)
 #define SPREAD_LIGHT      (1)
@@ -102,13 +148,14 @@ void haar1(celt_norm *X, int N0, int stride);
  * @param codedBands Last band to receive bits + 1
  * @param seed Random generator seed
  * @param arch Run-time architecture (see opus_select_arch())
+ * @param resynth_end First band that is only parsed and not reconstructed by the decoder
  */
 void quant_all_bands(int encode, const CELTMode *m, int start, int end,
       celt_norm * X, celt_norm * Y, unsigned char *collapse_masks,
       const celt_ener *bandE, int *pulses, int shortBlocks, int spread,
       int dual_stereo, int intensity, int *tf_res, opus_int32 total_bits,
       opus_int32 balance, ec_ctx *ec, int M, int codedBands, opus_uint32 *seed,
-      int complexity, int arch, int disable_inv);
+      int complexity, int arch, int disable_inv, int resynth_end);
 
 void anti_collapse(const CELTMode *m, celt_norm *X_,
       unsigned char *collapse_masks, int LM, int C, int size, int start,
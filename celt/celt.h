@@ -73,12 +73,20 @@ typedef struct {
    int offset;
 } SILKInfo;
 
+typedef struct {
+   int tf_select;
+   int transient;
+   int spread_decision;
+} CELTFrameInfo;
+
 #define __celt_check_mode_ptr_ptr(ptr) ((ptr) + ((ptr) - (const CELTMode**)(ptr)))
 
 #define __celt_check_analysis_ptr(ptr) ((ptr) + ((ptr) - (const AnalysisInfo*)(ptr)))
 
 #define __celt_check_silkinfo_ptr(ptr) ((ptr) + ((ptr) - (const SILKInfo*)(ptr)))
 
+#define __celt_check_frameinfo_ptr(ptr) ((ptr) + ((ptr) - (CELTFrameInfo*)(ptr)))
+
 /* Encoder/decoder Requests */
 
 
@@ -131,6 +139,10 @@ typedef struct {
 #define CELT_SET_SILK_INFO_REQUEST    10028
 #define CELT_SET_SILK_INFO(x) CELT_SET_SILK_INFO_REQUEST, __celt_check_silkinfo_ptr(x)
 
+/* Decisions made for the last encoded frame */
+#define CELT_GET_FRAME_INFO_REQUEST    10030
+#define CELT_GET_FRAME_INFO(x) CELT_GET_FRAME_INFO_REQUEST, __celt_check_frameinfo_ptr(x)
+
 /* Encoder stuff */
 
 int celt_encoder_get_size(int channels);
@@ -152,6 +164,9 @@ int celt_decoder_init(CELTDecoder *st, opus_int32 sampling_rate, int channels);
 int celt_decode_with_ec(OpusCustomDecoder * OPUS_RESTRICT st, const unsigned char *data,
       int len, opus_val16 * OPUS_RESTRICT pcm, int frame_size, ec_dec *dec, int accum);
 
+int celt_decode_coarse_energy(const CELTMode *mode, const unsigned char *data,
+      int len, int LM, int C, int end, opus_val16 *oldBandE, opus_int32 *level);
+
 #define celt_encoder_ctl opus_custom_encoder_ctl
 #define celt_decoder_ctl opus_custom_decoder_ctl
 
@@ -50,6 +50,7 @@
 #include <stdarg.h>
 #include "celt_lpc.h"
 #include "vq.h"
+#include "profile.h"
 
 /* The maximum pitch lag to allow in the pitch-based PLC. It's possible to save
    CPU time in the PLC pitch search by making this smaller than MAX_PERIOD. The
@@ -82,6 +83,8 @@ struct OpusCustomDecoder {
    int start, end;
    int signalling;
    int disable_inv;
+   int bandlimited;
+   int plc_complexity;
    int arch;
 
    /* Everything beyond this point gets cleared on a reset */
@@ -92,6 +95,7 @@ struct OpusCustomDecoder {
    int last_pitch_index;
    int loss_count;
    int skip_plc;
+   int plc_noise_based;
    int postfilter_period;
    int postfilter_period_old;
    opus_val16 postfilter_gain;
@@ -101,6 +105,10 @@ struct OpusCustomDecoder {
 
    celt_sig preemph_memD[2];
 
+#ifdef ENABLE_PROFILING
+   opus_uint64 profile[OPUS_PROFILE_STAGES];
+#endif
+
    celt_sig _decode_mem[1]; /* Size = channels*(DECODE_BUFFER_SIZE+mode->overlap) */
    /* opus_val16 lpc[],  Size = channels*LPC_ORDER */
    /* opus_val16 oldEBands[], Size = 2*mode->nbEBands */
@@ -215,6 +223,7 @@ OPUS_CUSTOM_NOSTATIC int opus_custom_decoder_init(CELTDecoder *st, const CELTMod
 #else
    st->disable_inv = 0;
 #endif
+   st->plc_complexity = 10;
    st->arch = opus_select_arch();
 
    opus_custom_decoder_ctl(st, OPUS_RESET_STATE);
@@ -404,7 +413,7 @@ void celt_synthesis(const CELTMode *mode, celt_norm *X, celt_sig * out_syn[],
       /* Copying a mono streams to two channels */
       celt_sig *freq2;
       denormalise_bands(mode, X, freq, oldBandE, start, effEnd, M,
-            downsample, silence);
+            downsample, silence, arch);
       /* Store a temporary copy in the output buffer because the IMDCT destroys its input. */
       freq2 = out_syn[1]+overlap/2;
       OPUS_COPY(freq2, freq, N);
@@ -418,10 +427,10 @@ void celt_synthesis(const CELTMode *mode, celt_norm *X, celt_sig * out_syn[],
       celt_sig *freq2;
       freq2 = out_syn[0]+overlap/2;
       denormalise_bands(mode, X, freq, oldBandE, start, effEnd, M,
-            downsample, silence);
+            downsample, silence, arch);
       /* Use the output buffer as temp array before downmixing. */
       denormalise_bands(mode, X+N, freq2, oldBandE+nbEBands, start, effEnd, M,
-            downsample, silence);
+            downsample, silence, arch);
       for (i=0;i<N;i++)
          freq[i] = ADD32(HALF32(freq[i]), HALF32(freq2[i]));
       for (b=0;b<B;b++)
@@ -430,7 +439,7 @@ void celt_synthesis(const CELTMode *mode, celt_norm *X, celt_sig * out_syn[],
       /* Normal case (mono or stereo) */
       c=0; do {
          denormalise_bands(mode, X+c*N, freq, oldBandE+c*nbEBands, start, effEnd, M,
-               downsample, silence);
+               downsample, silence, arch);
          for (b=0;b<B;b++)
             clt_mdct_backward(&mode->mdct, &freq[b], out_syn[c]+NB*b, mode->window, overlap, shift, B, arch);
       } while (++c<CC);
@@ -514,6 +523,7 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
    int start;
    int loss_count;
    int noise_based;
+   int plc_pitch=0;
    const opus_int16 *eBands;
    SAVE_STACK;
 
@@ -535,6 +545,25 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
    loss_count = st->loss_count;
    start = st->start;
    noise_based = loss_count >= 5 || start != 0 || st->skip_plc;
+   if (!noise_based && loss_count == 0 && st->plc_complexity < 5)
+   {
+      /* Skip the pitch search and reuse the post-filter period of the last
+         good frame (or a multiple of it). Without one, fall back to noise. */
+      if (st->plc_complexity > 0 && st->postfilter_gain > 0)
+      {
+         plc_pitch = st->postfilter_period;
+         while (plc_pitch < PLC_PITCH_LAG_MIN)
+            plc_pitch <<= 1;
+      }
+      if (plc_pitch == 0 || plc_pitch > PLC_PITCH_LAG_MAX)
+         noise_based = 1;
+   }
+   /* The pitch-based PLC continues from the pitch and LPC of the first lost
+      frame, so keep the choice made there for the rest of the burst. */
+   if (loss_count == 0)
+      st->plc_noise_based = noise_based;
+   else
+      noise_based |= st->plc_noise_based;
    if (noise_based)
    {
       /* Noise-based PLC/CNG */
@@ -604,7 +633,9 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
 
       if (loss_count == 0)
       {
-         st->last_pitch_index = pitch_index = celt_plc_pitch_search(decode_mem, C, st->arch);
+         if (plc_pitch == 0)
+            plc_pitch = celt_plc_pitch_search(decode_mem, C, st->arch);
+         st->last_pitch_index = pitch_index = plc_pitch;
       } else {
          pitch_index = st->last_pitch_index;
          fade = QCONST16(.8f,15);
@@ -849,6 +880,7 @@ int celt_decode_with_ec(CELTDecoder * OPUS_RESTRICT st, const unsigned char *dat
    int start;
    int end;
    int effEnd;
+   int resynth_end;
    int codedBands;
    int alloc_trim;
    int postfilter_pitch;
@@ -932,10 +964,21 @@ int celt_decode_with_ec(CELTDecoder * OPUS_RESTRICT st, const unsigned char *dat
    if (effEnd > mode->effEBands)
       effEnd = mode->effEBands;
 
+   /* In band-limited mode, bands entirely above the Nyquist frequency of the
+      output are only parsed, since denormalise_bands() would discard them. */
+   resynth_end = end;
+   if (st->bandlimited && st->downsample > 1)
+   {
+      while (resynth_end > start && M*eBands[resynth_end-1] >= N/st->downsample)
+         resynth_end--;
+      effEnd = IMIN(effEnd, resynth_end);
+   }
+
    if (data == NULL || len<=1)
    {
-      celt_decode_lost(st, N, LM);
-      deemphasis(out_syn, pcm, N, CC, st->downsample, mode->preemph, st->preemph_memD, accum);
+      OPUS_PROFILE(st->profile, OPUS_PROFILE_DEC_PLC, celt_decode_lost(st, N, LM));
+      OPUS_PROFILE(st->profile, OPUS_PROFILE_DEC_CELT_SYNTHESIS,
+            deemphasis(out_syn, pcm, N, CC, st->downsample, mode->preemph, st->preemph_memD, accum));
       RESTORE_STACK;
       return frame_size/st->downsample;
    }
@@ -1006,8 +1049,9 @@ int celt_decode_with_ec(CELTDecoder * OPUS_RESTRICT st, const unsigned char *dat
    /* Decode the global flags (first symbols in the stream) */
    intra_ener = tell+3<=total_bits ? ec_dec_bit_logp(dec, 3) : 0;
    /* Get band energies */
-   unquant_coarse_energy(mode, start, end, oldBandE,
-         intra_ener, dec, C, LM);
+   OPUS_PROFILE(st->profile, OPUS_PROFILE_DEC_CELT_UNQUANT,
+         unquant_coarse_energy(mode, start, end, oldBandE,
+            intra_ener, dec, C, LM));
 
    ALLOC(tf_res, nbEBands, int);
    tf_decode(start, end, isTransient, tf_res, LM, dec);
@@ -1069,7 +1113,8 @@ int celt_decode_with_ec(CELTDecoder * OPUS_RESTRICT st, const unsigned char *dat
          alloc_trim, &intensity, &dual_stereo, bits, &balance, pulses,
          fine_quant, fine_priority, C, LM, dec, 0, 0, 0);
 
-   unquant_fine_energy(mode, start, end, oldBandE, fine_quant, dec, C);
+   OPUS_PROFILE(st->profile, OPUS_PROFILE_DEC_CELT_UNQUANT,
+         unquant_fine_energy(mode, start, end, oldBandE, fine_quant, dec, C));
 
    c=0; do {
       OPUS_MOVE(decode_mem[c], decode_mem[c]+N, DECODE_BUFFER_SIZE-N+overlap/2);
@@ -1086,22 +1131,24 @@ int celt_decode_with_ec(CELTDecoder * OPUS_RESTRICT st, const unsigned char *dat
    ALLOC(X, C*N, celt_norm);   /**< Interleaved normalised MDCTs */
 #endif
 
-   quant_all_bands(0, mode, start, end, X, C==2 ? X+N : NULL, collapse_masks,
-         NULL, pulses, shortBlocks, spread_decision, dual_stereo, intensity, tf_res,
-         len*(8<<BITRES)-anti_collapse_rsv, balance, dec, LM, codedBands, &st->rng, 0,
-         st->arch, st->disable_inv);
+   OPUS_PROFILE(st->profile, OPUS_PROFILE_DEC_CELT_UNQUANT,
+         quant_all_bands(0, mode, start, end, X, C==2 ? X+N : NULL, collapse_masks,
+            NULL, pulses, shortBlocks, spread_decision, dual_stereo, intensity, tf_res,
+            len*(8<<BITRES)-anti_collapse_rsv, balance, dec, LM, codedBands, &st->rng, 0,
+            st->arch, st->disable_inv, resynth_end));
 
    if (anti_collapse_rsv > 0)
    {
       anti_collapse_on = ec_dec_bits(dec, 1);
    }
 
-   unquant_energy_finalise(mode, start, end, oldBandE,
-         fine_quant, fine_priority, len*8-ec_tell(dec), dec, C);
+   OPUS_PROFILE(st->profile, OPUS_PROFILE_DEC_CELT_UNQUANT,
+         unquant_energy_finalise(mode, start, end, oldBandE,
+            fine_quant, fine_priority, len*8-ec_tell(dec), dec, C));
 
    if (anti_collapse_on)
       anti_collapse(mode, X, collapse_masks, LM, C, N,
-            start, end, oldBandE, oldLogE, oldLogE2, pulses, st->rng, st->arch);
+            start, resynth_end, oldBandE, oldLogE, oldLogE2, pulses, st->rng, st->arch);
 
    if (silence)
    {
@@ -1109,19 +1156,22 @@ int celt_decode_with_ec(CELTDecoder * OPUS_RESTRICT st, const unsigned char *dat
          oldBandE[i] = -QCONST16(28.f,DB_SHIFT);
    }
 
-   celt_synthesis(mode, X, out_syn, oldBandE, start, effEnd,
-                  C, CC, isTransient, LM, st->downsample, silence, st->arch);
+   OPUS_PROFILE(st->profile, OPUS_PROFILE_DEC_CELT_SYNTHESIS,
+         celt_synthesis(mode, X, out_syn, oldBandE, start, effEnd,
+                        C, CC, isTransient, LM, st->downsample, silence, st->arch));
 
    c=0; do {
       st->postfilter_period=IMAX(st->postfilter_period, COMBFILTER_MINPERIOD);
       st->postfilter_period_old=IMAX(st->postfilter_period_old, COMBFILTER_MINPERIOD);
-      comb_filter(out_syn[c], out_syn[c], st->postfilter_period_old, st->postfilter_period, mode->shortMdctSize,
-            st->postfilter_gain_old, st->postfilter_gain, st->postfilter_tapset_old, st->postfilter_tapset,
-            mode->window, overlap, st->arch);
+      OPUS_PROFILE(st->profile, OPUS_PROFILE_DEC_CELT_SYNTHESIS,
+            comb_filter(out_syn[c], out_syn[c], st->postfilter_period_old, st->postfilter_period, mode->shortMdctSize,
+               st->postfilter_gain_old, st->postfilter_gain, st->postfilter_tapset_old, st->postfilter_tapset,
+               mode->window, overlap, st->arch));
       if (LM!=0)
-         comb_filter(out_syn[c]+mode->shortMdctSize, out_syn[c]+mode->shortMdctSize, st->postfilter_period, postfilter_pitch, N-mode->shortMdctSize,
-               st->postfilter_gain, postfilter_gain, st->postfilter_tapset, postfilter_tapset,
-               mode->window, overlap, st->arch);
+         OPUS_PROFILE(st->profile, OPUS_PROFILE_DEC_CELT_SYNTHESIS,
+               comb_filter(out_syn[c]+mode->shortMdctSize, out_syn[c]+mode->shortMdctSize, st->postfilter_period, postfilter_pitch, N-mode->shortMdctSize,
+                  st->postfilter_gain, postfilter_gain, st->postfilter_tapset, postfilter_tapset,
+                  mode->window, overlap, st->arch));
 
    } while (++c<CC);
    st->postfilter_period_old = st->postfilter_period;
@@ -1174,7 +1224,8 @@ int celt_decode_with_ec(CELTDecoder * OPUS_RESTRICT st, const unsigned char *dat
    } while (++c<2);
    st->rng = dec->rng;
 
-   deemphasis(out_syn, pcm, N, CC, st->downsample, mode->preemph, st->preemph_memD, accum);
+   OPUS_PROFILE(st->profile, OPUS_PROFILE_DEC_CELT_SYNTHESIS,
+         deemphasis(out_syn, pcm, N, CC, st->downsample, mode->preemph, st->preemph_memD, accum));
    st->loss_count = 0;
    RESTORE_STACK;
    if (ec_tell(dec) > 8*len)
@@ -1184,6 +1235,135 @@ int celt_decode_with_ec(CELTDecoder * OPUS_RESTRICT st, const unsigned char *dat
    return frame_size/st->downsample;
 }
 
+/* Log2 amplitude response of the de-emphasis filter at the centre of each
+   band of the standard 48 kHz mode, used to undo the pre-emphasis when
+   estimating the signal level. */
+static const opus_val16 deemph_logE[21] = {
+   QCONST16(2.73f,DB_SHIFT), QCONST16(2.70f,DB_SHIFT), QCONST16(2.63f,DB_SHIFT), QCONST16(2.54f,DB_SHIFT), QCONST16(2.43f,DB_SHIFT), QCONST16(2.32f,DB_SHIFT), QCONST16(2.20f,DB_SHIFT),
+   QCONST16(2.09f,DB_SHIFT), QCONST16(1.92f,DB_SHIFT), QCONST16(1.72f,DB_SHIFT), QCONST16(1.53f,DB_SHIFT), QCONST16(1.36f,DB_SHIFT), QCONST16(1.13f,DB_SHIFT), QCONST16(0.88f,DB_SHIFT),
+   QCONST16(0.66f,DB_SHIFT), QCONST16(0.43f,DB_SHIFT), QCONST16(0.20f,DB_SHIFT), QCONST16(-0.02f,DB_SHIFT), QCONST16(-0.27f,DB_SHIFT), QCONST16(-0.54f,DB_SHIFT), QCONST16(-0.77f,DB_SHIFT)
+};
+
+/* Decodes only the side information up to and including the coarse band
+   energies of a frame, skipping fine energy, PVQ, and synthesis. oldBandE
+   holds the energies of the previous frame (in the same layout as the
+   decoder) and is updated in place. The estimated level of the frame is
+   returned in Q8 dB relative to full scale. Returns 1 for a silence frame. */
+int celt_decode_coarse_energy(const CELTMode *mode, const unsigned char *data,
+      int len, int LM, int C, int end, opus_val16 *oldBandE, opus_int32 *level)
+{
+   int c, i;
+   int silence;
+   int intra_ener;
+   int nbEBands;
+   opus_int32 tell;
+   opus_int32 total_bits;
+   opus_val16 maxE;
+   opus_val32 sum;
+   opus_val16 logE;
+   ec_dec dec;
+
+   nbEBands = mode->nbEBands;
+   ec_dec_init(&dec, (unsigned char*)data, len);
+
+   if (C==1)
+   {
+      for (i=0;i<nbEBands;i++)
+         oldBandE[i]=MAX16(oldBandE[i],oldBandE[nbEBands+i]);
+   }
+
+   total_bits = len*8;
+   tell = ec_tell(&dec);
+   if (tell >= total_bits)
+      silence = 1;
+   else if (tell==1)
+      silence = ec_dec_bit_logp(&dec, 15);
+   else
+      silence = 0;
+
+   if (silence)
+   {
+      for (i=0;i<C*nbEBands;i++)
+         oldBandE[i] = -QCONST16(28.f,DB_SHIFT);
+   } else {
+      /* Skip the post-filter parameters and the transient flag. */
+      if (tell+16 <= total_bits)
+      {
+         if(ec_dec_bit_logp(&dec, 1))
+         {
+            int octave;
+            octave = ec_dec_uint(&dec, 6);
+            ec_dec_bits(&dec, 4+octave);
+            ec_dec_bits(&dec, 3);
+            if (ec_tell(&dec)+2<=total_bits)
+               ec_dec_icdf(&dec, tapset_icdf, 2);
+         }
+         tell = ec_tell(&dec);
+      }
+      if (LM > 0 && tell+3 <= total_bits)
+      {
+         ec_dec_bit_logp(&dec, 3);
+         tell = ec_tell(&dec);
+      }
+      intra_ener = tell+3<=total_bits ? ec_dec_bit_logp(&dec, 3) : 0;
+      unquant_coarse_energy(mode, 0, end, oldBandE, intra_ener, &dec, C, LM);
+   }
+   c=0; do {
+      for (i=end;i<nbEBands;i++)
+         oldBandE[c*nbEBands+i]=0;
+   } while (++c<2);
+   if (C==1)
+      OPUS_COPY(&oldBandE[nbEBands], oldBandE, nbEBands);
+
+   /* Sum the band energies relative to the loudest band so that the sum
+      cannot overflow in fixed-point. */
+   maxE = -QCONST16(28.f,DB_SHIFT);
+   c=0; do {
+      for (i=0;i<end;i++)
+      {
+#ifdef FIXED_POINT
+         opus_val16 lg = ADD16(oldBandE[c*nbEBands+i], SHL16((opus_val16)eMeans[i],6));
+         if (nbEBands==21)
+            lg = ADD16(lg, deemph_logE[i]);
+#else
+         opus_val16 lg = oldBandE[c*nbEBands+i] + eMeans[i];
+         if (nbEBands==21)
+            lg += deemph_logE[i];
+#endif
+         maxE = MAX16(maxE, lg);
+      }
+   } while (++c<C);
+   sum = 0;
+   c=0; do {
+      for (i=0;i<end;i++)
+      {
+#ifdef FIXED_POINT
+         opus_val16 lg = ADD16(oldBandE[c*nbEBands+i], SHL16((opus_val16)eMeans[i],6));
+         if (nbEBands==21)
+            lg = ADD16(lg, deemph_logE[i]);
+         sum += celt_exp2(MAX16(-QCONST16(15.f,DB_SHIFT), SHL16(SUB16(lg, maxE), 1)));
+#else
+         opus_val16 lg = oldBandE[c*nbEBands+i] + eMeans[i];
+         if (nbEBands==21)
+            lg += deemph_logE[i];
+         sum += celt_exp2(2*(lg-maxE));
+#endif
+      }
+   } while (++c<C);
+   /* Log2 of the RMS amplitude of the MDCT coefficients. */
+#ifdef FIXED_POINT
+   logE = ADD16(maxE, SHR16(SUB16(celt_log2(sum), QCONST16(16.f,DB_SHIFT)), 1));
+   logE = SUB16(logE, SHR16(celt_log2(C*mode->shortMdctSize<<LM), 1));
+   /* 6.0206 dB per unit of log2 amplitude, in Q8. The offset maps the MDCT
+      domain back to the level of the time-domain signal. */
+   *level = (opus_int32)SHR32(MULT16_16(logE, 1541), DB_SHIFT) - QCONST16(63.5f, 8);
+#else
+   logE = maxE + .5f*celt_log2(sum) - .5f*celt_log2((float)(C*mode->shortMdctSize<<LM));
+   *level = (opus_int32)floor(.5f + 256.f*(6.0206f*logE - 63.5f));
+#endif
+   return silence;
+}
+
 
 #ifdef CUSTOM_MODES
 
@@ -1196,7 +1376,7 @@ int opus_custom_decode(CELTDecoder * OPUS_RESTRICT st, const unsigned char *data
 #ifndef DISABLE_FLOAT_API
 int opus_custom_decode_float(CELTDecoder * OPUS_RESTRICT st, const unsigned char *data, int len, float * OPUS_RESTRICT pcm, int frame_size)
 {
-   int j, ret, C, N;
+   int ret, C, N;
    VARDECL(opus_int16, out);
    ALLOC_STACK;
 
@@ -1209,8 +1389,7 @@ int opus_custom_decode_float(CELTDecoder * OPUS_RESTRICT st, const unsigned char
    ALLOC(out, C*N, opus_int16);
    ret=celt_decode_with_ec(st, data, len, out, frame_size, NULL, 0);
    if (ret>0)
-      for (j=0;j<C*ret;j++)
-         pcm[j]=out[j]*(1.f/32768.f);
+      celt_int16tofloat(out, pcm, C*ret, st->arch);
 
    RESTORE_STACK;
    return ret;
@@ -1226,7 +1405,7 @@ int opus_custom_decode_float(CELTDecoder * OPUS_RESTRICT st, const unsigned char
 
 int opus_custom_decode(CELTDecoder * OPUS_RESTRICT st, const unsigned char *data, int len, opus_int16 * OPUS_RESTRICT pcm, int frame_size)
 {
-   int j, ret, C, N;
+   int ret, C, N;
    VARDECL(celt_sig, out);
    ALLOC_STACK;
 
@@ -1240,8 +1419,7 @@ int opus_custom_decode(CELTDecoder * OPUS_RESTRICT st, const unsigned char *data
    ret=celt_decode_with_ec(st, data, len, out, frame_size, NULL, 0);
 
    if (ret>0)
-      for (j=0;j<C*ret;j++)
-         pcm[j] = FLOAT2INT16 (out[j]);
+      celt_float2int16(out, pcm, C*ret, st->arch);
 
    RESTORE_STACK;
    return ret;
@@ -1344,6 +1522,16 @@ int opus_custom_decoder_ctl(CELTDecoder * OPUS_RESTRICT st, int request, ...)
          *value=st->rng;
       }
       break;
+#ifdef ENABLE_PROFILING
+      case OPUS_GET_PROFILE_REQUEST:
+      {
+         opus_uint64 * value = va_arg(ap, opus_uint64 *);
+         if (value==0)
+            goto bad_arg;
+         OPUS_COPY(value, st->profile, OPUS_PROFILE_STAGES);
+      }
+      break;
+#endif
       case OPUS_SET_PHASE_INVERSION_DISABLED_REQUEST:
       {
           opus_int32 value = va_arg(ap, opus_int32);
@@ -1364,6 +1552,46 @@ int opus_custom_decoder_ctl(CELTDecoder * OPUS_RESTRICT st, int request, ...)
           *value = st->disable_inv;
       }
       break;
+      case OPUS_SET_BANDLIMITED_DECODE_REQUEST:
+      {
+          opus_int32 value = va_arg(ap, opus_int32);
+          if(value<0 || value>1)
+          {
+             goto bad_arg;
+          }
+          st->bandlimited = value;
+      }
+      break;
+      case OPUS_GET_BANDLIMITED_DECODE_REQUEST:
+      {
+          opus_int32 *value = va_arg(ap, opus_int32*);
+          if (!value)
+          {
+             goto bad_arg;
+          }
+          *value = st->bandlimited;
+      }
+      break;
+      case OPUS_SET_PLC_COMPLEXITY_REQUEST:
+      {
+          opus_int32 value = va_arg(ap, opus_int32);
+          if(value<0 || value>10)
+          {
+             goto bad_arg;
+          }
+          st->plc_complexity = value;
+      }
+      break;
+      case OPUS_GET_PLC_COMPLEXITY_REQUEST:
+      {
+          opus_int32 *value = va_arg(ap, opus_int32*);
+          if (!value)
+          {
+             goto bad_arg;
+          }
+          *value = st->plc_complexity;
+      }
+      break;
       default:
          goto bad_request;
    }
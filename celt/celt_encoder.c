@@ -50,6 +50,7 @@
 #include <stdarg.h>
 #include "celt_lpc.h"
 #include "vq.h"
+#include "profile.h"
 
 
 /** Encoder state
@@ -97,6 +98,8 @@ struct OpusCustomEncoder {
    int prefilter_tapset_old;
 #endif
    int consec_transient;
+   int last_tf_select;
+   int last_transient;
    AnalysisInfo analysis;
    SILKInfo silk_info;
 
@@ -114,6 +117,10 @@ struct OpusCustomEncoder {
    opus_val16 *energy_mask;
    opus_val16 spec_avg;
 
+#ifdef ENABLE_PROFILING
+   opus_uint64 profile[OPUS_PROFILE_STAGES];
+#endif
+
 #ifdef RESYNTH
    /* +MAX_PERIOD/2 to make space for overlap */
    celt_sig syn_mem[2][2*MAX_PERIOD+MAX_PERIOD/2];
@@ -1696,8 +1703,9 @@ int celt_encode_with_ec(CELTEncoder * OPUS_RESTRICT st, const opus_val16 * pcm,
          in hybrid mode. It seems like we still want to have real transients on vowels
          though (small SILK quantization offset value). */
       int allow_weak_transients = hybrid && effectiveBytes<15 && st->silk_info.signalType != 2;
-      isTransient = transient_analysis(in, N+overlap, CC,
-            &tf_estimate, &tf_chan, allow_weak_transients, &weak_transient);
+      OPUS_PROFILE(st->profile, OPUS_PROFILE_ENC_CELT_TRANSIENT,
+            isTransient = transient_analysis(in, N+overlap, CC,
+               &tf_estimate, &tf_chan, allow_weak_transients, &weak_transient));
    }
    if (LM>0 && ec_tell(enc)+3<=total_bits)
    {
@@ -1716,14 +1724,16 @@ int celt_encode_with_ec(CELTEncoder * OPUS_RESTRICT st, const opus_val16 * pcm,
    ALLOC(bandLogE2, C*nbEBands, opus_val16);
    if (secondMdct)
    {
-      compute_mdcts(mode, 0, in, freq, C, CC, LM, st->upsample, st->arch);
+      OPUS_PROFILE(st->profile, OPUS_PROFILE_ENC_CELT_MDCT,
+            compute_mdcts(mode, 0, in, freq, C, CC, LM, st->upsample, st->arch));
       compute_band_energies(mode, freq, bandE, effEnd, C, LM, st->arch);
       amp2Log2(mode, effEnd, end, bandE, bandLogE2, C);
       for (i=0;i<C*nbEBands;i++)
          bandLogE2[i] += HALF16(SHL16(LM, DB_SHIFT));
    }
 
-   compute_mdcts(mode, shortBlocks, in, freq, C, CC, LM, st->upsample, st->arch);
+   OPUS_PROFILE(st->profile, OPUS_PROFILE_ENC_CELT_MDCT,
+         compute_mdcts(mode, shortBlocks, in, freq, C, CC, LM, st->upsample, st->arch));
    /* This should catch any NaN in the CELT input. Since we're not supposed to see any (they're filtered
       at the Opus layer), just abort. */
    celt_assert(!celt_isnan(freq[0]) && (C==1 || !celt_isnan(freq[N])));
@@ -1852,7 +1862,8 @@ int celt_encode_with_ec(CELTEncoder * OPUS_RESTRICT st, const opus_val16 * pcm,
       {
          isTransient = 1;
          shortBlocks = M;
-         compute_mdcts(mode, shortBlocks, in, freq, C, CC, LM, st->upsample, st->arch);
+         OPUS_PROFILE(st->profile, OPUS_PROFILE_ENC_CELT_MDCT,
+               compute_mdcts(mode, shortBlocks, in, freq, C, CC, LM, st->upsample, st->arch));
          compute_band_energies(mode, freq, bandE, effEnd, C, LM, st->arch);
          amp2Log2(mode, effEnd, end, bandE, bandLogE, C);
          /* Compensate for the scaling of short vs long mdcts */
@@ -1868,7 +1879,7 @@ int celt_encode_with_ec(CELTEncoder * OPUS_RESTRICT st, const opus_val16 * pcm,
    ALLOC(X, C*N, celt_norm);         /**< Interleaved normalised MDCTs */
 
    /* Band normalisation */
-   normalise_bands(mode, freq, X, bandE, effEnd, C, M);
+   normalise_bands(mode, freq, X, bandE, effEnd, C, M, st->arch);
 
    enable_tf_analysis = effectiveBytes>=15*C && !hybrid && st->complexity>=2 && !st->lfe;
 
@@ -1876,9 +1887,10 @@ int celt_encode_with_ec(CELTEncoder * OPUS_RESTRICT st, const opus_val16 * pcm,
    ALLOC(importance, nbEBands, int);
    ALLOC(spread_weight, nbEBands, int);
 
-   maxDepth = dynalloc_analysis(bandLogE, bandLogE2, nbEBands, start, end, C, offsets,
-         st->lsb_depth, mode->logN, isTransient, st->vbr, st->constrained_vbr,
-         eBands, LM, effectiveBytes, &tot_boost, st->lfe, surround_dynalloc, &st->analysis, importance, spread_weight);
+   OPUS_PROFILE(st->profile, OPUS_PROFILE_ENC_CELT_DYNALLOC,
+         maxDepth = dynalloc_analysis(bandLogE, bandLogE2, nbEBands, start, end, C, offsets,
+            st->lsb_depth, mode->logN, isTransient, st->vbr, st->constrained_vbr,
+            eBands, LM, effectiveBytes, &tot_boost, st->lfe, surround_dynalloc, &st->analysis, importance, spread_weight));
 
    ALLOC(tf_res, nbEBands, int);
    /* Disable variable tf resolution for hybrid and at very low bitrate */
@@ -1886,7 +1898,8 @@ int celt_encode_with_ec(CELTEncoder * OPUS_RESTRICT st, const opus_val16 * pcm,
    {
       int lambda;
       lambda = IMAX(80, 20480/effectiveBytes + 2);
-      tf_select = tf_analysis(mode, effEnd, isTransient, tf_res, lambda, X, N, LM, tf_estimate, tf_chan, importance);
+      OPUS_PROFILE(st->profile, OPUS_PROFILE_ENC_CELT_TF,
+            tf_select = tf_analysis(mode, effEnd, isTransient, tf_res, lambda, X, N, LM, tf_estimate, tf_chan, importance));
       for (i=effEnd;i<end;i++)
          tf_res[i] = tf_res[effEnd-1];
    } else if (hybrid && weak_transient)
@@ -1923,10 +1936,11 @@ int celt_encode_with_ec(CELTEncoder * OPUS_RESTRICT st, const opus_val16 * pcm,
          }
       }
    } while (++c < C);
-   quant_coarse_energy(mode, start, end, effEnd, bandLogE,
-         oldBandE, total_bits, error, enc,
-         C, LM, nbAvailableBytes, st->force_intra,
-         &st->delayedIntra, st->complexity >= 4, st->loss_rate, st->lfe);
+   OPUS_PROFILE(st->profile, OPUS_PROFILE_ENC_RANGE_CODING,
+         quant_coarse_energy(mode, start, end, effEnd, bandLogE,
+            oldBandE, total_bits, error, enc,
+            C, LM, nbAvailableBytes, st->force_intra,
+            &st->delayedIntra, st->complexity >= 4, st->loss_rate, st->lfe));
 
    tf_encode(start, end, isTransient, tf_res, LM, tf_select, enc);
 
@@ -2199,14 +2213,16 @@ int celt_encode_with_ec(CELTEncoder * OPUS_RESTRICT st, const opus_val16 * pcm,
    else
       st->lastCodedBands = codedBands;
 
-   quant_fine_energy(mode, start, end, oldBandE, error, fine_quant, enc, C);
+   OPUS_PROFILE(st->profile, OPUS_PROFILE_ENC_RANGE_CODING,
+         quant_fine_energy(mode, start, end, oldBandE, error, fine_quant, enc, C));
 
    /* Residual quantisation */
    ALLOC(collapse_masks, C*nbEBands, unsigned char);
-   quant_all_bands(1, mode, start, end, X, C==2 ? X+N : NULL, collapse_masks,
-         bandE, pulses, shortBlocks, st->spread_decision,
-         dual_stereo, st->intensity, tf_res, nbCompressedBytes*(8<<BITRES)-anti_collapse_rsv,
-         balance, enc, LM, codedBands, &st->rng, st->complexity, st->arch, st->disable_inv);
+   OPUS_PROFILE(st->profile, OPUS_PROFILE_ENC_CELT_BANDS,
+         quant_all_bands(1, mode, start, end, X, C==2 ? X+N : NULL, collapse_masks,
+            bandE, pulses, shortBlocks, st->spread_decision,
+            dual_stereo, st->intensity, tf_res, nbCompressedBytes*(8<<BITRES)-anti_collapse_rsv,
+            balance, enc, LM, codedBands, &st->rng, st->complexity, st->arch, st->disable_inv, end));
 
    if (anti_collapse_rsv > 0)
    {
@@ -2216,7 +2232,8 @@ int celt_encode_with_ec(CELTEncoder * OPUS_RESTRICT st, const opus_val16 * pcm,
 #endif
       ec_enc_bits(enc, anti_collapse_on, 1);
    }
-   quant_energy_finalise(mode, start, end, oldBandE, error, fine_quant, fine_priority, nbCompressedBytes*8-ec_tell(enc), enc, C);
+   OPUS_PROFILE(st->profile, OPUS_PROFILE_ENC_RANGE_CODING,
+         quant_energy_finalise(mode, start, end, oldBandE, error, fine_quant, fine_priority, nbCompressedBytes*8-ec_tell(enc), enc, C));
    OPUS_CLEAR(energyError, nbEBands*CC);
    c=0;
    do {
@@ -2317,11 +2334,13 @@ int celt_encode_with_ec(CELTEncoder * OPUS_RESTRICT st, const opus_val16 * pcm,
       st->consec_transient++;
    else
       st->consec_transient=0;
+   st->last_tf_select = tf_select;
+   st->last_transient = isTransient;
    st->rng = enc->rng;
 
    /* If there's any room left (can only happen for very high rates),
       it's already filled with zeros */
-   ec_enc_done(enc);
+   OPUS_PROFILE(st->profile, OPUS_PROFILE_ENC_RANGE_CODING, ec_enc_done(enc));
 
 #ifdef CUSTOM_MODES
    if (st->signalling)
@@ -2347,7 +2366,10 @@ int opus_custom_encode(CELTEncoder * OPUS_RESTRICT st, const opus_int16 * pcm, i
 #ifndef DISABLE_FLOAT_API
 int opus_custom_encode_float(CELTEncoder * OPUS_RESTRICT st, const float * pcm, int frame_size, unsigned char *compressed, int nbCompressedBytes)
 {
-   int j, ret, C, N;
+   int ret, C, N;
+#ifdef RESYNTH
+   int j;
+#endif
    VARDECL(opus_int16, in);
    ALLOC_STACK;
 
@@ -2358,8 +2380,7 @@ int opus_custom_encode_float(CELTEncoder * OPUS_RESTRICT st, const float * pcm,
    N = frame_size;
    ALLOC(in, C*N, opus_int16);
 
-   for (j=0;j<C*N;j++)
-     in[j] = FLOAT2INT16(pcm[j]);
+   celt_float2int16(pcm, in, C*N, st->arch);
 
    ret=celt_encode_with_ec(st,in,frame_size,compressed,nbCompressedBytes, NULL);
 #ifdef RESYNTH
@@ -2374,7 +2395,10 @@ int opus_custom_encode_float(CELTEncoder * OPUS_RESTRICT st, const float * pcm,
 
 int opus_custom_encode(CELTEncoder * OPUS_RESTRICT st, const opus_int16 * pcm, int frame_size, unsigned char *compressed, int nbCompressedBytes)
 {
-   int j, ret, C, N;
+   int ret, C, N;
+#ifdef RESYNTH
+   int j;
+#endif
    VARDECL(celt_sig, in);
    ALLOC_STACK;
 
@@ -2384,9 +2408,7 @@ int opus_custom_encode(CELTEncoder * OPUS_RESTRICT st, const opus_int16 * pcm, i
    C=st->channels;
    N=frame_size;
    ALLOC(in, C*N, celt_sig);
-   for (j=0;j<C*N;j++) {
-     in[j] = SCALEOUT(pcm[j]);
-   }
+   celt_int16tofloat(pcm, in, C*N, st->arch);
 
    ret = celt_encode_with_ec(st,in,frame_size,compressed,nbCompressedBytes, NULL);
 #ifdef RESYNTH
@@ -2565,6 +2587,16 @@ int opus_custom_encoder_ctl(CELTEncoder * OPUS_RESTRICT st, int request, ...)
             OPUS_COPY(&st->silk_info, info, 1);
       }
       break;
+      case CELT_GET_FRAME_INFO_REQUEST:
+      {
+         CELTFrameInfo *info = va_arg(ap, CELTFrameInfo *);
+         if (info==0)
+            goto bad_arg;
+         info->tf_select = st->last_tf_select;
+         info->transient = st->last_transient;
+         info->spread_decision = st->spread_decision;
+      }
+      break;
       case CELT_GET_MODE_REQUEST:
       {
          const CELTMode ** value = va_arg(ap, const CELTMode**);
@@ -2581,6 +2613,16 @@ int opus_custom_encoder_ctl(CELTEncoder * OPUS_RESTRICT st, int request, ...)
          *value=st->rng;
       }
       break;
+#ifdef ENABLE_PROFILING
+      case OPUS_GET_PROFILE_REQUEST:
+      {
+         opus_uint64 * value = va_arg(ap, opus_uint64 *);
+         if (value==0)
+            goto bad_arg;
+         OPUS_COPY(value, st->profile, OPUS_PROFILE_STAGES);
+      }
+      break;
+#endif
       case OPUS_SET_LFE_REQUEST:
       {
           opus_int32 value = va_arg(ap, opus_int32);
@@ -0,0 +1,63 @@
+/* Copyright (c) 2026 Opus contributors */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef CPU_CACHE_H
+#define CPU_CACHE_H
+
+/* Cache for the result of opus_select_arch(). The arch is stored plus one
+   so that the zero-initialized cache means "not detected yet". Threads that
+   miss the cache at the same time all store the same value, so relaxed
+   atomic accesses are enough. Compilers without atomics detect on every
+   call rather than race on a plain int. */
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && \
+  !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define OPUS_ARCH_CACHE(name) static atomic_int name
+#define OPUS_ARCH_CACHE_LOAD(name) \
+  atomic_load_explicit(&(name), memory_order_relaxed)
+#define OPUS_ARCH_CACHE_STORE(name, value) \
+  atomic_store_explicit(&(name), (value), memory_order_relaxed)
+#elif defined(__clang__) || \
+  (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+#define OPUS_ARCH_CACHE(name) static int name
+#define OPUS_ARCH_CACHE_LOAD(name) __atomic_load_n(&(name), __ATOMIC_RELAXED)
+#define OPUS_ARCH_CACHE_STORE(name, value) \
+  __atomic_store_n(&(name), (value), __ATOMIC_RELAXED)
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define OPUS_ARCH_CACHE(name) static volatile long name
+#define OPUS_ARCH_CACHE_LOAD(name) ((int)_InterlockedCompareExchange(&(name), 0, 0))
+#define OPUS_ARCH_CACHE_STORE(name, value) \
+  ((void)_InterlockedExchange(&(name), (long)(value)))
+#else
+#define OPUS_ARCH_CACHE(name) static const int name = 0
+#define OPUS_ARCH_CACHE_LOAD(name) (name)
+#define OPUS_ARCH_CACHE_STORE(name, value) ((void)(value))
+#endif
+
+#endif /* CPU_CACHE_H */
@@ -540,6 +540,11 @@ opus_val32 decode_pulses(int *_y,int _n,int _k,ec_dec *_dec){
   return cwrsi(_n,_k,ec_dec_uint(_dec,CELT_PVQ_V(_n,_k)),_y);
 }
 
+void skip_pulses(int _n,int _k,ec_dec *_dec){
+  celt_assert(_k>0);
+  ec_dec_uint(_dec,CELT_PVQ_V(_n,_k));
+}
+
 #else /* SMALL_FOOTPRINT */
 
 /*Computes the next row/column of any recurrence that obeys the relation
@@ -712,4 +717,13 @@ opus_val32 decode_pulses(int *_y,int _n,int _k,ec_dec *_dec){
   return ret;
 }
 
+void skip_pulses(int _n,int _k,ec_dec *_dec){
+  VARDECL(opus_uint32,u);
+  SAVE_STACK;
+  celt_assert(_k>0);
+  ALLOC(u,_k+2U,opus_uint32);
+  ec_dec_uint(_dec,ncwrs_urow(_n,_k,u));
+  RESTORE_STACK;
+}
+
 #endif /* SMALL_FOOTPRINT */
@@ -45,4 +45,6 @@ void encode_pulses(const int *_y, int N, int K, ec_enc *enc);
 
 opus_val32 decode_pulses(int *_y, int N, int K, ec_dec *dec);
 
+void skip_pulses(int N, int K, ec_dec *dec);
+
 #endif /* CWRS_H */
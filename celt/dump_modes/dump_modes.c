@@ -32,6 +32,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "modes.h"
 #include "celt.h"
 #include "rate.h"
@@ -39,7 +40,8 @@
 
 #define INT16 "%d"
 #define INT32 "%d"
-#define FLOAT "%#0.8gf"
+/* Nine significant digits are enough for the tables to round-trip exactly. */
+#define FLOAT "%#0.9gf"
 
 #ifdef FIXED_POINT
 #define WORD16 INT16
@@ -49,10 +51,15 @@
 #define WORD32 FLOAT
 #endif
 
-void dump_modes(FILE *file, CELTMode **modes, int nb_modes)
+void dump_modes(FILE *file, CELTMode **modes, int nb_modes, int extra)
 {
    int i, j, k;
    int mdct_twiddles_size;
+   /* The window and MDCT twiddles in the checked-in static_modes_*.h were
+      computed by older code and differ slightly from what modes.c and
+      mdct.c produce now, so extra modes keep their own copies to match
+      the modes created at run time. */
+   const char *twiddle_suffix = extra ? "_x" : "";
    fprintf(file, "/* The contents of this file was automatically generated by dump_modes.c\n");
    fprintf(file, "   with arguments:");
    for (i=0;i<nb_modes;i++)
@@ -63,10 +70,18 @@ void dump_modes(FILE *file, CELTMode **modes, int nb_modes)
    fprintf(file, "\n   It contains static definitions for some pre-defined modes. */\n");
    fprintf(file, "#include \"modes.h\"\n");
    fprintf(file, "#include \"rate.h\"\n");
-   fprintf(file, "\n#ifdef HAVE_ARM_NE10\n");
-   fprintf(file, "#define OVERRIDE_FFT 1\n");
-   fprintf(file, "#include \"%s\"\n", ARM_NE10_ARCH_FILE_NAME);
-   fprintf(file, "#endif\n");
+   if (extra)
+   {
+      /* Included after static_modes_*.h, whose FFT bitrev tables it reuses. */
+      fprintf(file, "\n#ifdef HAVE_ARM_NE10\n");
+      fprintf(file, "#error \"Extra static modes are not supported with NE10\"\n");
+      fprintf(file, "#endif\n");
+   } else {
+      fprintf(file, "\n#ifdef HAVE_ARM_NE10\n");
+      fprintf(file, "#define OVERRIDE_FFT 1\n");
+      fprintf(file, "#include \"%s\"\n", ARM_NE10_ARCH_FILE_NAME);
+      fprintf(file, "#endif\n");
+   }
 
    fprintf(file, "\n");
 
@@ -74,11 +89,23 @@ void dump_modes(FILE *file, CELTMode **modes, int nb_modes)
    {
       CELTMode *mode = modes[i];
       int mdctSize;
-      int standard, framerate;
+      int standard;
+      char logN_name[32];
+      char cache_name[32];
 
       mdctSize = mode->shortMdctSize*mode->nbShortMdcts;
       standard = (mode->Fs == 400*(opus_int32)mode->shortMdctSize);
-      framerate = mode->Fs/mode->shortMdctSize;
+      /* The standard modes name these tables by frame rate. Other modes
+         can share a frame rate (44100/864 vs. 48000/960) without sharing
+         the band layout, so their tables are named by rate and size. */
+      if (standard)
+      {
+         sprintf(logN_name, "%d", mode->Fs/mode->shortMdctSize);
+         sprintf(cache_name, "%d", mode->Fs/mdctSize);
+      } else {
+         sprintf(logN_name, "%d_%d", mode->Fs, mdctSize);
+         sprintf(cache_name, "%d_%d", mode->Fs, mdctSize);
+      }
 
       if (!standard)
       {
@@ -92,9 +119,9 @@ void dump_modes(FILE *file, CELTMode **modes, int nb_modes)
          fprintf(file, "\n");
       }
 
-      fprintf(file, "#ifndef DEF_WINDOW%d\n", mode->overlap);
-      fprintf(file, "#define DEF_WINDOW%d\n", mode->overlap);
-      fprintf (file, "static const opus_val16 window%d[%d] = {\n", mode->overlap, mode->overlap);
+      fprintf(file, "#ifndef DEF_WINDOW%d%s\n", mode->overlap, twiddle_suffix);
+      fprintf(file, "#define DEF_WINDOW%d%s\n", mode->overlap, twiddle_suffix);
+      fprintf (file, "static const opus_val16 window%d%s[%d] = {\n", mode->overlap, twiddle_suffix, mode->overlap);
       for (j=0;j<mode->overlap;j++)
          fprintf (file, WORD16 ",%c", mode->window[j],(j+6)%5==0?'\n':' ');
       fprintf (file, "};\n");
@@ -117,9 +144,9 @@ void dump_modes(FILE *file, CELTMode **modes, int nb_modes)
          fprintf(file, "\n");
       }
 
-      fprintf(file, "#ifndef DEF_LOGN%d\n", framerate);
-      fprintf(file, "#define DEF_LOGN%d\n", framerate);
-      fprintf (file, "static const opus_int16 logN%d[%d] = {\n", framerate, mode->nbEBands);
+      fprintf(file, "#ifndef DEF_LOGN%s\n", logN_name);
+      fprintf(file, "#define DEF_LOGN%s\n", logN_name);
+      fprintf (file, "static const opus_int16 logN%s[%d] = {\n", logN_name, mode->nbEBands);
       for (j=0;j<mode->nbEBands;j++)
          fprintf (file, "%d, ", mode->logN[j]);
       fprintf (file, "};\n");
@@ -127,17 +154,17 @@ void dump_modes(FILE *file, CELTMode **modes, int nb_modes)
       fprintf(file, "\n");
 
       /* Pulse cache */
-      fprintf(file, "#ifndef DEF_PULSE_CACHE%d\n", mode->Fs/mdctSize);
-      fprintf(file, "#define DEF_PULSE_CACHE%d\n", mode->Fs/mdctSize);
-      fprintf (file, "static const opus_int16 cache_index%d[%d] = {\n", mode->Fs/mdctSize, (mode->maxLM+2)*mode->nbEBands);
+      fprintf(file, "#ifndef DEF_PULSE_CACHE%s\n", cache_name);
+      fprintf(file, "#define DEF_PULSE_CACHE%s\n", cache_name);
+      fprintf (file, "static const opus_int16 cache_index%s[%d] = {\n", cache_name, (mode->maxLM+2)*mode->nbEBands);
       for (j=0;j<mode->nbEBands*(mode->maxLM+2);j++)
          fprintf (file, "%d,%c", mode->cache.index[j],(j+16)%15==0?'\n':' ');
       fprintf (file, "};\n");
-      fprintf (file, "static const unsigned char cache_bits%d[%d] = {\n", mode->Fs/mdctSize, mode->cache.size);
+      fprintf (file, "static const unsigned char cache_bits%s[%d] = {\n", cache_name, mode->cache.size);
       for (j=0;j<mode->cache.size;j++)
          fprintf (file, "%d,%c", mode->cache.bits[j],(j+16)%15==0?'\n':' ');
       fprintf (file, "};\n");
-      fprintf (file, "static const unsigned char cache_caps%d[%d] = {\n", mode->Fs/mdctSize, (mode->maxLM+1)*2*mode->nbEBands);
+      fprintf (file, "static const unsigned char cache_caps%s[%d] = {\n", cache_name, (mode->maxLM+1)*2*mode->nbEBands);
       for (j=0;j<(mode->maxLM+1)*2*mode->nbEBands;j++)
          fprintf (file, "%d,%c", mode->cache.caps[j],(j+16)%15==0?'\n':' ');
       fprintf (file, "};\n");
@@ -209,10 +236,10 @@ void dump_modes(FILE *file, CELTMode **modes, int nb_modes)
 
       /* MDCT twiddles */
       mdct_twiddles_size = mode->mdct.n-(mode->mdct.n/2>>mode->mdct.maxshift);
-      fprintf(file, "#ifndef MDCT_TWIDDLES%d\n", mdctSize);
-      fprintf(file, "#define MDCT_TWIDDLES%d\n", mdctSize);
-      fprintf (file, "static const opus_val16 mdct_twiddles%d[%d] = {\n",
-            mdctSize, mdct_twiddles_size);
+      fprintf(file, "#ifndef MDCT_TWIDDLES%d%s\n", mdctSize, twiddle_suffix);
+      fprintf(file, "#define MDCT_TWIDDLES%d%s\n", mdctSize, twiddle_suffix);
+      fprintf (file, "static const opus_val16 mdct_twiddles%d%s[%d] = {\n",
+            mdctSize, twiddle_suffix, mdct_twiddles_size);
       for (j=0;j<mdct_twiddles_size;j++)
          fprintf (file, WORD16 ",%c", mode->mdct.trig[j],(j+6)%5==0?'\n':' ');
       fprintf (file, "};\n");
@@ -246,21 +273,27 @@ void dump_modes(FILE *file, CELTMode **modes, int nb_modes)
       else
          fprintf(file, "allocVectors%d_%d,    /* allocVectors */\n", mode->Fs, mdctSize);
 
-      fprintf(file, "logN%d,    /* logN */\n", framerate);
-      fprintf(file, "window%d,    /* window */\n", mode->overlap);
+      fprintf(file, "logN%s,    /* logN */\n", logN_name);
+      fprintf(file, "window%d%s,    /* window */\n", mode->overlap, twiddle_suffix);
       fprintf(file, "{%d, %d, {", mode->mdct.n, mode->mdct.maxshift);
       for (k=0;k<=mode->mdct.maxshift;k++)
          fprintf(file, "&fft_state%d_%d_%d, ", mode->Fs, mdctSize, k);
-      fprintf (file, "}, mdct_twiddles%d},    /* mdct */\n", mdctSize);
+      fprintf (file, "}, mdct_twiddles%d%s},    /* mdct */\n", mdctSize, twiddle_suffix);
 
-      fprintf(file, "{%d, cache_index%d, cache_bits%d, cache_caps%d},    /* cache */\n",
-            mode->cache.size, mode->Fs/mdctSize, mode->Fs/mdctSize, mode->Fs/mdctSize);
+      fprintf(file, "{%d, cache_index%s, cache_bits%s, cache_caps%s},    /* cache */\n",
+            mode->cache.size, cache_name, cache_name, cache_name);
       fprintf(file, "};\n");
    }
    fprintf(file, "\n");
    fprintf(file, "/* List of all the available modes */\n");
-   fprintf(file, "#define TOTAL_MODES %d\n", nb_modes);
-   fprintf(file, "static const CELTMode * const static_mode_list[TOTAL_MODES] = {\n");
+   if (extra)
+   {
+      fprintf(file, "#define TOTAL_EXTRA_MODES %d\n", nb_modes);
+      fprintf(file, "static const CELTMode * const static_extra_mode_list[TOTAL_EXTRA_MODES] = {\n");
+   } else {
+      fprintf(file, "#define TOTAL_MODES %d\n", nb_modes);
+      fprintf(file, "static const CELTMode * const static_mode_list[TOTAL_MODES] = {\n");
+   }
    for (i=0;i<nb_modes;i++)
    {
       CELTMode *mode = modes[i];
@@ -317,31 +350,70 @@ int main(int argc, char **argv)
    int i, nb;
    FILE *file;
    CELTMode **m;
+   const char *outname = BASENAME ".h";
+   const char *prog = argv[0];
+   int extra = 0;
+   while (argc>=2 && argv[1][0]=='-')
+   {
+      if (strcmp(argv[1], "-e")==0)
+      {
+         extra = 1;
+         argv++;
+         argc--;
+      } else if (argc>=3 && strcmp(argv[1], "-o")==0) {
+         outname = argv[2];
+         argv += 2;
+         argc -= 2;
+      } else {
+         argc = 0;
+         break;
+      }
+   }
    if (argc%2 != 1 || argc<3)
    {
-      fprintf (stderr, "Usage: %s rate frame_size [rate frame_size] [rate frame_size]...\n",argv[0]);
+      fprintf (stderr, "Usage: %s [-e] [-o output.h] rate frame_size [rate frame_size] [rate frame_size]...\n",prog);
+      fprintf (stderr, "  -e: dump the modes as static_extra_mode_list, to be included after\n");
+      fprintf (stderr, "      the built-in " BASENAME ".h (48000 960 is skipped)\n");
       return 1;
    }
-   nb = (argc-1)/2;
-   m = malloc(nb*sizeof(CELTMode*));
-   for (i=0;i<nb;i++)
+   nb = 0;
+   m = malloc((argc-1)/2*sizeof(CELTMode*));
+   for (i=0;i<(argc-1)/2;i++)
    {
       int Fs, frame;
+      int j;
       Fs      = atoi(argv[2*i+1]);
       frame   = atoi(argv[2*i+2]);
-      m[i] = opus_custom_mode_create(Fs, frame, NULL);
-      if (m[i]==NULL)
+      /* Repeating a mode would define its tables twice. */
+      for (j=0;j<i;j++)
+         if (Fs == atoi(argv[2*j+1]) && frame == atoi(argv[2*j+2]))
+            break;
+      if (j<i || (extra && Fs == 48000 && frame == 960))
+         continue;
+      m[nb] = opus_custom_mode_create(Fs, frame, NULL);
+      if (m[nb]==NULL)
       {
          fprintf(stderr,"Error creating mode with Fs=%s, frame_size=%s\n",
                argv[2*i+1],argv[2*i+2]);
          return EXIT_FAILURE;
       }
+      nb++;
+   }
+   if (nb==0)
+   {
+      fprintf(stderr, "No modes to dump besides the built-in 48000 960\n");
+      return EXIT_FAILURE;
+   }
+   file = fopen(outname, "w");
+   if (file==NULL)
+   {
+      fprintf(stderr, "Cannot open %s for writing\n", outname);
+      return EXIT_FAILURE;
    }
-   file = fopen(BASENAME ".h", "w");
 #ifdef OVERRIDE_FFT
    dump_modes_arch_init(m, nb);
 #endif
-   dump_modes(file, m, nb);
+   dump_modes(file, m, nb, extra);
    fclose(file);
 #ifdef OVERRIDE_FFT
    dump_modes_arch_finalize();
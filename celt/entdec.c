@@ -97,23 +97,72 @@ static int ec_read_byte_from_end(ec_dec *_this){
    _this->buf[_this->storage-++(_this->end_offs)]:0;
 }
 
+/*Inputs enough bytes to bring rng back above EC_CODE_BOT.
+  The state is kept in locals while refilling: every byte is read through an
+   unsigned char pointer, which may alias the decoder struct, so updating the
+   fields directly would force them to be stored and reloaded for each byte.
+  When at least as many bytes remain as could possibly be needed, the
+   per-byte end-of-buffer checks are skipped.*/
+static void ec_dec_refill(ec_dec *_this){
+  const unsigned char *buf;
+  opus_uint32          rng;
+  opus_uint32          val;
+  opus_uint32          offs;
+  int                  rem;
+  int                  nbits_total;
+  buf=_this->buf;
+  rng=_this->rng;
+  val=_this->val;
+  offs=_this->offs;
+  rem=_this->rem;
+  nbits_total=_this->nbits_total;
+  /*rng is never zero, so this takes at most (EC_CODE_BITS-1)/EC_SYM_BITS
+     bytes.*/
+  if(_this->storage-offs>=(EC_CODE_BITS-1)/EC_SYM_BITS){
+    do{
+      int sym;
+      nbits_total+=EC_SYM_BITS;
+      rng<<=EC_SYM_BITS;
+      /*Use up the remaining bits from our last symbol.*/
+      sym=rem;
+      /*Read the next value from the input.*/
+      rem=buf[offs++];
+      /*Take the rest of the bits we need from this new symbol.*/
+      sym=(sym<<EC_SYM_BITS|rem)>>(EC_SYM_BITS-EC_CODE_EXTRA);
+      /*And subtract them from val, capped to be less than EC_CODE_TOP.*/
+      val=((val<<EC_SYM_BITS)+(EC_SYM_MAX&~sym))&(EC_CODE_TOP-1);
+    }
+    while(rng<=EC_CODE_BOT);
+  }
+  else{
+    opus_uint32 storage;
+    storage=_this->storage;
+    do{
+      int sym;
+      nbits_total+=EC_SYM_BITS;
+      rng<<=EC_SYM_BITS;
+      sym=rem;
+      /*Past the end of the buffer we read zeros, like ec_read_byte().*/
+      rem=offs<storage?buf[offs++]:0;
+      sym=(sym<<EC_SYM_BITS|rem)>>(EC_SYM_BITS-EC_CODE_EXTRA);
+      val=((val<<EC_SYM_BITS)+(EC_SYM_MAX&~sym))&(EC_CODE_TOP-1);
+    }
+    while(rng<=EC_CODE_BOT);
+  }
+  _this->rng=rng;
+  _this->val=val;
+  _this->offs=offs;
+  _this->rem=rem;
+  _this->nbits_total=nbits_total;
+}
+
 /*Normalizes the contents of val and rng so that rng lies entirely in the
-   high-order symbol.*/
-static void ec_dec_normalize(ec_dec *_this){
+   high-order symbol.
+  Most symbols leave rng large enough, so only the range check is inlined
+   into the callers.*/
+static OPUS_INLINE void ec_dec_normalize(ec_dec *_this){
   /*If the range is too small, rescale it and input some bits.*/
-  while(_this->rng<=EC_CODE_BOT){
-    int sym;
-    _this->nbits_total+=EC_SYM_BITS;
-    _this->rng<<=EC_SYM_BITS;
-    /*Use up the remaining bits from our last symbol.*/
-    sym=_this->rem;
-    /*Read the next value from the input.*/
-    _this->rem=ec_read_byte(_this);
-    /*Take the rest of the bits we need from this new symbol.*/
-    sym=(sym<<EC_SYM_BITS|_this->rem)>>(EC_SYM_BITS-EC_CODE_EXTRA);
-    /*And subtract them from val, capped to be less than EC_CODE_TOP.*/
-    _this->val=((_this->val<<EC_SYM_BITS)+(EC_SYM_MAX&~sym))&(EC_CODE_TOP-1);
-  }
+  if(_this->rng<=EC_CODE_BOT)ec_dec_refill(_this);
 }
 
 void ec_dec_init(ec_dec *_this,unsigned char *_buf,opus_uint32 _storage){
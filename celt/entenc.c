@@ -98,15 +98,65 @@ static void ec_enc_carry_out(ec_enc *_this,int _c){
   else _this->ext++;
 }
 
-static OPUS_INLINE void ec_enc_normalize(ec_enc *_this){
-  /*If the range is too small, output some bits and rescale it.*/
-  while(_this->rng<=EC_CODE_BOT){
-    ec_enc_carry_out(_this,(int)(_this->val>>EC_CODE_SHIFT));
+/*Outputs the high-order symbols of val until rng lies entirely in the
+   high-order symbol again.
+  This is ec_enc_carry_out() run over the whole renormalization with the state
+   kept in locals: every byte is written through an unsigned char pointer,
+   which may alias the encoder struct, so updating the fields directly would
+   force them to be stored and reloaded for each byte.
+  The carry counter and the error flag are rarely touched, so they stay in
+   the struct.*/
+static void ec_enc_shift_out(ec_enc *_this,opus_uint32 _val,opus_uint32 _rng){
+  unsigned char *buf;
+  opus_uint32    offs;
+  opus_uint32    limit;
+  int            rem;
+  int            nbits;
+  buf=_this->buf;
+  offs=_this->offs;
+  limit=_this->storage-_this->end_offs;
+  rem=_this->rem;
+  nbits=0;
+  do{
+    int c;
+    c=(int)(_val>>EC_CODE_SHIFT);
+    if(c!=EC_SYM_MAX){
+      /*No further carry propagation possible, flush buffer.*/
+      int carry;
+      carry=c>>EC_SYM_BITS;
+      /*Don't output a byte on the first write.*/
+      if(rem>=0){
+        if(offs<limit)buf[offs++]=(unsigned char)(rem+carry);
+        else _this->error=-1;
+      }
+      if(_this->ext>0){
+        unsigned sym;
+        sym=(EC_SYM_MAX+carry)&EC_SYM_MAX;
+        do{
+          if(offs<limit)buf[offs++]=(unsigned char)sym;
+          else _this->error=-1;
+        }
+        while(--(_this->ext)>0);
+      }
+      rem=c&EC_SYM_MAX;
+    }
+    else _this->ext++;
     /*Move the next-to-high-order symbol into the high-order position.*/
-    _this->val=(_this->val<<EC_SYM_BITS)&(EC_CODE_TOP-1);
-    _this->rng<<=EC_SYM_BITS;
-    _this->nbits_total+=EC_SYM_BITS;
+    _val=(_val<<EC_SYM_BITS)&(EC_CODE_TOP-1);
+    _rng<<=EC_SYM_BITS;
+    nbits+=EC_SYM_BITS;
   }
+  while(_rng<=EC_CODE_BOT);
+  _this->val=_val;
+  _this->rng=_rng;
+  _this->offs=offs;
+  _this->rem=rem;
+  _this->nbits_total+=nbits;
+}
+
+static OPUS_INLINE void ec_enc_normalize(ec_enc *_this){
+  /*If the range is too small, output some bits and rescale it.*/
+  if(_this->rng<=EC_CODE_BOT)ec_enc_shift_out(_this,_this->val,_this->rng);
 }
 
 void ec_enc_init(ec_enc *_this,unsigned char *_buf,opus_uint32 _size){
@@ -197,12 +247,31 @@ void ec_enc_bits(ec_enc *_this,opus_uint32 _fl,unsigned _bits){
   used=_this->nend_bits;
   celt_assert(_bits>0);
   if(used+_bits>EC_WINDOW_SIZE){
-    do{
-      _this->error|=ec_write_byte_at_end(_this,(unsigned)window&EC_SYM_MAX);
-      window>>=EC_SYM_BITS;
-      used-=EC_SYM_BITS;
+    opus_uint32 end_offs;
+    opus_uint32 nbytes;
+    end_offs=_this->end_offs;
+    nbytes=(opus_uint32)used/EC_SYM_BITS;
+    if(_this->offs+end_offs+nbytes<=_this->storage){
+      /*There is room for every whole byte in the window: store them
+         without checking each one.*/
+      unsigned char *end;
+      end=_this->buf+_this->storage-end_offs;
+      do{
+        *--end=(unsigned char)(window&EC_SYM_MAX);
+        window>>=EC_SYM_BITS;
+        used-=EC_SYM_BITS;
+      }
+      while(used>=EC_SYM_BITS);
+      _this->end_offs=end_offs+nbytes;
+    }
+    else{
+      do{
+        _this->error|=ec_write_byte_at_end(_this,(unsigned)window&EC_SYM_MAX);
+        window>>=EC_SYM_BITS;
+        used-=EC_SYM_BITS;
+      }
+      while(used>=EC_SYM_BITS);
     }
-    while(used>=EC_SYM_BITS);
   }
   window|=(ec_window)_fl<<used;
   used+=_bits;
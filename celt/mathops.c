@@ -36,6 +36,7 @@
 #endif
 
 #include "mathops.h"
+#include "float_cast.h"
 
 /*Compute floor(sqrt(_val)) with exact arithmetic.
   _val must be greater than 0.
@@ -207,3 +208,35 @@ opus_val32 celt_rcp(opus_val32 x)
 }
 
 #endif
+
+#ifndef DISABLE_FLOAT_API
+
+void celt_float2int16_c(const float * OPUS_RESTRICT in, opus_int16 * OPUS_RESTRICT out, int cnt)
+{
+   int i;
+   for (i=0;i<cnt;i++)
+      out[i] = FLOAT2INT16(in[i]);
+}
+
+void celt_int16tofloat_c(const opus_int16 * OPUS_RESTRICT in, float * OPUS_RESTRICT out, int cnt)
+{
+   int i;
+   for (i=0;i<cnt;i++)
+      out[i] = (1.f/32768.f)*in[i];
+}
+
+int celt_limit2_checkwithin1_c(float *samples, int cnt)
+{
+   int i;
+   int within1 = 1;
+   for (i=0;i<cnt;i++)
+   {
+      float x = MAX16(-2.f, MIN16(2.f, samples[i]));
+      samples[i] = x;
+      if (x > 1 || x < -1)
+         within1 = 0;
+   }
+   return within1;
+}
+
+#endif /* DISABLE_FLOAT_API */
@@ -287,4 +287,37 @@ static OPUS_INLINE opus_val16 celt_atan2p(opus_val16 y, opus_val16 x)
 }
 
 #endif /* FIXED_POINT */
+
+#ifndef DISABLE_FLOAT_API
+
+/* Block versions of FLOAT2INT16() and of the (1/32768) scaling of 16-bit
+   PCM, for the conversions at the float/int16 API boundary. */
+void celt_float2int16_c(const float * OPUS_RESTRICT in, opus_int16 * OPUS_RESTRICT out, int cnt);
+
+void celt_int16tofloat_c(const opus_int16 * OPUS_RESTRICT in, float * OPUS_RESTRICT out, int cnt);
+
+/* Saturates the samples to +/-2 in place and returns 1 if none of them is
+   outside +/-1 (NaNs are left alone and count as within), which lets
+   opus_pcm_soft_clip() skip its search for clipped segments. */
+int celt_limit2_checkwithin1_c(float *samples, int cnt);
+
+#if defined(OPUS_X86_MAY_HAVE_SSE2)
+#include "x86/mathops_sse.h"
+#endif
+
+#if defined(OPUS_ARM_MAY_HAVE_NEON_INTR)
+#include "arm/mathops_arm.h"
+#endif
+
+#ifndef OVERRIDE_FLOAT2INT16
+#define celt_float2int16(in, out, cnt, arch) ((void)(arch), celt_float2int16_c(in, out, cnt))
+#define celt_int16tofloat(in, out, cnt, arch) ((void)(arch), celt_int16tofloat_c(in, out, cnt))
+#endif
+
+#ifndef OVERRIDE_LIMIT2_CHECKWITHIN1
+#define celt_limit2_checkwithin1(samples, cnt, arch) ((void)(arch), celt_limit2_checkwithin1_c(samples, cnt))
+#endif
+
+#endif /* DISABLE_FLOAT_API */
+
 #endif /* MATHOPS_H */
@@ -68,6 +68,15 @@ static const unsigned char band_allocation[] = {
  #else
   #include "static_modes_float.h"
  #endif
+ /* Custom modes baked in at build time by dump_modes -e
+    (see celt/dump_modes/Makefile). */
+ #ifdef EXTRA_STATIC_MODES
+  #ifdef FIXED_POINT
+   #include "static_modes_extra_fixed.h"
+  #else
+   #include "static_modes_extra_float.h"
+  #endif
+ #endif
 #endif /* CUSTOM_MODES_ONLY */
 
 #ifndef M_PI
@@ -230,7 +239,7 @@ CELTMode *opus_custom_mode_create(opus_int32 Fs, int frame_size, int *error)
    opus_val16 *window;
    opus_int16 *logN;
    int LM;
-   int arch = opus_select_arch();
+   int arch;
    ALLOC_STACK;
 #if !defined(VAR_ARRAYS) && !defined(USE_ALLOCA)
    if (global_stack==NULL)
@@ -253,6 +262,20 @@ CELTMode *opus_custom_mode_create(opus_int32 Fs, int frame_size, int *error)
          }
       }
    }
+#ifdef EXTRA_STATIC_MODES
+   /* Only an exact match, so that other frame sizes get the same mode as
+      they would without the extra tables. */
+   for (i=0;i<TOTAL_EXTRA_MODES;i++)
+   {
+      if (Fs == static_extra_mode_list[i]->Fs &&
+            frame_size == static_extra_mode_list[i]->shortMdctSize*static_extra_mode_list[i]->nbShortMdcts)
+      {
+         if (error)
+            *error = OPUS_OK;
+         return (CELTMode*)static_extra_mode_list[i];
+      }
+   }
+#endif
 #endif /* CUSTOM_MODES_ONLY */
 
 #ifndef CUSTOM_MODES
@@ -305,6 +328,10 @@ CELTMode *opus_custom_mode_create(opus_int32 Fs, int frame_size, int *error)
       return NULL;
    }
 
+   /* Only needed for computed modes, and cpuid can be slow under
+      virtualization. */
+   arch = opus_select_arch();
+
    mode = opus_alloc(sizeof(CELTMode));
    if (mode==NULL)
       goto failure;
@@ -410,8 +437,6 @@ failure:
 #ifdef CUSTOM_MODES
 void opus_custom_mode_destroy(CELTMode *mode)
 {
-   int arch = opus_select_arch();
-
    if (mode == NULL)
       return;
 #ifndef CUSTOM_MODES_ONLY
@@ -424,6 +449,15 @@ void opus_custom_mode_destroy(CELTMode *mode)
            return;
         }
      }
+#ifdef EXTRA_STATIC_MODES
+     for (i=0;i<TOTAL_EXTRA_MODES;i++)
+     {
+        if (mode == static_extra_mode_list[i])
+        {
+           return;
+        }
+     }
+#endif
    }
 #endif /* CUSTOM_MODES_ONLY */
    opus_free((opus_int16*)mode->eBands);
@@ -435,7 +469,7 @@ void opus_custom_mode_destroy(CELTMode *mode)
    opus_free((opus_int16*)mode->cache.index);
    opus_free((unsigned char*)mode->cache.bits);
    opus_free((unsigned char*)mode->cache.caps);
-   clt_mdct_clear(&mode->mdct, arch);
+   clt_mdct_clear(&mode->mdct, opus_select_arch());
 
    opus_free((CELTMode *)mode);
 }
@@ -0,0 +1,98 @@
+/* Copyright (c) 2026 Opus contributors */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+/* clock_gettime() and CLOCK_MONOTONIC are POSIX, not ISO C, so strict
+   -std=c89 or -std=c99 builds only declare them when asked to. */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "profile.h"
+
+#ifdef ENABLE_PROFILING
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define OPUS_PROFILE_TSC
+#elif (defined(__GNUC__) || defined(__clang__)) && \
+  (defined(__i386__) || defined(__x86_64__))
+#include <x86intrin.h>
+#define OPUS_PROFILE_TSC
+#endif
+#endif
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#define OPUS_MONOTONIC_CLOCK
+#elif defined(HAVE_CLOCK_GETTIME)
+#include <time.h>
+#ifdef CLOCK_MONOTONIC
+#define OPUS_MONOTONIC_CLOCK
+#endif
+#endif
+
+int opus_profile_has_clock(void)
+{
+#ifdef OPUS_MONOTONIC_CLOCK
+   return 1;
+#else
+   return 0;
+#endif
+}
+
+opus_uint64 opus_profile_ns(void)
+{
+#if defined(_WIN32)
+   LARGE_INTEGER t, f;
+   QueryPerformanceCounter(&t);
+   QueryPerformanceFrequency(&f);
+   /* Split so that the product cannot overflow */
+   return (opus_uint64)(t.QuadPart/f.QuadPart)*1000000000
+         + (opus_uint64)(t.QuadPart%f.QuadPart)*1000000000/f.QuadPart;
+#elif defined(OPUS_MONOTONIC_CLOCK)
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (opus_uint64)ts.tv_sec*1000000000 + ts.tv_nsec;
+#else
+   return 0;
+#endif
+}
+
+#ifdef ENABLE_PROFILING
+opus_uint64 opus_profile_ticks(void)
+{
+#ifdef OPUS_PROFILE_TSC
+   return (opus_uint64)__rdtsc();
+#else
+   return opus_profile_ns();
+#endif
+}
+#endif
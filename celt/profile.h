@@ -0,0 +1,63 @@
+/* Copyright (c) 2026 Opus contributors */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "opus_types.h"
+#include "opus_defines.h"
+
+/* Per-stage timing for OPUS_GET_PROFILE. Each state that owns a stage keeps
+   an opus_uint64 profile[OPUS_PROFILE_STAGES] array (only present when
+   ENABLE_PROFILING is defined) and wraps the stage with OPUS_PROFILE().
+   Without ENABLE_PROFILING the macro reduces to the statement itself and
+   opus_profile_ticks() does not exist. */
+
+/* Nanoseconds from a monotonic wall clock (QueryPerformanceCounter() on
+   Windows, clock_gettime(CLOCK_MONOTONIC) elsewhere). Only meaningful as a
+   difference, and always 0 when opus_profile_has_clock() is false. */
+opus_uint64 opus_profile_ns(void);
+
+int opus_profile_has_clock(void);
+
+#ifdef ENABLE_PROFILING
+
+/* CPU cycles (TSC) on x86, nanoseconds from opus_profile_ns() elsewhere */
+opus_uint64 opus_profile_ticks(void);
+
+#define OPUS_PROFILE(profile, stage, stmt) do { \
+   opus_uint64 profile_start_ = opus_profile_ticks(); \
+   stmt; \
+   (profile)[stage] += opus_profile_ticks() - profile_start_; \
+} while (0)
+
+#else
+
+#define OPUS_PROFILE(profile, stage, stmt) do { stmt; } while (0)
+
+#endif
+
+#endif /* PROFILE_H */
@@ -153,109 +153,170 @@ static opus_val32 loss_distortion(const opus_val16 *eBands, opus_val16 *oldEBand
    return MIN32(200,SHR32(dist,2*DB_SHIFT-6));
 }
 
-static int quant_coarse_energy_impl(const CELTMode *m, int start, int end,
-      const opus_val16 *eBands, opus_val16 *oldEBands,
-      opus_int32 budget, opus_int32 tell,
-      const unsigned char *prob_model, opus_val16 *error, ec_enc *enc,
-      int C, int LM, int intra, opus_val16 max_decay, int lfe)
-{
-   int i, c;
-   int badness = 0;
-   opus_val32 prev[2] = {0,0};
+/* One candidate coding of the coarse energy (intra or inter prediction),
+   along with its predictor state. */
+typedef struct {
+   ec_enc *enc;
+   const unsigned char *prob_model;
+   opus_val16 *oldEBands;
+   opus_val16 *error;
+   opus_val32 prev[2];
    opus_val16 coef;
    opus_val16 beta;
+   int badness;
+} coarse_pass;
 
-   if (tell+3 <= budget)
-      ec_enc_bit_logp(enc, intra, 3);
+static void coarse_pass_init(coarse_pass *p, ec_enc *enc, opus_val16 *oldEBands,
+      opus_val16 *error, int LM, int intra, opus_int32 budget, opus_int32 tell)
+{
+   p->enc = enc;
+   p->prob_model = e_prob_model[LM][intra];
+   p->oldEBands = oldEBands;
+   p->error = error;
+   p->prev[0] = p->prev[1] = 0;
+   p->badness = 0;
    if (intra)
    {
-      coef = 0;
-      beta = beta_intra;
+      p->coef = 0;
+      p->beta = beta_intra;
    } else {
-      beta = beta_coef[LM];
-      coef = pred_coef[LM];
+      p->beta = beta_coef[LM];
+      p->coef = pred_coef[LM];
    }
+   if (tell+3 <= budget)
+      ec_enc_bit_logp(enc, intra, 3);
+}
 
-   /* Encode at a fixed coarse resolution */
-   for (i=start;i<end;i++)
+/* Codes qi for band i with the model that fits in what is left of the
+   budget, and returns the value actually coded. */
+static int encode_coarse_qi(ec_enc *enc, int qi, int i, opus_int32 budget,
+      opus_int32 tell, const unsigned char *prob_model)
+{
+   if (budget-tell >= 15)
    {
-      c=0;
-      do {
-         int bits_left;
-         int qi, qi0;
-         opus_val32 q;
-         opus_val16 x;
-         opus_val32 f, tmp;
-         opus_val16 oldE;
-         opus_val16 decay_bound;
-         x = eBands[i+c*m->nbEBands];
-         oldE = MAX16(-QCONST16(9.f,DB_SHIFT), oldEBands[i+c*m->nbEBands]);
+      int pi;
+      pi = 2*IMIN(i,20);
+      ec_laplace_encode(enc, &qi,
+            prob_model[pi]<<7, prob_model[pi+1]<<6);
+   }
+   else if(budget-tell >= 2)
+   {
+      qi = IMAX(-1, IMIN(qi, 1));
+      ec_enc_icdf(enc, 2*qi^-(qi<0), small_energy_icdf, 2);
+   }
+   else if(budget-tell >= 1)
+   {
+      qi = IMIN(0, qi);
+      ec_enc_bit_logp(enc, -qi, 1);
+   }
+   else
+      qi = -1;
+   return qi;
+}
+
+static OPUS_INLINE void quant_coarse_band(const CELTMode *m, coarse_pass *p,
+      const opus_val16 *eBands, int i, int c, int start, int end, int C,
+      opus_int32 budget, opus_val16 max_decay, int lfe)
+{
+   int bits_left;
+   int qi, qi0;
+   opus_int32 tell;
+   opus_val32 q;
+   opus_val16 x;
+   opus_val32 f, tmp;
+   opus_val16 oldE;
+   opus_val16 decay_bound;
+   opus_val16 *oldEBands = p->oldEBands;
+   x = eBands[i+c*m->nbEBands];
+   oldE = MAX16(-QCONST16(9.f,DB_SHIFT), oldEBands[i+c*m->nbEBands]);
 #ifdef FIXED_POINT
-         f = SHL32(EXTEND32(x),7) - PSHR32(MULT16_16(coef,oldE), 8) - prev[c];
-         /* Rounding to nearest integer here is really important! */
-         qi = (f+QCONST32(.5f,DB_SHIFT+7))>>(DB_SHIFT+7);
-         decay_bound = EXTRACT16(MAX32(-QCONST16(28.f,DB_SHIFT),
-               SUB32((opus_val32)oldEBands[i+c*m->nbEBands],max_decay)));
+   f = SHL32(EXTEND32(x),7) - PSHR32(MULT16_16(p->coef,oldE), 8) - p->prev[c];
+   /* Rounding to nearest integer here is really important! */
+   qi = (f+QCONST32(.5f,DB_SHIFT+7))>>(DB_SHIFT+7);
+   decay_bound = EXTRACT16(MAX32(-QCONST16(28.f,DB_SHIFT),
+         SUB32((opus_val32)oldEBands[i+c*m->nbEBands],max_decay)));
 #else
-         f = x-coef*oldE-prev[c];
-         /* Rounding to nearest integer here is really important! */
-         qi = (int)floor(.5f+f);
-         decay_bound = MAX16(-QCONST16(28.f,DB_SHIFT), oldEBands[i+c*m->nbEBands]) - max_decay;
+   f = x-p->coef*oldE-p->prev[c];
+   /* Rounding to nearest integer here is really important! */
+   qi = (int)floor(.5f+f);
+   decay_bound = MAX16(-QCONST16(28.f,DB_SHIFT), oldEBands[i+c*m->nbEBands]) - max_decay;
 #endif
-         /* Prevent the energy from going down too quickly (e.g. for bands
-            that have just one bin) */
-         if (qi < 0 && x < decay_bound)
-         {
-            qi += (int)SHR16(SUB16(decay_bound,x), DB_SHIFT);
-            if (qi > 0)
-               qi = 0;
-         }
-         qi0 = qi;
-         /* If we don't have enough bits to encode all the energy, just assume
-             something safe. */
-         tell = ec_tell(enc);
-         bits_left = budget-tell-3*C*(end-i);
-         if (i!=start && bits_left < 30)
-         {
-            if (bits_left < 24)
-               qi = IMIN(1, qi);
-            if (bits_left < 16)
-               qi = IMAX(-1, qi);
-         }
-         if (lfe && i>=2)
-            qi = IMIN(qi, 0);
-         if (budget-tell >= 15)
-         {
-            int pi;
-            pi = 2*IMIN(i,20);
-            ec_laplace_encode(enc, &qi,
-                  prob_model[pi]<<7, prob_model[pi+1]<<6);
-         }
-         else if(budget-tell >= 2)
-         {
-            qi = IMAX(-1, IMIN(qi, 1));
-            ec_enc_icdf(enc, 2*qi^-(qi<0), small_energy_icdf, 2);
-         }
-         else if(budget-tell >= 1)
-         {
-            qi = IMIN(0, qi);
-            ec_enc_bit_logp(enc, -qi, 1);
-         }
-         else
-            qi = -1;
-         error[i+c*m->nbEBands] = PSHR32(f,7) - SHL16(qi,DB_SHIFT);
-         badness += abs(qi0-qi);
-         q = (opus_val32)SHL32(EXTEND32(qi),DB_SHIFT);
-
-         tmp = PSHR32(MULT16_16(coef,oldE),8) + prev[c] + SHL32(q,7);
+   /* Prevent the energy from going down too quickly (e.g. for bands
+      that have just one bin) */
+   if (qi < 0 && x < decay_bound)
+   {
+      qi += (int)SHR16(SUB16(decay_bound,x), DB_SHIFT);
+      if (qi > 0)
+         qi = 0;
+   }
+   qi0 = qi;
+   /* If we don't have enough bits to encode all the energy, just assume
+       something safe. */
+   tell = ec_tell(p->enc);
+   bits_left = budget-tell-3*C*(end-i);
+   if (i!=start && bits_left < 30)
+   {
+      if (bits_left < 24)
+         qi = IMIN(1, qi);
+      if (bits_left < 16)
+         qi = IMAX(-1, qi);
+   }
+   if (lfe && i>=2)
+      qi = IMIN(qi, 0);
+   qi = encode_coarse_qi(p->enc, qi, i, budget, tell, p->prob_model);
+   p->error[i+c*m->nbEBands] = PSHR32(f,7) - SHL16(qi,DB_SHIFT);
+   p->badness += abs(qi0-qi);
+   q = (opus_val32)SHL32(EXTEND32(qi),DB_SHIFT);
+
+   tmp = PSHR32(MULT16_16(p->coef,oldE),8) + p->prev[c] + SHL32(q,7);
 #ifdef FIXED_POINT
-         tmp = MAX32(-QCONST32(28.f, DB_SHIFT+7), tmp);
+   tmp = MAX32(-QCONST32(28.f, DB_SHIFT+7), tmp);
 #endif
-         oldEBands[i+c*m->nbEBands] = PSHR32(tmp, 7);
-         prev[c] = prev[c] + SHL32(q,7) - MULT16_16(beta,PSHR32(q,8));
+   oldEBands[i+c*m->nbEBands] = PSHR32(tmp, 7);
+   p->prev[c] = p->prev[c] + SHL32(q,7) - MULT16_16(p->beta,PSHR32(q,8));
+}
+
+static int quant_coarse_energy_impl(const CELTMode *m, int start, int end,
+      const opus_val16 *eBands, opus_val16 *oldEBands,
+      opus_int32 budget, opus_int32 tell,
+      opus_val16 *error, ec_enc *enc,
+      int C, int LM, int intra, opus_val16 max_decay, int lfe)
+{
+   int i, c;
+   coarse_pass p;
+
+   coarse_pass_init(&p, enc, oldEBands, error, LM, intra, budget, tell);
+   /* Encode at a fixed coarse resolution */
+   for (i=start;i<end;i++)
+   {
+      c=0;
+      do {
+         quant_coarse_band(m, &p, eBands, i, c, start, end, C, budget,
+               max_decay, lfe);
+      } while (++c < C);
+   }
+   return lfe ? 0 : p.badness;
+}
+
+/* Runs the intra and inter candidates side by side in a single pass over
+   the bands. The two predictor recursions and the two range coder states
+   are independent, so interleaving them lets their dependency chains
+   overlap. The two candidates must be coded into separate buffers. */
+static void quant_coarse_energy_both(const CELTMode *m, int start, int end,
+      const opus_val16 *eBands, coarse_pass *intra, coarse_pass *inter,
+      opus_int32 budget, int C, opus_val16 max_decay, int lfe)
+{
+   int i, c;
+   for (i=start;i<end;i++)
+   {
+      c=0;
+      do {
+         quant_coarse_band(m, intra, eBands, i, c, start, end, C, budget,
+               max_decay, lfe);
+         quant_coarse_band(m, inter, eBands, i, c, start, end, C, budget,
+               max_decay, lfe);
       } while (++c < C);
    }
-   return lfe ? 0 : badness;
 }
 
 void quant_coarse_energy(const CELTMode *m, int start, int end, int effEnd,
@@ -265,11 +326,7 @@ void quant_coarse_energy(const CELTMode *m, int start, int end, int effEnd,
 {
    int intra;
    opus_val16 max_decay;
-   VARDECL(opus_val16, oldEBands_intra);
-   VARDECL(opus_val16, error_intra);
-   ec_enc enc_start_state;
    opus_uint32 tell;
-   int badness1=0;
    opus_int32 intra_bias;
    opus_val32 new_distortion;
    SAVE_STACK;
@@ -293,60 +350,51 @@ void quant_coarse_energy(const CELTMode *m, int start, int end, int effEnd,
    }
    if (lfe)
       max_decay = QCONST16(3.f,DB_SHIFT);
-   enc_start_state = *enc;
-
-   ALLOC(oldEBands_intra, C*m->nbEBands, opus_val16);
-   ALLOC(error_intra, C*m->nbEBands, opus_val16);
-   OPUS_COPY(oldEBands_intra, oldEBands, C*m->nbEBands);
-
-   if (two_pass || intra)
-   {
-      badness1 = quant_coarse_energy_impl(m, start, end, eBands, oldEBands_intra, budget,
-            tell, e_prob_model[LM][1], error_intra, enc, C, LM, 1, max_decay, lfe);
-   }
 
-   if (!intra)
+   if (two_pass && !intra)
    {
-      unsigned char *intra_buf;
-      ec_enc enc_intra_state;
-      opus_int32 tell_intra;
+      ec_enc enc_intra;
       opus_uint32 nstart_bytes;
-      opus_uint32 nintra_bytes;
-      opus_uint32 save_bytes;
-      int badness2;
-      VARDECL(unsigned char, intra_bits);
-
-      tell_intra = ec_tell_frac(enc);
-
-      enc_intra_state = *enc;
-
-      nstart_bytes = ec_range_bytes(&enc_start_state);
-      nintra_bytes = ec_range_bytes(&enc_intra_state);
-      intra_buf = ec_get_buffer(&enc_intra_state) + nstart_bytes;
-      save_bytes = nintra_bytes-nstart_bytes;
-      if (save_bytes == 0)
-         save_bytes = ALLOC_NONE;
-      ALLOC(intra_bits, save_bytes, unsigned char);
-      /* Copy bits from intra bit-stream */
-      OPUS_COPY(intra_bits, intra_buf, nintra_bytes - nstart_bytes);
-
-      *enc = enc_start_state;
-
-      badness2 = quant_coarse_energy_impl(m, start, end, eBands, oldEBands, budget,
-            tell, e_prob_model[LM][intra], error, enc, C, LM, 0, max_decay, lfe);
-
-      if (two_pass && (badness1 < badness2 || (badness1 == badness2 && ((opus_int32)ec_tell_frac(enc))+intra_bias > tell_intra)))
+      coarse_pass intra_pass;
+      coarse_pass inter_pass;
+      int badness1, badness2;
+      VARDECL(opus_val16, oldEBands_intra);
+      VARDECL(opus_val16, error_intra);
+      VARDECL(unsigned char, intra_buf);
+
+      ALLOC(oldEBands_intra, C*m->nbEBands, opus_val16);
+      ALLOC(error_intra, C*m->nbEBands, opus_val16);
+      OPUS_COPY(oldEBands_intra, oldEBands, C*m->nbEBands);
+      /* The intra candidate writes to a scratch buffer of the same size, so
+         its bytes land at the same offsets as they would in the real one. */
+      ALLOC(intra_buf, enc->storage, unsigned char);
+      enc_intra = *enc;
+      enc_intra.buf = intra_buf;
+      nstart_bytes = ec_range_bytes(enc);
+
+      coarse_pass_init(&intra_pass, &enc_intra, oldEBands_intra, error_intra,
+            LM, 1, budget, tell);
+      coarse_pass_init(&inter_pass, enc, oldEBands, error, LM, 0,
+            budget, tell);
+      quant_coarse_energy_both(m, start, end, eBands, &intra_pass, &inter_pass,
+            budget, C, max_decay, lfe);
+      badness1 = lfe ? 0 : intra_pass.badness;
+      badness2 = lfe ? 0 : inter_pass.badness;
+
+      if (badness1 < badness2 || (badness1 == badness2 && ((opus_int32)ec_tell_frac(enc))+intra_bias > (opus_int32)ec_tell_frac(&enc_intra)))
       {
-         *enc = enc_intra_state;
          /* Copy intra bits to bit-stream */
-         OPUS_COPY(intra_buf, intra_bits, nintra_bytes - nstart_bytes);
+         OPUS_COPY(ec_get_buffer(enc)+nstart_bytes, intra_buf+nstart_bytes,
+               ec_range_bytes(&enc_intra)-nstart_bytes);
+         enc_intra.buf = ec_get_buffer(enc);
+         *enc = enc_intra;
          OPUS_COPY(oldEBands, oldEBands_intra, C*m->nbEBands);
          OPUS_COPY(error, error_intra, C*m->nbEBands);
          intra = 1;
       }
    } else {
-      OPUS_COPY(oldEBands, oldEBands_intra, C*m->nbEBands);
-      OPUS_COPY(error, error_intra, C*m->nbEBands);
+      quant_coarse_energy_impl(m, start, end, eBands, oldEBands, budget,
+            tell, error, enc, C, LM, intra, max_decay, lfe);
    }
 
    if (intra)
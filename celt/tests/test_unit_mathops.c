@@ -36,8 +36,11 @@
 
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
 #include "mathops.h"
 #include "bands.h"
+#include "float_cast.h"
+#include "cpu_support.h"
 
 #ifdef FIXED_POINT
 #define WORD "%d"
@@ -250,6 +253,117 @@ void testilog2(void)
 }
 #endif
 
+#ifndef DISABLE_FLOAT_API
+void testfloat2int16(void)
+{
+   /* 35 samples, so that the block kernels also run their scalar tail */
+   static const float edge[35] = {
+      0.f, -0.f, 1.f, -1.f, 1.5f, -1.5f, 2.f, -2.f, 1e10f, -1e10f,
+      .5f/32768, -.5f/32768, 1.5f/32768, -1.5f/32768, 2.5f/32768, -2.5f/32768,
+      32766.5f/32768, -32767.5f/32768, 32767.49f/32768, -32768.49f/32768,
+      1e-30f, -1e-30f, .1f, -.1f, .25f, -.75f, .999f, -.999f, 3.f/32768,
+      -3.f/32768, 1000.5f/32768, -1000.5f/32768, .3333f, -.6667f, 0.f
+   };
+   float in[1024];
+   opus_int16 out[1024];
+   float back[1024];
+   int arch, max_arch;
+   int i;
+   opus_uint32 seed = 1;
+   for (i=0;i<1024;i++)
+   {
+      seed = 1664525*seed + 1013904223;
+      in[i] = ((int)(seed>>8) - (1<<23))*(1.5f/(1<<23));
+   }
+   for (i=0;i<35;i++)
+      in[i] = edge[i];
+   max_arch = opus_select_arch();
+   for (arch=0;arch<=max_arch;arch++)
+   {
+      int n;
+      for (n=0;n<=1024;n+=(n<40 ? 1 : 197))
+      {
+         OPUS_CLEAR(out, 1024);
+         celt_float2int16(in, out, n, arch);
+         for (i=0;i<1024;i++)
+         {
+            opus_int16 expected = i<n ? FLOAT2INT16(in[i]) : 0;
+            if (out[i] != expected)
+            {
+               fprintf(stderr, "celt_float2int16 failed: arch %d, n %d, in[%d]=%.9g, got %d, expected %d\n",
+                     arch, n, i, in[i], out[i], expected);
+               ret = 1;
+               return;
+            }
+         }
+         celt_int16tofloat(out, back, n, arch);
+         for (i=0;i<n;i++)
+         {
+            if (back[i] != (1.f/32768.f)*out[i])
+            {
+               fprintf(stderr, "celt_int16tofloat failed: arch %d, n %d, in[%d]=%d, got %.9g\n",
+                     arch, n, i, out[i], back[i]);
+               ret = 1;
+               return;
+            }
+         }
+      }
+   }
+}
+
+void testlimit2checkwithin1(void)
+{
+   float in[1024];
+   float out[1024];
+   float ref[1024];
+   int arch, max_arch;
+   int i;
+   opus_uint32 seed = 1;
+   for (i=0;i<1024;i++)
+   {
+      seed = 1664525*seed + 1013904223;
+      in[i] = ((int)(seed>>8) - (1<<23))*(1.f/(1<<23));
+   }
+   in[3] = 1.f;
+   in[4] = -1.f;
+   max_arch = opus_select_arch();
+   for (arch=0;arch<=max_arch;arch++)
+   {
+      int n;
+      for (n=0;n<=1024;n+=(n<40 ? 1 : 197))
+      {
+         /* One sample at a time (and none) is pushed out of range, so that
+            both the vector loop and the scalar tail have to catch it. */
+         int k;
+         for (k=-1;k<n;k+=(k<40 ? 1 : 61))
+         {
+            int j;
+            for (j=0;j<4;j++)
+            {
+               static const float big[4] = {1.00001f, -1.5f, -7.f, 1e30f};
+               int r, expected;
+               OPUS_COPY(out, in, 1024);
+               OPUS_COPY(ref, in, 1024);
+               if (k>=0)
+                  out[k] = ref[k] = big[j];
+               r = celt_limit2_checkwithin1(out, n, arch);
+               expected = celt_limit2_checkwithin1_c(ref, n);
+               if (r != expected || r != (k<0) || memcmp(out, ref, sizeof(out)))
+               {
+                  fprintf(stderr, "celt_limit2_checkwithin1 failed: arch %d, n %d, k %d, got %d, expected %d\n",
+                        arch, n, k, r, expected);
+                  ret = 1;
+                  return;
+               }
+               if (k<0)
+                  break;
+            }
+         }
+      }
+   }
+}
+#endif
+
 int main(void)
 {
    testbitexactcos();
@@ -261,6 +375,10 @@ int main(void)
    testexp2log2();
 #ifdef FIXED_POINT
    testilog2();
+#endif
+#ifndef DISABLE_FLOAT_API
+   testfloat2int16();
+   testlimit2checkwithin1();
 #endif
    return ret;
 }
@@ -379,6 +379,28 @@ unsigned alg_unquant(celt_norm *X, int N, int K, int spread, int B,
    return collapse_mask;
 }
 
+unsigned alg_skip(int N, int K, int B, ec_dec *dec)
+{
+   unsigned collapse_mask;
+   VARDECL(int, iy);
+   SAVE_STACK;
+
+   celt_assert2(K>0, "alg_skip() needs at least one pulse");
+   celt_assert2(N>1, "alg_skip() needs at least two dimensions");
+   if (B<=1)
+   {
+      /* A single block always gets pulses, no need to expand the codeword */
+      skip_pulses(N, K, dec);
+      RESTORE_STACK;
+      return 1;
+   }
+   ALLOC(iy, N, int);
+   decode_pulses(iy, N, K, dec);
+   collapse_mask = extract_collapse_mask(iy, N, B);
+   RESTORE_STACK;
+   return collapse_mask;
+}
+
 #ifndef OVERRIDE_renormalise_vector
 void renormalise_vector(celt_norm *X, int N, opus_val16 gain, int arch)
 {
@@ -72,6 +72,16 @@ unsigned alg_quant(celt_norm *X, int N, int K, int spread, int B, ec_enc *enc,
 unsigned alg_unquant(celt_norm *X, int N, int K, int spread, int B,
       ec_dec *dec, opus_val16 gain);
 
+/** Algebraic pulse decoder for bands that are not reconstructed
+ * Consumes the codeword without computing the spectrum.
+ * @param N Number of samples in the band
+ * @param K Number of pulses to use
+ * @param B Number of blocks in the band
+ * @param dec Entropy decoder state
+ * @ret The same collapse mask as alg_unquant()
+ */
+unsigned alg_skip(int N, int K, int B, ec_dec *dec);
+
 void renormalise_vector(celt_norm *X, int N, opus_val16 gain, int arch);
 
 int stereo_itheta(const celt_norm *X, const celt_norm *Y, int stereo, int N, int arch);
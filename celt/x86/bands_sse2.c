@@ -0,0 +1,206 @@
+/* Copyright (c) 2026 Opus contributors */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <stdlib.h>
+#include "bands.h"
+#include "mathops.h"
+
+/* All the bands of a frame are handled in one call. Each band is processed
+   8 bins at a time with its gain and shift broadcast, and the bins left at
+   its end (only when M is not a multiple of 8) use the C expression, so
+   the vectors never straddle two bands. */
+
+#ifdef FIXED_POINT
+
+/* VSHR32() by a shift that is the same for the whole band, passed as the
+   shift count register and its sign. */
+static OPUS_INLINE __m128i vshr32_sse2(__m128i x, __m128i count, int left)
+{
+   return left ? _mm_sll_epi32(x, count) : _mm_sra_epi32(x, count);
+}
+
+void celt_band_sumsq_sse2(const celt_sig *X, opus_val32 *sum, int *shift,
+      const opus_int16 *eBands, const opus_int16 *logN, int start, int end, int LM)
+{
+   int i;
+   for (i=start;i<end;i++)
+   {
+      int j;
+      int band_start, band_end;
+      int sh = 0;
+      opus_val32 maxval;
+      opus_val32 s = 0;
+      __m128i vabs;
+      band_start = eBands[i]<<LM;
+      band_end = eBands[i+1]<<LM;
+      /* Only the position of the top bit of celt_maxabs32() matters, and
+         that is also the top bit of the OR of all the magnitudes, which is
+         much cheaper to get without the SSE4.1 max/min. */
+      vabs = _mm_setzero_si128();
+      for (j=band_start;j<band_end-7;j+=8)
+      {
+         __m128i x0, x1, s0, s1;
+         x0 = _mm_loadu_si128((const __m128i*)(const void*)(X+j));
+         x1 = _mm_loadu_si128((const __m128i*)(const void*)(X+j+4));
+         s0 = _mm_srai_epi32(x0, 31);
+         s1 = _mm_srai_epi32(x1, 31);
+         vabs = _mm_or_si128(vabs, _mm_sub_epi32(_mm_xor_si128(x0, s0), s0));
+         vabs = _mm_or_si128(vabs, _mm_sub_epi32(_mm_xor_si128(x1, s1), s1));
+      }
+      vabs = _mm_or_si128(vabs, _mm_shuffle_epi32(vabs, _MM_SHUFFLE(1, 0, 3, 2)));
+      vabs = _mm_or_si128(vabs, _mm_shuffle_epi32(vabs, _MM_SHUFFLE(2, 3, 0, 1)));
+      maxval = _mm_cvtsi128_si32(vabs);
+      for (;j<band_end;j++)
+         maxval |= ABS32(X[j]);
+      if (maxval > 0)
+      {
+         __m128i acc, count;
+         sh = celt_ilog2(maxval) - 14 + (((logN[i]>>BITRES)+LM+1)>>1);
+         count = _mm_cvtsi32_si128(abs(sh));
+         acc = _mm_setzero_si128();
+         for (j=band_start;j<band_end-7;j+=8)
+         {
+            __m128i x0, x1, x16;
+            x0 = _mm_loadu_si128((const __m128i*)(const void*)(X+j));
+            x1 = _mm_loadu_si128((const __m128i*)(const void*)(X+j+4));
+            x0 = vshr32_sse2(x0, count, sh<0);
+            x1 = vshr32_sse2(x1, count, sh<0);
+            /* The shift brings the band maximum below 2^15, so this does
+               not saturate and matches EXTRACT16(). */
+            x16 = _mm_packs_epi32(x0, x1);
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(x16, x16));
+         }
+         acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+         acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+         s = _mm_cvtsi128_si32(acc);
+         for (;j<band_end;j++)
+            s = MAC16_16(s, EXTRACT16(VSHR32(X[j],sh)), EXTRACT16(VSHR32(X[j],sh)));
+      }
+      shift[i] = sh;
+      sum[i] = s;
+   }
+}
+
+void celt_band_normalise_sse2(const celt_sig * OPUS_RESTRICT freq,
+      celt_norm * OPUS_RESTRICT X, const opus_val16 *g, const int *shift,
+      const opus_int16 *eBands, int start, int end, int M)
+{
+   int i;
+   for (i=start;i<end;i++)
+   {
+      int j;
+      int band_end;
+      __m128i gain, count;
+      j = M*eBands[i];
+      band_end = M*eBands[i+1];
+      count = _mm_cvtsi32_si128(abs(shift[i]));
+      /* The gain sits in the low half of each 32-bit lane with zeros above,
+         so that _mm_madd_epi16() multiplies it by the low 16 bits of the
+         shifted sample, which is EXTRACT16() of it. */
+      gain = _mm_set1_epi32((opus_uint16)g[i]);
+      for (;j<band_end-7;j+=8)
+      {
+         __m128i x0, x1;
+         x0 = _mm_loadu_si128((const __m128i*)(const void*)(freq+j));
+         x1 = _mm_loadu_si128((const __m128i*)(const void*)(freq+j+4));
+         x0 = vshr32_sse2(x0, count, shift[i]<0);
+         x1 = vshr32_sse2(x1, count, shift[i]<0);
+         x0 = _mm_srai_epi32(_mm_madd_epi16(x0, gain), 15);
+         x1 = _mm_srai_epi32(_mm_madd_epi16(x1, gain), 15);
+         /* Truncate to 16 bits like the store to celt_norm does, rather
+            than saturate. */
+         x0 = _mm_srai_epi32(_mm_slli_epi32(x0, 16), 16);
+         x1 = _mm_srai_epi32(_mm_slli_epi32(x1, 16), 16);
+         _mm_storeu_si128((__m128i*)(void*)(X+j), _mm_packs_epi32(x0, x1));
+      }
+      for (;j<band_end;j++)
+         X[j] = MULT16_16_Q15(VSHR32(freq[j],shift[i]),g[i]);
+   }
+}
+
+void celt_band_denormalise_sse2(const celt_norm * OPUS_RESTRICT X,
+      celt_sig * OPUS_RESTRICT freq, const opus_val16 *g, const int *shift,
+      const opus_int16 *eBands, int start, int end, int M)
+{
+   int i;
+   for (i=start;i<end;i++)
+   {
+      int j;
+      int band_end;
+      __m128i gain, count;
+      j = M*eBands[i];
+      band_end = M*eBands[i+1];
+      count = _mm_cvtsi32_si128(abs(shift[i]));
+      gain = _mm_set1_epi16(g[i]);
+      for (;j<band_end-7;j+=8)
+      {
+         __m128i x, plo, phi;
+         x = _mm_loadu_si128((const __m128i*)(const void*)(X+j));
+         /* Full 32-bit products from their low and high halves */
+         plo = _mm_mullo_epi16(x, gain);
+         phi = _mm_mulhi_epi16(x, gain);
+         _mm_storeu_si128((__m128i*)(void*)(freq+j),
+               vshr32_sse2(_mm_unpacklo_epi16(plo, phi), count, shift[i]<0));
+         _mm_storeu_si128((__m128i*)(void*)(freq+j+4),
+               vshr32_sse2(_mm_unpackhi_epi16(plo, phi), count, shift[i]<0));
+      }
+      for (;j<band_end;j++)
+         freq[j] = VSHR32(MULT16_16(X[j],g[i]),shift[i]);
+   }
+}
+
+#else
+
+void celt_band_scale_sse2(const float * OPUS_RESTRICT in, float * OPUS_RESTRICT out,
+      const opus_val16 *g, const opus_int16 *eBands, int start, int end, int M)
+{
+   int i;
+   for (i=start;i<end;i++)
+   {
+      int j;
+      int band_end;
+      __m128 gain;
+      j = M*eBands[i];
+      band_end = M*eBands[i+1];
+      gain = _mm_set1_ps(g[i]);
+      for (;j<band_end-7;j+=8)
+      {
+         _mm_storeu_ps(out+j, _mm_mul_ps(_mm_loadu_ps(in+j), gain));
+         _mm_storeu_ps(out+j+4, _mm_mul_ps(_mm_loadu_ps(in+j+4), gain));
+      }
+      for (;j<band_end;j++)
+         out[j] = in[j]*g[i];
+   }
+}
+
+#endif
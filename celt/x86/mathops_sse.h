@@ -0,0 +1,69 @@
+/* Copyright (c) 2026 Opus contributors */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef MATHOPS_SSE_H
+#define MATHOPS_SSE_H
+
+#include "cpu_support.h"
+
+#if defined(OPUS_X86_MAY_HAVE_SSE2) && !defined(DISABLE_FLOAT_API)
+#define OVERRIDE_FLOAT2INT16
+
+void celt_float2int16_sse2(const float * OPUS_RESTRICT in, opus_int16 * OPUS_RESTRICT out, int cnt);
+
+void celt_int16tofloat_sse2(const opus_int16 * OPUS_RESTRICT in, float * OPUS_RESTRICT out, int cnt);
+
+#define OVERRIDE_LIMIT2_CHECKWITHIN1
+int celt_limit2_checkwithin1_sse2(float *samples, int cnt);
+
+#if defined(OPUS_X86_PRESUME_SSE2)
+#define celt_float2int16(in, out, cnt, arch) \
+    ((void)(arch), celt_float2int16_sse2(in, out, cnt))
+#define celt_int16tofloat(in, out, cnt, arch) \
+    ((void)(arch), celt_int16tofloat_sse2(in, out, cnt))
+#define celt_limit2_checkwithin1(samples, cnt, arch) \
+    ((void)(arch), celt_limit2_checkwithin1_sse2(samples, cnt))
+
+#else
+
+extern void (*const CELT_FLOAT2INT16_IMPL[OPUS_ARCHMASK + 1])(
+      const float *in, opus_int16 *out, int cnt);
+extern void (*const CELT_INT16TOFLOAT_IMPL[OPUS_ARCHMASK + 1])(
+      const opus_int16 *in, float *out, int cnt);
+extern int (*const CELT_LIMIT2_CHECKWITHIN1_IMPL[OPUS_ARCHMASK + 1])(
+      float *samples, int cnt);
+
+#  define celt_float2int16(in, out, cnt, arch) \
+    ((*CELT_FLOAT2INT16_IMPL[(arch) & OPUS_ARCHMASK])(in, out, cnt))
+#  define celt_int16tofloat(in, out, cnt, arch) \
+    ((*CELT_INT16TOFLOAT_IMPL[(arch) & OPUS_ARCHMASK])(in, out, cnt))
+#  define celt_limit2_checkwithin1(samples, cnt, arch) \
+    ((*CELT_LIMIT2_CHECKWITHIN1_IMPL[(arch) & OPUS_ARCHMASK])(samples, cnt))
+
+#endif
+#endif
+
+#endif
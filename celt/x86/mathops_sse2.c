@@ -0,0 +1,113 @@
+/* Copyright (c) 2026 Opus contributors */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include "mathops.h"
+#include "float_cast.h"
+
+#ifndef DISABLE_FLOAT_API
+
+/* Same result as FLOAT2INT16() on each sample: the clamp comes first, so
+   that out of range values (and NaNs, through the operand order of
+   _mm_max_ps()) saturate the same way, and the conversion uses the
+   current rounding mode like float2int(). */
+void celt_float2int16_sse2(const float * OPUS_RESTRICT in, opus_int16 * OPUS_RESTRICT out, int cnt)
+{
+   int i;
+   const __m128 scale = _mm_set1_ps(CELT_SIG_SCALE);
+   const __m128 min = _mm_set1_ps(-32768.f);
+   const __m128 max = _mm_set1_ps(32767.f);
+   for (i=0;i<cnt-7;i+=8)
+   {
+      __m128 x0, x1;
+      x0 = _mm_mul_ps(_mm_loadu_ps(in+i), scale);
+      x1 = _mm_mul_ps(_mm_loadu_ps(in+i+4), scale);
+      x0 = _mm_min_ps(_mm_max_ps(x0, min), max);
+      x1 = _mm_min_ps(_mm_max_ps(x1, min), max);
+      _mm_storeu_si128((__m128i*)(void*)(out+i),
+            _mm_packs_epi32(_mm_cvtps_epi32(x0), _mm_cvtps_epi32(x1)));
+   }
+   for (;i<cnt;i++)
+      out[i] = FLOAT2INT16(in[i]);
+}
+
+void celt_int16tofloat_sse2(const opus_int16 * OPUS_RESTRICT in, float * OPUS_RESTRICT out, int cnt)
+{
+   int i;
+   const __m128 scale = _mm_set1_ps(1.f/32768.f);
+   for (i=0;i<cnt-7;i+=8)
+   {
+      __m128i x, lo, hi;
+      x = _mm_loadu_si128((const __m128i*)(const void*)(in+i));
+      /* Sign-extend by placing each sample in the upper half of a lane */
+      lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+      hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+      _mm_storeu_ps(out+i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+      _mm_storeu_ps(out+i+4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+   }
+   for (;i<cnt;i++)
+      out[i] = (1.f/32768.f)*in[i];
+}
+
+/* _mm_min_ps() and _mm_max_ps() return their second operand when either
+   one is a NaN, so with the constant first they behave like MIN16() and
+   MAX16() and leave NaNs in place, as the C version does. */
+int celt_limit2_checkwithin1_sse2(float *samples, int cnt)
+{
+   int i;
+   int within1;
+   const __m128 two = _mm_set1_ps(2.f);
+   const __m128 mtwo = _mm_set1_ps(-2.f);
+   const __m128 one = _mm_set1_ps(1.f);
+   const __m128 absmask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+   __m128 over = _mm_setzero_ps();
+   for (i=0;i<cnt-7;i+=8)
+   {
+      __m128 x0, x1;
+      x0 = _mm_max_ps(mtwo, _mm_min_ps(two, _mm_loadu_ps(samples+i)));
+      x1 = _mm_max_ps(mtwo, _mm_min_ps(two, _mm_loadu_ps(samples+i+4)));
+      _mm_storeu_ps(samples+i, x0);
+      _mm_storeu_ps(samples+i+4, x1);
+      over = _mm_or_ps(over, _mm_cmpgt_ps(_mm_and_ps(x0, absmask), one));
+      over = _mm_or_ps(over, _mm_cmpgt_ps(_mm_and_ps(x1, absmask), one));
+   }
+   within1 = _mm_movemask_ps(over) == 0;
+   for (;i<cnt;i++)
+   {
+      float x = MAX16(-2.f, MIN16(2.f, samples[i]));
+      samples[i] = x;
+      if (x > 1 || x < -1)
+         within1 = 0;
+   }
+   return within1;
+}
+
+#endif
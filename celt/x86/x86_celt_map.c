@@ -34,6 +34,8 @@
 #include "pitch.h"
 #include "pitch_sse.h"
 #include "vq.h"
+#include "mathops.h"
+#include "bands.h"
 
 #if defined(OPUS_HAVE_RTCD)
 
@@ -164,4 +166,85 @@ opus_val16 (*const OP_PVQ_SEARCH_IMPL[OPUS_ARCHMASK + 1])(
 #endif
 
 #endif
+
+#if defined(OPUS_X86_MAY_HAVE_SSE2) && !defined(OPUS_X86_PRESUME_SSE2) && !defined(DISABLE_FLOAT_API)
+void (*const CELT_FLOAT2INT16_IMPL[OPUS_ARCHMASK + 1])(
+      const float *in, opus_int16 *out, int cnt
+) = {
+  celt_float2int16_c,                /* non-sse */
+  celt_float2int16_c,
+  MAY_HAVE_SSE2(celt_float2int16),
+  MAY_HAVE_SSE2(celt_float2int16),
+  MAY_HAVE_SSE2(celt_float2int16)
+};
+
+void (*const CELT_INT16TOFLOAT_IMPL[OPUS_ARCHMASK + 1])(
+      const opus_int16 *in, float *out, int cnt
+) = {
+  celt_int16tofloat_c,                /* non-sse */
+  celt_int16tofloat_c,
+  MAY_HAVE_SSE2(celt_int16tofloat),
+  MAY_HAVE_SSE2(celt_int16tofloat),
+  MAY_HAVE_SSE2(celt_int16tofloat)
+};
+
+int (*const CELT_LIMIT2_CHECKWITHIN1_IMPL[OPUS_ARCHMASK + 1])(
+      float *samples, int cnt
+) = {
+  celt_limit2_checkwithin1_c,                /* non-sse */
+  celt_limit2_checkwithin1_c,
+  MAY_HAVE_SSE2(celt_limit2_checkwithin1),
+  MAY_HAVE_SSE2(celt_limit2_checkwithin1),
+  MAY_HAVE_SSE2(celt_limit2_checkwithin1)
+};
+#endif
+
+#if defined(OPUS_X86_MAY_HAVE_SSE2) && !defined(OPUS_X86_PRESUME_SSE2)
+# if defined(FIXED_POINT)
+void (*const CELT_BAND_SUMSQ_IMPL[OPUS_ARCHMASK + 1])(
+      const celt_sig *X, opus_val32 *sum, int *shift, const opus_int16 *eBands,
+      const opus_int16 *logN, int start, int end, int LM
+) = {
+  celt_band_sumsq_c,                /* non-sse */
+  celt_band_sumsq_c,
+  MAY_HAVE_SSE2(celt_band_sumsq),
+  MAY_HAVE_SSE2(celt_band_sumsq),
+  MAY_HAVE_SSE2(celt_band_sumsq)
+};
+
+void (*const CELT_BAND_NORMALISE_IMPL[OPUS_ARCHMASK + 1])(
+      const celt_sig *freq, celt_norm *X, const opus_val16 *g, const int *shift,
+      const opus_int16 *eBands, int start, int end, int M
+) = {
+  celt_band_normalise_c,                /* non-sse */
+  celt_band_normalise_c,
+  MAY_HAVE_SSE2(celt_band_normalise),
+  MAY_HAVE_SSE2(celt_band_normalise),
+  MAY_HAVE_SSE2(celt_band_normalise)
+};
+
+void (*const CELT_BAND_DENORMALISE_IMPL[OPUS_ARCHMASK + 1])(
+      const celt_norm *X, celt_sig *freq, const opus_val16 *g, const int *shift,
+      const opus_int16 *eBands, int start, int end, int M
+) = {
+  celt_band_denormalise_c,                /* non-sse */
+  celt_band_denormalise_c,
+  MAY_HAVE_SSE2(celt_band_denormalise),
+  MAY_HAVE_SSE2(celt_band_denormalise),
+  MAY_HAVE_SSE2(celt_band_denormalise)
+};
+# else
+void (*const CELT_BAND_SCALE_IMPL[OPUS_ARCHMASK + 1])(
+      const float *in, float *out, const opus_val16 *g,
+      const opus_int16 *eBands, int start, int end, int M
+) = {
+  celt_band_scale_c,                /* non-sse */
+  celt_band_scale_c,
+  MAY_HAVE_SSE2(celt_band_scale),
+  MAY_HAVE_SSE2(celt_band_scale),
+  MAY_HAVE_SSE2(celt_band_scale)
+};
+# endif
+#endif
+
 #endif
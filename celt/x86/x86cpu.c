@@ -30,6 +30,7 @@
 #endif
 
 #include "cpu_support.h"
+#include "cpu_cache.h"
 #include "macros.h"
 #include "main.h"
 #include "pitch.h"
@@ -119,7 +120,7 @@ static void opus_cpu_feature_check(CPU_Feature *cpu_feature)
     }
 }
 
-int opus_select_arch(void)
+static int opus_select_arch_impl(void)
 {
     CPU_Feature cpu_feature;
     int arch;
@@ -154,4 +155,19 @@ int opus_select_arch(void)
     return arch;
 }
 
+/* cpuid traps to the hypervisor in virtual machines, and this is called on
+   every encoder and decoder init and reset */
+OPUS_ARCH_CACHE(arch_cache);
+
+int opus_select_arch(void)
+{
+    int arch = OPUS_ARCH_CACHE_LOAD(arch_cache) - 1;
+    if (arch < 0)
+    {
+        arch = opus_select_arch_impl();
+        OPUS_ARCH_CACHE_STORE(arch_cache, arch + 1);
+    }
+    return arch;
+}
+
 #endif
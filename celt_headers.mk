@@ -3,6 +3,7 @@ celt/arch.h \
 celt/bands.h \
 celt/celt.h \
 celt/cpu_support.h \
+celt/cpu_cache.h \
 include/opus_types.h \
 include/opus_defines.h \
 include/opus_custom.h \
@@ -23,6 +24,7 @@ celt/mfrngcod.h \
 celt/modes.h \
 celt/os_support.h \
 celt/pitch.h \
+celt/profile.h \
 celt/celt_lpc.h \
 celt/x86/celt_lpc_sse.h \
 celt/quant_bands.h \
@@ -34,11 +36,13 @@ celt/static_modes_fixed.h \
 celt/static_modes_float_arm_ne10.h \
 celt/static_modes_fixed_arm_ne10.h \
 celt/arm/armcpu.h \
+celt/arm/bands_arm.h \
 celt/arm/fixed_armv4.h \
 celt/arm/fixed_armv5e.h \
 celt/arm/fixed_arm64.h \
 celt/arm/kiss_fft_armv4.h \
 celt/arm/kiss_fft_armv5e.h \
+celt/arm/mathops_arm.h \
 celt/arm/pitch_arm.h \
 celt/arm/fft_arm.h \
 celt/arm/mdct_arm.h \
@@ -48,6 +52,8 @@ celt/mips/kiss_fft_mipsr1.h \
 celt/mips/mdct_mipsr1.h \
 celt/mips/pitch_mipsr1.h \
 celt/mips/vq_mipsr1.h \
+celt/x86/bands_sse.h \
+celt/x86/mathops_sse.h \
 celt/x86/pitch_sse.h \
 celt/x86/vq_sse.h \
 celt/x86/x86cpu.h
@@ -13,6 +13,7 @@ celt/mathops.c \
 celt/mdct.c \
 celt/modes.c \
 celt/pitch.c \
+celt/profile.c \
 celt/celt_lpc.c \
 celt/quant_bands.c \
 celt/rate.c \
@@ -24,6 +25,8 @@ celt/x86/x86_celt_map.c \
 celt/x86/pitch_sse.c
 
 CELT_SOURCES_SSE2 = \
+celt/x86/bands_sse2.c \
+celt/x86/mathops_sse2.c \
 celt/x86/pitch_sse2.c \
 celt/x86/vq_sse2.c
 
@@ -42,7 +45,9 @@ CELT_AM_SOURCES_ARM_ASM = \
 celt/arm/armopts.s.in
 
 CELT_SOURCES_ARM_NEON_INTR = \
+celt/arm/bands_neon_intr.c \
 celt/arm/celt_neon_intr.c \
+celt/arm/mathops_neon_intr.c \
 celt/arm/pitch_neon_intr.c
 
 CELT_SOURCES_ARM_NE10 = \
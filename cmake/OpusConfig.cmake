@@ -38,6 +38,8 @@ endif()
 include(CheckFunctionExists)
 check_function_exists(lrintf HAVE_LRINTF)
 check_function_exists(lrint HAVE_LRINT)
+# OPUS_SET_CPU_BUDGET_US needs a monotonic wall clock
+check_function_exists(clock_gettime HAVE_CLOCK_GETTIME)
 
 if(CMAKE_SYSTEM_PROCESSOR MATCHES "(i[0-9]86|x86|X86|amd64|AMD64|x86_64)")
   if(CMAKE_SIZEOF_VOID_P EQUAL 8)
@@ -35,8 +35,11 @@ get_opus_sources(CELT_SOURCES_ARM_NEON_INTR celt_sources.mk
 get_opus_sources(CELT_SOURCES_ARM_NE10 celt_sources.mk celt_sources_arm_ne10)
 
 get_opus_sources(opus_demo_SOURCES Makefile.am opus_demo_sources)
+get_opus_sources(opus_bench_SOURCES Makefile.am opus_bench_sources)
+get_opus_sources(opus_kernel_bench_SOURCES Makefile.am opus_kernel_bench_sources)
 get_opus_sources(opus_custom_demo_SOURCES Makefile.am opus_custom_demo_sources)
 get_opus_sources(opus_compare_SOURCES Makefile.am opus_compare_sources)
+get_opus_sources(opus_run_vectors_SOURCES Makefile.am opus_run_vectors_sources)
 get_opus_sources(tests_test_opus_api_SOURCES Makefile.am test_opus_api_sources)
 get_opus_sources(tests_test_opus_encode_SOURCES Makefile.am
                  test_opus_encode_sources)
@@ -44,3 +47,5 @@ get_opus_sources(tests_test_opus_decode_SOURCES Makefile.am
                  test_opus_decode_sources)
 get_opus_sources(tests_test_opus_padding_SOURCES Makefile.am
                  test_opus_padding_sources)
+get_opus_sources(tests_test_opus_latency_SOURCES Makefile.am
+                 test_opus_latency_sources)
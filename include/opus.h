@@ -106,7 +106,17 @@ extern "C" {
   * future versions of this code may change the size, so no assuptions should be made about it.
   *
   * The encoder state is always continuous in memory and only a shallow copy is sufficient
-  * to copy it (e.g. memcpy())
+  * to copy it (e.g. memcpy()). An application that starts many streams with the same
+  * settings can initialize and configure one encoder once and copy it for each new
+  * stream. #OPUS_RESET_STATE returns immediately on an encoder that has not encoded
+  * anything since it was initialized or last reset.
+  *
+  * Close to a third of the state holds the tonality and speech/music
+  * analysis, which only runs at complexity 7 and above (10 in fixed point). Deployments
+  * that never need it can leave it out with opus_encoder_get_size_ext(),
+  * opus_encoder_init_ext() or opus_encoder_create_ext() and #OPUS_ENCODER_NO_ANALYSIS.
+  * Such an encoder then codes every frame as it would at a complexity too low to run
+  * the analysis.
   *
   * It is possible to change some of the encoder's settings using the opus_encoder_ctl()
   * interface. All these settings already default to the recommended value, so they should
@@ -170,6 +180,14 @@ typedef struct OpusEncoder OpusEncoder;
   */
 OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_encoder_get_size(int channels);
 
+/** Gets the size of an <code>OpusEncoder</code> structure created with the given flags.
+  * @param[in] channels <tt>int</tt>: Number of channels.
+  *                                   This must be 1 or 2.
+  * @param[in] flags <tt>int</tt>: 0 or #OPUS_ENCODER_NO_ANALYSIS.
+  * @returns The size in bytes, or 0 for invalid arguments.
+  */
+OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_encoder_get_size_ext(int channels, int flags);
+
 /**
  */
 
@@ -212,6 +230,22 @@ OPUS_EXPORT OPUS_WARN_UNUSED_RESULT OpusEncoder *opus_encoder_create(
     int *error
 );
 
+/** Allocates and initializes an encoder state with the given flags.
+  * This is opus_encoder_create() with the additional @a flags argument.
+  * @param [in] Fs <tt>opus_int32</tt>: Sampling rate of input signal (Hz)
+  * @param [in] channels <tt>int</tt>: Number of channels (1 or 2) in input signal
+  * @param [in] application <tt>int</tt>: Coding mode (OPUS_APPLICATION_VOIP/OPUS_APPLICATION_AUDIO/OPUS_APPLICATION_RESTRICTED_LOWDELAY)
+  * @param [in] flags <tt>int</tt>: 0 or #OPUS_ENCODER_NO_ANALYSIS.
+  * @param [out] error <tt>int*</tt>: @ref opus_errorcodes
+  */
+OPUS_EXPORT OPUS_WARN_UNUSED_RESULT OpusEncoder *opus_encoder_create_ext(
+    opus_int32 Fs,
+    int channels,
+    int application,
+    int flags,
+    int *error
+);
+
 /** Initializes a previously allocated encoder state
   * The memory pointed to by st must be at least the size returned by opus_encoder_get_size().
   * This is intended for applications which use their own allocator instead of malloc.
@@ -232,6 +266,24 @@ OPUS_EXPORT int opus_encoder_init(
     int application
 ) OPUS_ARG_NONNULL(1);
 
+/** Initializes a previously allocated encoder state with the given flags.
+  * The memory pointed to by st must be at least the size returned by
+  * opus_encoder_get_size_ext() for the same channels and flags.
+  * @param [in] st <tt>OpusEncoder*</tt>: Encoder state
+  * @param [in] Fs <tt>opus_int32</tt>: Sampling rate of input signal (Hz)
+  * @param [in] channels <tt>int</tt>: Number of channels (1 or 2) in input signal
+  * @param [in] application <tt>int</tt>: Coding mode (OPUS_APPLICATION_VOIP/OPUS_APPLICATION_AUDIO/OPUS_APPLICATION_RESTRICTED_LOWDELAY)
+  * @param [in] flags <tt>int</tt>: 0 or #OPUS_ENCODER_NO_ANALYSIS.
+  * @retval #OPUS_OK Success or @ref opus_errorcodes
+  */
+OPUS_EXPORT int opus_encoder_init_ext(
+    OpusEncoder *st,
+    opus_int32 Fs,
+    int channels,
+    int application,
+    int flags
+) OPUS_ARG_NONNULL(1);
+
 /** Encodes an Opus frame.
   * @param [in] st <tt>OpusEncoder*</tt>: Encoder state
   * @param [in] pcm <tt>opus_int16*</tt>: Input signal (interleaved if 2 channels). length is frame_size*channels*sizeof(opus_int16)
@@ -309,6 +361,32 @@ OPUS_EXPORT OPUS_WARN_UNUSED_RESULT opus_int32 opus_encode_float(
     opus_int32 max_data_bytes
 ) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(2) OPUS_ARG_NONNULL(4);
 
+/** Encodes an Opus frame from 24-bit input.
+  * This is opus_encode() with 24-bit samples (-8388608 to 8388607) stored
+  * in 32-bit integers. The fixed-point encoder rounds them to 16 bits.
+  * @param [in] st <tt>OpusEncoder*</tt>: Encoder state
+  * @param [in] pcm <tt>opus_int32*</tt>: Input signal (interleaved if 2 channels).
+  *          length is frame_size*channels*sizeof(opus_int32)
+  * @param [in] frame_size <tt>int</tt>: Number of samples per channel in the
+  *                                      input signal, with the same
+  *                                      requirements as for opus_encode().
+  * @param [out] data <tt>unsigned char*</tt>: Output payload.
+  *                                            This must contain storage for at
+  *                                            least \a max_data_bytes.
+  * @param [in] max_data_bytes <tt>opus_int32</tt>: Size of the allocated
+  *                                                 memory for the output
+  *                                                 payload.
+  * @returns The length of the encoded packet (in bytes) on success or a
+  *          negative error code (see @ref opus_errorcodes) on failure.
+  */
+OPUS_EXPORT OPUS_WARN_UNUSED_RESULT opus_int32 opus_encode24(
+    OpusEncoder *st,
+    const opus_int32 *pcm,
+    int frame_size,
+    unsigned char *data,
+    opus_int32 max_data_bytes
+) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(2) OPUS_ARG_NONNULL(4);
+
 /** Frees an <code>OpusEncoder</code> allocated by opus_encoder_create().
   * @param[in] st <tt>OpusEncoder*</tt>: State to be freed.
   */
@@ -326,6 +404,48 @@ OPUS_EXPORT void opus_encoder_destroy(OpusEncoder *st);
   * @see opus_encoderctls
   */
 OPUS_EXPORT int opus_encoder_ctl(OpusEncoder *st, int request, ...) OPUS_ARG_NONNULL(1);
+
+/** Decisions made by the encoder for one frame, as reported to the
+  * callback set with opus_encoder_set_trace().
+  */
+typedef struct OpusEncoderFrameInfo {
+   int mode;                 /**< Coding mode: 1000 for SILK-only, 1001 for hybrid, 1002 for CELT-only */
+   int bandwidth;            /**< Coded bandwidth, one of the OPUS_BANDWIDTH_* values */
+   int frame_size;           /**< Frame size in samples per channel */
+   int stream_channels;      /**< Number of coded channels */
+   opus_int32 bitrate;       /**< Target bitrate in bits per second */
+   int complexity;           /**< Complexity used for the frame, see OPUS_SET_CPU_BUDGET_US() */
+   opus_int32 equiv_rate;    /**< Equivalent 20 ms rate used for the mode and bandwidth decisions */
+   opus_int32 silk_bitrate;  /**< Bitrate given to SILK (the SILK part of the hybrid split), 0 in CELT-only mode */
+   int redundancy_bytes;     /**< Size of the CELT redundancy frame used for a mode switch, 0 if none */
+   int in_dtx;               /**< 1 if the frame was replaced by a DTX frame */
+   float music_prob;         /**< Music probability from the signal analysis, -1 if the analysis did not run */
+   float tonality;           /**< Tonality from the signal analysis, -1 if the analysis did not run */
+   int tf_select;            /**< CELT time-frequency resolution selector, -1 if CELT was not used */
+   int transient;            /**< 1 if CELT coded the frame as a transient, -1 if CELT was not used */
+   int spread_decision;      /**< CELT spreading decision (SPREAD_*), -1 if CELT was not used */
+   opus_int32 bytes;         /**< Number of bytes emitted for the frame */
+   opus_uint64 elapsed;      /**< Wall-clock time spent encoding the frame, in nanoseconds, 0 where there is no monotonic clock (see OPUS_SET_CPU_BUDGET_US()) */
+} OpusEncoderFrameInfo;
+
+/** Callback type for opus_encoder_set_trace().
+  * @param user_data <tt>void*</tt>: Pointer given to opus_encoder_set_trace()
+  * @param info <tt>const OpusEncoderFrameInfo*</tt>: Decisions for the frame just encoded,
+  *  only valid for the duration of the call
+  */
+typedef void (*opus_encoder_trace_func)(void *user_data, const OpusEncoderFrameInfo *info);
+
+/** Register a callback called once for every frame the encoder produces.
+  * When a packet holds several frames (e.g. 100 ms in 20 ms frames), the callback
+  * is called for each of them. The callback is kept across OPUS_RESET_STATE and
+  * cleared by opus_encoder_init(). For a multistream encoder, set it on each stream
+  * obtained with OPUS_MULTISTREAM_GET_ENCODER_STATE().
+  * @param st <tt>OpusEncoder*</tt>: Encoder state
+  * @param callback <tt>opus_encoder_trace_func</tt>: Callback, or NULL to disable tracing
+  * @param user_data <tt>void*</tt>: Pointer passed back to the callback
+  * @returns @ref opus_errorcodes
+  */
+OPUS_EXPORT int opus_encoder_set_trace(OpusEncoder *st, opus_encoder_trace_func callback, void *user_data) OPUS_ARG_NONNULL(1);
 /**@}*/
 
 /** @defgroup opus_decoder Opus Decoder
@@ -493,6 +613,82 @@ OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_decode_float(
     int decode_fec
 ) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(4);
 
+/** Decode an Opus packet with 24-bit output.
+  * This is opus_decode() with 24-bit samples (-8388608 to 8388607) stored
+  * in 32-bit integers. The fixed-point decoder only has 16 bits of
+  * resolution, so its output is the 16-bit output shifted by 8.
+  * @param [in] st <tt>OpusDecoder*</tt>: Decoder state
+  * @param [in] data <tt>char*</tt>: Input payload. Use a NULL pointer to indicate packet loss
+  * @param [in] len <tt>opus_int32</tt>: Number of bytes in payload
+  * @param [out] pcm <tt>opus_int32*</tt>: Output signal (interleaved if 2 channels). length
+  *  is frame_size*channels*sizeof(opus_int32)
+  * @param [in] frame_size Number of samples per channel of available space in \a pcm,
+  *  with the same requirements as for opus_decode().
+  * @param [in] decode_fec <tt>int</tt>: Flag (0 or 1) to request that any in-band forward error correction data be
+  *  decoded. If no such data is available the frame is decoded as if it were lost.
+  * @returns Number of decoded samples or @ref opus_errorcodes
+  */
+OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_decode24(
+    OpusDecoder *st,
+    const unsigned char *data,
+    opus_int32 len,
+    opus_int32 *pcm,
+    int frame_size,
+    int decode_fec
+) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(4);
+
+/** Recover a lost frame from the in-band FEC of the next packet, then decode that packet.
+  * This gives the same result as calling opus_decode() on the packet with decode_fec=1
+  * and then again with decode_fec=0, but the packet is only parsed once and the SILK
+  * decoder resumes right after the LBRR data when decoding the first frame.
+  * @param [in] st <tt>OpusDecoder*</tt>: Decoder state
+  * @param [in] data <tt>char*</tt>: Input payload, the packet following the loss
+  * @param [in] len <tt>opus_int32</tt>: Number of bytes in payload
+  * @param [out] pcm_lost <tt>opus_int16*</tt>: Output signal for the lost audio (interleaved
+  *  if 2 channels). length is lost_frame_size*channels*sizeof(opus_int16)
+  * @param [in] lost_frame_size Duration of the missing audio in samples per channel. This
+  *  <b>must</b> be a multiple of 2.5 ms. Whatever the FEC data does not cover is concealed
+  *  by the PLC, as is all of it if the packet has no FEC data.
+  * @param [out] pcm <tt>opus_int16*</tt>: Output signal for the packet itself (interleaved
+  *  if 2 channels). length is frame_size*channels*sizeof(opus_int16)
+  * @param [in] frame_size Number of samples per channel of available space in \a pcm.
+  * @returns Number of samples decoded into \a pcm or @ref opus_errorcodes
+  */
+OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_decode_recover(
+    OpusDecoder *st,
+    const unsigned char *data,
+    opus_int32 len,
+    opus_int16 *pcm_lost,
+    int lost_frame_size,
+    opus_int16 *pcm,
+    int frame_size
+) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(4) OPUS_ARG_NONNULL(6);
+
+/** Recover a lost frame from the in-band FEC of the next packet, then decode that packet,
+  * with floating point output.
+  * See opus_decode_recover() for details.
+  * @param [in] st <tt>OpusDecoder*</tt>: Decoder state
+  * @param [in] data <tt>char*</tt>: Input payload, the packet following the loss
+  * @param [in] len <tt>opus_int32</tt>: Number of bytes in payload
+  * @param [out] pcm_lost <tt>float*</tt>: Output signal for the lost audio (interleaved
+  *  if 2 channels). length is lost_frame_size*channels*sizeof(float)
+  * @param [in] lost_frame_size Duration of the missing audio in samples per channel. This
+  *  <b>must</b> be a multiple of 2.5 ms.
+  * @param [out] pcm <tt>float*</tt>: Output signal for the packet itself (interleaved
+  *  if 2 channels). length is frame_size*channels*sizeof(float)
+  * @param [in] frame_size Number of samples per channel of available space in \a pcm.
+  * @returns Number of samples decoded into \a pcm or @ref opus_errorcodes
+  */
+OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_decode_recover_float(
+    OpusDecoder *st,
+    const unsigned char *data,
+    opus_int32 len,
+    float *pcm_lost,
+    int lost_frame_size,
+    float *pcm,
+    int frame_size
+) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(4) OPUS_ARG_NONNULL(6);
+
 /** Perform a CTL function on an Opus decoder.
   *
   * Generally the request and subsequent arguments are generated
@@ -533,6 +729,117 @@ OPUS_EXPORT int opus_packet_parse(
    int *payload_offset
 ) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(5);
 
+/** Iterator over the frames of an Opus packet.
+  * It lives on the caller's stack and is filled in by opus_packet_iter_init().
+  * The public fields describe the current packet and may be read directly; the
+  * remaining fields are private and must not be modified.
+  * Unlike opus_packet_parse(), the frame sizes are not copied into arrays: each
+  * call to opus_packet_iter_next() reads the next one from the packet itself.
+  */
+typedef struct OpusPacketIter {
+   const unsigned char *data;  /**< First byte (TOC) of the current packet */
+   opus_int32 len;             /**< Number of bytes available from \a data */
+   opus_int32 packet_len;      /**< Size of the current packet in bytes, including padding.
+                                    The next stream of a multistream packet starts at data+packet_len */
+   opus_int32 padding;         /**< Number of padding bytes in the current packet */
+   int payload_offset;         /**< Offset of the first frame from \a data */
+   int nb_frames;              /**< Number of frames in the current packet */
+   unsigned char toc;          /**< TOC byte of the current packet */
+   /* Private fields */
+   unsigned char vbr;
+   opus_int16 last_size;
+   int frame;
+   opus_int32 frame_offset;
+   opus_int32 size_offset;
+   opus_int32 size_start;
+} OpusPacketIter;
+
+/** Validate an Opus packet and set up an iterator over its frames.
+  * The packet is checked in full, so iterating over it afterwards cannot fail.
+  * @param [out] it <tt>OpusPacketIter*</tt>: Iterator to initialize
+  * @param [in] data <tt>char*</tt>: Opus packet
+  * @param [in] len <tt>opus_int32</tt>: Number of bytes available in \a data
+  * @param [in] self_delimited <tt>int</tt>: Whether the packet uses self-delimited framing, as
+  *  every stream but the last one of a multistream packet does
+  * @returns number of frames or @ref opus_errorcodes
+  */
+OPUS_EXPORT int opus_packet_iter_init(
+   OpusPacketIter *it,
+   const unsigned char *data,
+   opus_int32 len,
+   int self_delimited
+) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(2);
+
+/** Return the next frame of the packet.
+  * @param [in,out] it <tt>OpusPacketIter*</tt>: Iterator
+  * @param [out] offset <tt>opus_int32*</tt>: Offset of the frame from <tt>it->data</tt>
+  * @param [out] size <tt>opus_int16*</tt>: Size of the frame in bytes
+  * @returns 1 if a frame was returned, 0 once all frames have been returned
+  */
+OPUS_EXPORT int opus_packet_iter_next(
+   OpusPacketIter *it,
+   opus_int32 *offset,
+   opus_int16 *size
+) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(2) OPUS_ARG_NONNULL(3);
+
+/** Restart the iteration at the first frame of the current packet.
+  * @param [in,out] it <tt>OpusPacketIter*</tt>: Iterator
+  */
+OPUS_EXPORT void opus_packet_iter_rewind(OpusPacketIter *it) OPUS_ARG_NONNULL(1);
+
+/** Move the iterator to the packet following the current one, e.g. to the next
+  * stream of a multistream packet.
+  * @param [in,out] it <tt>OpusPacketIter*</tt>: Iterator
+  * @param [in] self_delimited <tt>int</tt>: Whether the next packet uses self-delimited framing
+  * @returns number of frames in the next packet or @ref opus_errorcodes. The iterator
+  *  is left unchanged on failure.
+  */
+OPUS_EXPORT int opus_packet_iter_next_stream(
+   OpusPacketIter *it,
+   int self_delimited
+) OPUS_ARG_NONNULL(1);
+
+/** Decode a packet that was already parsed with opus_packet_iter_init().
+  * This behaves like opus_decode() on the same packet, without parsing it again.
+  * The iterator is not modified and may be at any frame.
+  * @param [in] st <tt>OpusDecoder*</tt>: Decoder state
+  * @param [in] it <tt>OpusPacketIter*</tt>: Iterator over the packet to decode
+  * @param [out] pcm <tt>opus_int16*</tt>: Output signal (interleaved if 2 channels). length
+  *  is frame_size*channels*sizeof(opus_int16)
+  * @param [in] frame_size Number of samples per channel of available space in \a pcm.
+  *  See opus_decode().
+  * @param [in] decode_fec <tt>int</tt>: Flag (0 or 1) to request that any in-band forward error correction data be
+  *  decoded. If no such data is available, the frame is decoded as if it were lost.
+  * @returns Number of decoded samples or @ref opus_errorcodes
+  */
+OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_decode_parsed(
+    OpusDecoder *st,
+    const OpusPacketIter *it,
+    opus_int16 *pcm,
+    int frame_size,
+    int decode_fec
+) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(2) OPUS_ARG_NONNULL(3);
+
+/** Decode a packet that was already parsed with opus_packet_iter_init(), with
+  * floating point output.
+  * @param [in] st <tt>OpusDecoder*</tt>: Decoder state
+  * @param [in] it <tt>OpusPacketIter*</tt>: Iterator over the packet to decode
+  * @param [out] pcm <tt>float*</tt>: Output signal (interleaved if 2 channels). length
+  *  is frame_size*channels*sizeof(float)
+  * @param [in] frame_size Number of samples per channel of available space in \a pcm.
+  *  See opus_decode_float().
+  * @param [in] decode_fec <tt>int</tt>: Flag (0 or 1) to request that any in-band forward error correction data be
+  *  decoded. If no such data is available, the frame is decoded as if it were lost.
+  * @returns Number of decoded samples or @ref opus_errorcodes
+  */
+OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_decode_parsed_float(
+    OpusDecoder *st,
+    const OpusPacketIter *it,
+    float *pcm,
+    int frame_size,
+    int decode_fec
+) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(2) OPUS_ARG_NONNULL(3);
+
 /** Gets the bandwidth of an Opus packet.
   * @param [in] data <tt>char*</tt>: Opus packet
   * @retval OPUS_BANDWIDTH_NARROWBAND Narrowband (4kHz bandpass)
@@ -593,6 +900,36 @@ OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_packet_get_nb_samples(const unsigne
   */
 OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_decoder_get_nb_samples(const OpusDecoder *dec, const unsigned char packet[], opus_int32 len) OPUS_ARG_NONNULL(1) OPUS_ARG_NONNULL(2);
 
+/** Number of elements of the state memory used by opus_packet_get_activity(). */
+#define OPUS_ACTIVITY_MEM_SIZE 42
+
+/** Estimates the activity and level of each frame of an Opus packet without
+  * decoding it.
+  * Only the packet headers, the SILK VAD flags and gains and the CELT coarse
+  * band energies are parsed, which makes this much cheaper than
+  * opus_decode() and suitable for tasks like active speaker selection in a
+  * mixer. The levels are approximate: for SILK and hybrid frames they are
+  * derived from the quantization gain of the first SILK frame (of the first
+  * LBRR frame when the packet carries FEC data), and for CELT frames from
+  * the coarse energy, so they are intended for ranking streams
+  * rather than metering. The state memory holds the CELT energy prediction
+  * for one stream and must be initialized to zero; the estimate drifts
+  * slightly if packets are skipped, and re-converges within a few frames.
+  * @param [in] data <tt>char*</tt>: Opus packet
+  * @param [in] len <tt>opus_int32</tt>: Length of packet
+  * @param [out] activity <tt>unsigned char*</tt>: 1 for each frame that carries
+  *                                               active signal, 0 otherwise
+  * @param [out] level <tt>opus_int16*</tt>: Estimated level of each frame in
+  *                                        dB relative to full scale (Q8), or
+  *                                        -32768 for DTX frames
+  * @param [in,out] mem <tt>opus_int16*</tt>: State memory (#OPUS_ACTIVITY_MEM_SIZE
+  *                                         values, initialized to zero)
+  * @returns Number of frames in the packet
+  * @retval OPUS_BAD_ARG Insufficient data was passed to the function
+  * @retval OPUS_INVALID_PACKET The compressed data passed is corrupted or of an unsupported type
+  */
+OPUS_EXPORT int opus_packet_get_activity(const unsigned char *data, opus_int32 len, unsigned char activity[48], opus_int16 level[48], opus_int16 *mem);
+
 /** Applies soft-clipping to bring a float signal within the [-1,1] range. If
   * the signal is already in that range, nothing is done. If there are values
   * outside of [-1,1], then the signal is clipped as smoothly as possible to
@@ -169,6 +169,13 @@ extern "C" {
 #define OPUS_SET_PHASE_INVERSION_DISABLED_REQUEST 4046
 #define OPUS_GET_PHASE_INVERSION_DISABLED_REQUEST 4047
 #define OPUS_GET_IN_DTX_REQUEST              4049
+#define OPUS_SET_BANDLIMITED_DECODE_REQUEST  4050
+#define OPUS_GET_BANDLIMITED_DECODE_REQUEST  4051
+#define OPUS_SET_PLC_COMPLEXITY_REQUEST      4052
+#define OPUS_GET_PLC_COMPLEXITY_REQUEST      4053
+#define OPUS_GET_PROFILE_REQUEST             4054
+#define OPUS_SET_CPU_BUDGET_US_REQUEST       4055
+#define OPUS_GET_CPU_BUDGET_US_REQUEST       4056
 
 /** Defines for the presence of extended APIs. */
 #define OPUS_HAVE_OPUS_PROJECTION_H
@@ -178,6 +185,7 @@ extern "C" {
 #define __opus_check_int_ptr(ptr) ((ptr) + ((ptr) - (opus_int32*)(ptr)))
 #define __opus_check_uint_ptr(ptr) ((ptr) + ((ptr) - (opus_uint32*)(ptr)))
 #define __opus_check_val16_ptr(ptr) ((ptr) + ((ptr) - (opus_val16*)(ptr)))
+#define __opus_check_uint64_ptr(ptr) ((ptr) + ((ptr) - (opus_uint64*)(ptr)))
 /** @endcond */
 
 /** @defgroup opus_ctlvalues Pre-defined values for CTL interface
@@ -217,6 +225,28 @@ extern "C" {
 #define OPUS_FRAMESIZE_100_MS                5008 /**< Use 100 ms frames */
 #define OPUS_FRAMESIZE_120_MS                5009 /**< Use 120 ms frames */
 
+/* Flags for opus_encoder_get_size_ext(), opus_encoder_init_ext() and opus_encoder_create_ext() */
+#define OPUS_ENCODER_NO_ANALYSIS                1 /**< Leave out the tonality/speech-music analysis state */
+
+/* Stages reported by OPUS_GET_PROFILE */
+#define OPUS_PROFILE_ENC_ANALYSIS               0 /**< Tonality and bandwidth analysis */
+#define OPUS_PROFILE_ENC_HP_FILTER              1 /**< High-pass/DC rejection filter */
+#define OPUS_PROFILE_ENC_SILK_PITCH             2 /**< SILK pitch analysis */
+#define OPUS_PROFILE_ENC_SILK_LPC               3 /**< SILK noise shaping and prediction analysis */
+#define OPUS_PROFILE_ENC_SILK_NSQ               4 /**< SILK noise shaping quantization */
+#define OPUS_PROFILE_ENC_CELT_MDCT              5 /**< CELT forward MDCT */
+#define OPUS_PROFILE_ENC_CELT_TRANSIENT         6 /**< CELT transient analysis */
+#define OPUS_PROFILE_ENC_CELT_TF                7 /**< CELT time-frequency resolution analysis */
+#define OPUS_PROFILE_ENC_CELT_DYNALLOC          8 /**< CELT dynamic allocation analysis */
+#define OPUS_PROFILE_ENC_CELT_BANDS             9 /**< CELT band quantization (PVQ) */
+#define OPUS_PROFILE_ENC_RANGE_CODING          10 /**< SILK index/pulse and CELT energy coding */
+#define OPUS_PROFILE_DEC_SILK                  11 /**< SILK decoding */
+#define OPUS_PROFILE_DEC_CELT_UNQUANT          12 /**< CELT energy and band decoding */
+#define OPUS_PROFILE_DEC_CELT_SYNTHESIS        13 /**< CELT inverse MDCT, postfilter and de-emphasis */
+#define OPUS_PROFILE_DEC_PLC                   14 /**< SILK and CELT packet loss concealment */
+#define OPUS_PROFILE_DEC_RESAMPLING            15 /**< SILK output resampling */
+#define OPUS_PROFILE_STAGES                    16 /**< Number of entries filled in by OPUS_GET_PROFILE */
+
 /**@}*/
 
 
@@ -258,6 +288,34 @@ extern "C" {
   * @hideinitializer */
 #define OPUS_GET_COMPLEXITY(x) OPUS_GET_COMPLEXITY_REQUEST, __opus_check_int_ptr(x)
 
+/** Configures a per-frame CPU time budget for the encoder.
+  * When non-zero, the encoder measures the wall-clock time of each call to
+  * opus_encode() or opus_encode_float() and adapts its complexity to stay
+  * within the budget. The complexity is lowered one step at a time while the
+  * average time per frame is over the budget, and raised again (never above
+  * the value set with @ref OPUS_SET_COMPLEXITY) once it falls well under it,
+  * more slowly after an increase that had to be undone. Changes take effect
+  * at frame boundaries, like @ref OPUS_SET_COMPLEXITY.
+  * The complexity actually used for each frame is reported in the
+  * <code>complexity</code> field of #OpusEncoderFrameInfo.
+  * For a multistream encoder, the budget applies to each stream.
+  * The time comes from a monotonic wall clock (QueryPerformanceCounter() on
+  * Windows, clock_gettime() with CLOCK_MONOTONIC elsewhere). Where there is
+  * none, a non-zero budget returns @ref OPUS_UNIMPLEMENTED.
+  * @see OPUS_GET_CPU_BUDGET_US
+  * @param[in] x <tt>opus_int32</tt>: Budget in microseconds per frame,
+  *                                   from 0 to 1000000. The default, 0,
+  *                                   keeps the complexity fixed.
+  *
+  * @hideinitializer */
+#define OPUS_SET_CPU_BUDGET_US(x) OPUS_SET_CPU_BUDGET_US_REQUEST, __opus_check_int(x)
+/** Gets the encoder's per-frame CPU time budget.
+  * @see OPUS_SET_CPU_BUDGET_US
+  * @param[out] x <tt>opus_int32 *</tt>: Returns the budget in microseconds
+  *                                      per frame, or 0 if disabled.
+  * @hideinitializer */
+#define OPUS_GET_CPU_BUDGET_US(x) OPUS_GET_CPU_BUDGET_US_REQUEST, __opus_check_int_ptr(x)
+
 /** Configures the bitrate in the encoder.
   * Rates from 500 to 512000 bits per second are meaningful, as well as the
   * special values #OPUS_AUTO and #OPUS_BITRATE_MAX.
@@ -726,6 +784,20 @@ extern "C" {
   * </dl>
   * @hideinitializer */
 #define OPUS_GET_IN_DTX(x) OPUS_GET_IN_DTX_REQUEST, __opus_check_int_ptr(x)
+/** Gets the time spent in each major processing stage since the encoder or
+  * decoder was initialized or last reset with @ref OPUS_RESET_STATE.
+  * This is only available when the library was configured with
+  * --enable-profiling; otherwise it returns @ref OPUS_UNIMPLEMENTED.
+  * Times are in ticks of the fastest timer available: CPU cycles (TSC) on
+  * x86 and nanoseconds elsewhere. Stages that do not apply to the object
+  * being queried are reported as zero. Multistream and projection objects
+  * report the sum over all their streams.
+  * @param[out] x <tt>opus_uint64 *</tt>: Array of @ref OPUS_PROFILE_STAGES
+  *                                      entries, indexed by the
+  *                                      <code>OPUS_PROFILE_*</code> stage
+  *                                      values.
+  * @hideinitializer */
+#define OPUS_GET_PROFILE(x) OPUS_GET_PROFILE_REQUEST, __opus_check_uint64_ptr(x)
 
 /**@}*/
 
@@ -768,6 +840,59 @@ extern "C" {
   * @hideinitializer */
 #define OPUS_GET_PITCH(x) OPUS_GET_PITCH_REQUEST, __opus_check_int_ptr(x)
 
+/** If set to 1, a decoder running at a sampling rate below 48 kHz skips the
+  * reconstruction of the CELT bands that lie entirely above its Nyquist
+  * frequency. Those bands are still parsed, and the range decoder, the
+  * noise seed and the collapse masks advance exactly as in the normal
+  * decoder, but their PVQ vectors are not expanded into spectra that the
+  * downsampling would discard. This lowers the cost of decoding fullband
+  * streams for narrower outputs. The decoded audio and the final range are
+  * bit-identical to those of the normal decoder.
+  * This has no effect on decoders running at 48 kHz.
+  * @see OPUS_GET_BANDLIMITED_DECODE
+  * @param[in] x <tt>opus_int32</tt>: Allowed values:
+  * <dl>
+  * <dt>0</dt><dd>Reconstruct all bands (default).</dd>
+  * <dt>1</dt><dd>Skip the bands above the output bandwidth.</dd>
+  * </dl>
+  * @hideinitializer */
+#define OPUS_SET_BANDLIMITED_DECODE(x) OPUS_SET_BANDLIMITED_DECODE_REQUEST, __opus_check_int(x)
+/** Gets the decoder's configured band-limited decoding mode.
+  * @see OPUS_SET_BANDLIMITED_DECODE
+  * @param[out] x <tt>opus_int32 *</tt>: Returns one of the following values:
+  * <dl>
+  * <dt>0</dt><dd>All bands are reconstructed (default).</dd>
+  * <dt>1</dt><dd>Bands above the output bandwidth are skipped.</dd>
+  * </dl>
+  * @hideinitializer */
+#define OPUS_GET_BANDLIMITED_DECODE(x) OPUS_GET_BANDLIMITED_DECODE_REQUEST, __opus_check_int_ptr(x)
+
+/** Configures the decoder's computational complexity for packet loss
+  * concealment.
+  * The supported range is 0-10 inclusive with 10 representing the highest
+  * complexity. Lower values bound the cost of concealing the first lost
+  * frame after a good one, which otherwise requires a pitch search over
+  * the decoded history:
+  * <dl>
+  * <dt>5-10</dt><dd>Search for the pitch of the decoded signal (default).</dd>
+  * <dt>1-4</dt> <dd>Reuse the post-filter period of the last good frame as the
+  *                  pitch, and use noise-based concealment if there is none.</dd>
+  * <dt>0</dt>   <dd>Always use noise-based concealment.</dd>
+  * </dl>
+  * This only affects the CELT layer; SILK concealment is already based on
+  * the parameters of the last good frame.
+  * @see OPUS_GET_PLC_COMPLEXITY
+  * @param[in] x <tt>opus_int32</tt>: Allowed values: 0-10, inclusive.
+  *
+  * @hideinitializer */
+#define OPUS_SET_PLC_COMPLEXITY(x) OPUS_SET_PLC_COMPLEXITY_REQUEST, __opus_check_int(x)
+/** Gets the decoder's packet loss concealment complexity configuration.
+  * @see OPUS_SET_PLC_COMPLEXITY
+  * @param[out] x <tt>opus_int32 *</tt>: Returns a value in the range 0-10,
+  *                                      inclusive.
+  * @hideinitializer */
+#define OPUS_GET_PLC_COMPLEXITY(x) OPUS_GET_PLC_COMPLEXITY_REQUEST, __opus_check_int_ptr(x)
+
 /**@}*/
 
 /** @defgroup opus_libinfo Opus library information functions
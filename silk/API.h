@@ -59,6 +59,16 @@ opus_int silk_Get_Encoder_Size(                         /* O    Returns error co
     opus_int                        *encSizeBytes       /* O    Number of bytes in SILK encoder state           */
 );
 
+#ifdef ENABLE_PROFILING
+/***********************************************************/
+/* Add the per-stage times of the SILK encoder to profile  */
+/***********************************************************/
+void silk_Get_Encoder_Profile(
+    const void                      *encState,          /* I    State                                           */
+    opus_uint64                     *profile            /* I/O  Per-stage times [ OPUS_PROFILE_STAGES ]         */
+);
+#endif
+
 /*************************/
 /* Init or reset encoder */
 /*************************/
@@ -95,6 +105,16 @@ opus_int silk_Get_Decoder_Size(                         /* O    Returns error co
     opus_int                        *decSizeBytes       /* O    Number of bytes in SILK decoder state           */
 );
 
+#ifdef ENABLE_PROFILING
+/***********************************************************/
+/* Add the per-stage times of the SILK decoder to profile  */
+/***********************************************************/
+void silk_Get_Decoder_Profile(
+    const void                      *decState,          /* I    State                                           */
+    opus_uint64                     *profile            /* I/O  Per-stage times [ OPUS_PROFILE_STAGES ]         */
+);
+#endif
+
 /*************************/
 /* Init or Reset decoder */
 /*************************/
@@ -108,7 +128,7 @@ opus_int silk_InitDecoder(                              /* O    Returns error co
 opus_int silk_Decode(                                   /* O    Returns error code                              */
     void*                           decState,           /* I/O  State                                           */
     silk_DecControlStruct*          decControl,         /* I/O  Control Structure                               */
-    opus_int                        lostFlag,           /* I    0: no loss, 1 loss, 2 decode fec                */
+    opus_int                        lostFlag,           /* I    0: no loss, 1 loss, 2 decode fec, 3 after fec   */
     opus_int                        newPacketFlag,      /* I    Indicates first decoder call for this packet    */
     ec_dec                          *psRangeDec,        /* I/O  Compressor data structure                       */
     opus_int16                      *samplesOut,        /* O    Decoded output speech vector                    */
@@ -116,6 +136,16 @@ opus_int silk_Decode(                                   /* O    Returns error co
     int                             arch                /* I    Run-time architecture                           */
 );
 
+/*****************************************************/
+/* Get voice activity and first frame gain of packet */
+/*****************************************************/
+opus_int silk_Get_Activity(                             /* O    Returns error code                              */
+    const silk_DecControlStruct     *decControl,        /* I    Control Structure                               */
+    ec_dec                          *psRangeDec,        /* I/O  Compressor data structure                       */
+    opus_int                        *VADFlag,           /* O    Voice activity for packet (mid channel)         */
+    opus_int32                      *gain_Q16           /* O    Largest subframe gain of the first frame        */
+);
+
 #if 0
 /**************************************/
 /* Get table of contents for a packet */
@@ -39,6 +39,10 @@ extern "C"
 #define FLAG_DECODE_NORMAL                      0
 #define FLAG_PACKET_LOST                        1
 #define FLAG_DECODE_LBRR                        2
+/* Regular decoding of a packet whose LBRR frames were all just decoded with */
+/* FLAG_DECODE_LBRR from the same range decoder: the header and LBRR data    */
+/* have already been consumed                                               */
+#define FLAG_DECODE_AFTER_LBRR                  3
 
 /***********************************************/
 /* Structure for controlling encoder operation */
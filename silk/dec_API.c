@@ -32,6 +32,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "main.h"
 #include "stack_alloc.h"
 #include "os_support.h"
+#include "profile.h"
 
 /************************/
 /* Decoder Super Struct */
@@ -59,6 +60,24 @@ opus_int silk_Get_Decoder_Size(                         /* O    Returns error co
     return ret;
 }
 
+#ifdef ENABLE_PROFILING
+/* Add per-stage times of all channels */
+void silk_Get_Decoder_Profile(
+    const void                      *decState,          /* I    State                                           */
+    opus_uint64                     *profile            /* I/O  Per-stage times [ OPUS_PROFILE_STAGES ]         */
+)
+{
+    opus_int n, i;
+    const silk_decoder_state *channel_state = ((const silk_decoder *)decState)->channel_state;
+
+    for( n = 0; n < DECODER_NUM_CHANNELS; n++ ) {
+        for( i = 0; i < OPUS_PROFILE_STAGES; i++ ) {
+            profile[ i ] += channel_state[ n ].profile[ i ];
+        }
+    }
+}
+#endif
+
 /* Reset decoder state */
 opus_int silk_InitDecoder(                              /* O    Returns error code                              */
     void                            *decState           /* I/O  State                                           */
@@ -81,7 +100,7 @@ opus_int silk_InitDecoder(                              /* O    Returns error co
 opus_int silk_Decode(                                   /* O    Returns error code                              */
     void*                           decState,           /* I/O  State                                           */
     silk_DecControlStruct*          decControl,         /* I/O  Control Structure                               */
-    opus_int                        lostFlag,           /* I    0: no loss, 1 loss, 2 decode fec                */
+    opus_int                        lostFlag,           /* I    0: no loss, 1 loss, 2 decode fec, 3 after fec   */
     opus_int                        newPacketFlag,      /* I    Indicates first decoder call for this packet    */
     ec_dec                          *psRangeDec,        /* I/O  Compressor data structure                       */
     opus_int16                      *samplesOut,        /* O    Decoded output speech vector                    */
@@ -90,6 +109,7 @@ opus_int silk_Decode(                                   /* O    Returns error co
 )
 {
     opus_int   i, n, decode_only_middle = 0, ret = SILK_NO_ERROR;
+    opus_int   header_decoded = 0;
     opus_int32 nSamplesOutDec, LBRR_symbol;
     opus_int16 *samplesOut1_tmp[ 2 ];
     VARDECL( opus_int16, samplesOut1_tmp_storage1 );
@@ -106,6 +126,11 @@ opus_int silk_Decode(                                   /* O    Returns error co
 
     celt_assert( decControl->nChannelsInternal == 1 || decControl->nChannelsInternal == 2 );
 
+    if( lostFlag == FLAG_DECODE_AFTER_LBRR ) {
+        header_decoded = 1;
+        lostFlag = FLAG_DECODE_NORMAL;
+    }
+
     /**********************************/
     /* Test if first frame in payload */
     /**********************************/
@@ -171,7 +196,7 @@ opus_int silk_Decode(                                   /* O    Returns error co
         return( ret );
     }
 
-    if( lostFlag != FLAG_PACKET_LOST && channel_state[ 0 ].nFramesDecoded == 0 ) {
+    if( lostFlag != FLAG_PACKET_LOST && channel_state[ 0 ].nFramesDecoded == 0 && !header_decoded ) {
         /* First decoder call for this payload */
         /* Decode VAD flags and LBRR flag */
         for( n = 0; n < decControl->nChannelsInternal; n++ ) {
@@ -297,7 +322,8 @@ opus_int silk_Decode(                                   /* O    Returns error co
             } else {
                 condCoding = CODE_CONDITIONALLY;
             }
-            ret += silk_decode_frame( &channel_state[ n ], psRangeDec, &samplesOut1_tmp[ n ][ 2 ], &nSamplesOutDec, lostFlag, condCoding, arch);
+            OPUS_PROFILE( channel_state[ n ].profile, lostFlag == FLAG_PACKET_LOST ? OPUS_PROFILE_DEC_PLC : OPUS_PROFILE_DEC_SILK,
+                ret += silk_decode_frame( &channel_state[ n ], psRangeDec, &samplesOut1_tmp[ n ][ 2 ], &nSamplesOutDec, lostFlag, condCoding, arch) );
         } else {
             silk_memset( &samplesOut1_tmp[ n ][ 2 ], 0, nSamplesOutDec * sizeof( opus_int16 ) );
         }
@@ -337,7 +363,8 @@ opus_int silk_Decode(                                   /* O    Returns error co
     for( n = 0; n < silk_min( decControl->nChannelsAPI, decControl->nChannelsInternal ); n++ ) {
 
         /* Resample decoded signal to API_sampleRate */
-        ret += silk_resampler( &channel_state[ n ].resampler_state, resample_out_ptr, &samplesOut1_tmp[ n ][ 1 ], nSamplesOutDec );
+        OPUS_PROFILE( channel_state[ n ].profile, OPUS_PROFILE_DEC_RESAMPLING,
+            ret += silk_resampler( &channel_state[ n ].resampler_state, resample_out_ptr, &samplesOut1_tmp[ n ][ 1 ], nSamplesOutDec ) );
 
         /* Interleave if stereo output and stereo stream */
         if( decControl->nChannelsAPI == 2 ) {
@@ -352,7 +379,8 @@ opus_int silk_Decode(                                   /* O    Returns error co
         if ( stereo_to_mono ){
             /* Resample right channel for newly collapsed stereo just in case
                we weren't doing collapsing when switching to mono */
-            ret += silk_resampler( &channel_state[ 1 ].resampler_state, resample_out_ptr, &samplesOut1_tmp[ 0 ][ 1 ], nSamplesOutDec );
+            OPUS_PROFILE( channel_state[ 1 ].profile, OPUS_PROFILE_DEC_RESAMPLING,
+                ret += silk_resampler( &channel_state[ 1 ].resampler_state, resample_out_ptr, &samplesOut1_tmp[ 0 ][ 1 ], nSamplesOutDec ) );
 
             for( i = 0; i < *nSamplesOut; i++ ) {
                 samplesOut[ 1 + 2 * i ] = resample_out_ptr[ i ];
@@ -384,6 +412,108 @@ opus_int silk_Decode(                                   /* O    Returns error co
     return ret;
 }
 
+/* Parse the packet header and the gains of the first coded frame, without setting up a decoder state */
+opus_int silk_Get_Activity(                             /* O    Returns error code                              */
+    const silk_DecControlStruct     *decControl,        /* I    Control Structure                               */
+    ec_dec                          *psRangeDec,        /* I/O  Compressor data structure                       */
+    opus_int                        *VADFlag,           /* O    Voice activity for packet (mid channel)         */
+    opus_int32                      *gain_Q16           /* O    Largest subframe gain of the first frame        */
+)
+{
+    opus_int   i, n, Ix, signalType, nFramesPerPacket, nb_subfr, decode_only_middle, LBRR_frame = 0;
+    opus_int32 LBRR_symbol, MS_pred_Q13[ 2 ];
+    opus_int32 Gains_Q16[ MAX_NB_SUBFR ];
+    opus_int8  GainsIndices[ MAX_NB_SUBFR ];
+    opus_int8  LastGainIndex = 10;
+    opus_int   VAD_flags[ DECODER_NUM_CHANNELS ][ MAX_FRAMES_PER_PACKET ];
+    opus_int   LBRR_flags[ DECODER_NUM_CHANNELS ][ MAX_FRAMES_PER_PACKET ];
+    opus_int   LBRR_flag[ DECODER_NUM_CHANNELS ];
+
+    celt_assert( decControl->nChannelsInternal == 1 || decControl->nChannelsInternal == 2 );
+
+    if( decControl->payloadSize_ms == 10 ) {
+        nFramesPerPacket = 1;
+        nb_subfr = 2;
+    } else if( decControl->payloadSize_ms == 20 || decControl->payloadSize_ms == 40 || decControl->payloadSize_ms == 60 ) {
+        nFramesPerPacket = decControl->payloadSize_ms / 20;
+        nb_subfr = 4;
+    } else {
+        return SILK_DEC_INVALID_FRAME_SIZE;
+    }
+
+    /* Decode VAD flags and LBRR flag */
+    *VADFlag = 0;
+    for( n = 0; n < decControl->nChannelsInternal; n++ ) {
+        for( i = 0; i < nFramesPerPacket; i++ ) {
+            VAD_flags[ n ][ i ] = ec_dec_bit_logp( psRangeDec, 1 );
+            if( n == 0 ) {
+                *VADFlag |= VAD_flags[ n ][ i ];
+            }
+        }
+        LBRR_flag[ n ] = ec_dec_bit_logp( psRangeDec, 1 );
+    }
+    /* Decode LBRR flags */
+    for( n = 0; n < decControl->nChannelsInternal; n++ ) {
+        for( i = 0; i < nFramesPerPacket; i++ ) {
+            LBRR_flags[ n ][ i ] = 0;
+        }
+        if( LBRR_flag[ n ] ) {
+            LBRR_frame = 1;
+            if( nFramesPerPacket == 1 ) {
+                LBRR_flags[ n ][ 0 ] = 1;
+            } else {
+                LBRR_symbol = ec_dec_icdf( psRangeDec, silk_LBRR_flags_iCDF_ptr[ nFramesPerPacket - 2 ], 8 ) + 1;
+                for( i = 0; i < nFramesPerPacket; i++ ) {
+                    LBRR_flags[ n ][ i ] = silk_RSHIFT( LBRR_symbol, i ) & 1;
+                }
+            }
+        }
+    }
+
+    /* Skipping the LBRR data would mean parsing its LSFs, pitch and pulses, so when
+       there is any, use the gains of the first LBRR frame, which come first in it.
+       They belong to earlier audio and are coded slightly higher than the regular
+       frames, which is good enough for an estimate. */
+    n = 0;
+    i = 0;
+    if( LBRR_frame ) {
+        for( i = 0; i < nFramesPerPacket; i++ ) {
+            if( LBRR_flags[ 0 ][ i ] || ( decControl->nChannelsInternal == 2 && LBRR_flags[ 1 ][ i ] ) ) {
+                break;
+            }
+        }
+        n = LBRR_flags[ 0 ][ i ] ? 0 : 1;
+    }
+
+    /* Stereo prediction of the mid channel */
+    if( decControl->nChannelsInternal == 2 && n == 0 ) {
+        silk_stereo_decode_pred( psRangeDec, MS_pred_Q13 );
+        if( ( LBRR_frame ? LBRR_flags[ 1 ][ i ] : VAD_flags[ 1 ][ i ] ) == 0 ) {
+            silk_stereo_decode_mid_only( psRangeDec, &decode_only_middle );
+        }
+    }
+
+    /* Signal type and gains, as at the start of silk_decode_indices() */
+    if( LBRR_frame || VAD_flags[ n ][ i ] ) {
+        Ix = ec_dec_icdf( psRangeDec, silk_type_offset_VAD_iCDF, 8 ) + 2;
+    } else {
+        Ix = ec_dec_icdf( psRangeDec, silk_type_offset_no_VAD_iCDF, 8 );
+    }
+    signalType = silk_RSHIFT( Ix, 1 );
+    GainsIndices[ 0 ]  = (opus_int8)silk_LSHIFT( ec_dec_icdf( psRangeDec, silk_gain_iCDF[ signalType ], 8 ), 3 );
+    GainsIndices[ 0 ] += (opus_int8)ec_dec_icdf( psRangeDec, silk_uniform8_iCDF, 8 );
+    for( i = 1; i < nb_subfr; i++ ) {
+        GainsIndices[ i ] = (opus_int8)ec_dec_icdf( psRangeDec, silk_delta_gain_iCDF, 8 );
+    }
+    silk_gains_dequant( Gains_Q16, GainsIndices, &LastGainIndex, 0, nb_subfr );
+    *gain_Q16 = 0;
+    for( i = 0; i < nb_subfr; i++ ) {
+        *gain_Q16 = silk_max_32( *gain_Q16, Gains_Q16[ i ] );
+    }
+
+    return SILK_NO_ERROR;
+}
+
 #if 0
 /* Getting table of contents for a packet */
 opus_int silk_get_TOC(
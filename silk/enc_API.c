@@ -64,6 +64,26 @@ opus_int silk_Get_Encoder_Size(                         /* O    Returns error co
     return ret;
 }
 
+#ifdef ENABLE_PROFILING
+/*******************************************/
+/* Add per-stage times of all channels     */
+/*******************************************/
+void silk_Get_Encoder_Profile(
+    const void                      *encState,          /* I    State                                           */
+    opus_uint64                     *profile            /* I/O  Per-stage times [ OPUS_PROFILE_STAGES ]         */
+)
+{
+    opus_int n, i;
+    const silk_encoder *psEnc = (const silk_encoder *)encState;
+
+    for( n = 0; n < ENCODER_NUM_CHANNELS; n++ ) {
+        for( i = 0; i < OPUS_PROFILE_STAGES; i++ ) {
+            profile[ i ] += psEnc->state_Fxx[ n ].sCmn.profile[ i ];
+        }
+    }
+}
+#endif
+
 /*************************/
 /* Init or Reset encoder */
 /*************************/
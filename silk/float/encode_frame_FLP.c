@@ -32,6 +32,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <stdlib.h>
 #include "main_FLP.h"
 #include "tuning_parameters.h"
+#include "profile.h"
 
 /* Low Bitrate Redundancy (LBRR) encoding. Reuse all parameters but encode with lower bitrate */
 static OPUS_INLINE void silk_LBRR_encode_FLP(
@@ -139,17 +140,20 @@ opus_int silk_encode_frame_FLP(
         /*****************************************/
         /* Find pitch lags, initial LPC analysis */
         /*****************************************/
-        silk_find_pitch_lags_FLP( psEnc, &sEncCtrl, res_pitch, x_frame, psEnc->sCmn.arch );
+        OPUS_PROFILE( psEnc->sCmn.profile, OPUS_PROFILE_ENC_SILK_PITCH,
+            silk_find_pitch_lags_FLP( psEnc, &sEncCtrl, res_pitch, x_frame, psEnc->sCmn.arch ) );
 
         /************************/
         /* Noise shape analysis */
         /************************/
-        silk_noise_shape_analysis_FLP( psEnc, &sEncCtrl, res_pitch_frame, x_frame );
+        OPUS_PROFILE( psEnc->sCmn.profile, OPUS_PROFILE_ENC_SILK_LPC,
+            silk_noise_shape_analysis_FLP( psEnc, &sEncCtrl, res_pitch_frame, x_frame ) );
 
         /***************************************************/
         /* Find linear prediction coefficients (LPC + LTP) */
         /***************************************************/
-        silk_find_pred_coefs_FLP( psEnc, &sEncCtrl, res_pitch_frame, x_frame, condCoding );
+        OPUS_PROFILE( psEnc->sCmn.profile, OPUS_PROFILE_ENC_SILK_LPC,
+            silk_find_pred_coefs_FLP( psEnc, &sEncCtrl, res_pitch_frame, x_frame, condCoding ) );
 
         /****************************************/
         /* Process gains                        */
@@ -193,7 +197,8 @@ opus_int silk_encode_frame_FLP(
                 /*****************************************/
                 /* Noise shaping quantization            */
                 /*****************************************/
-                silk_NSQ_wrapper_FLP( psEnc, &sEncCtrl, &psEnc->sCmn.indices, &psEnc->sCmn.sNSQ, psEnc->sCmn.pulses, x_frame );
+                OPUS_PROFILE( psEnc->sCmn.profile, OPUS_PROFILE_ENC_SILK_NSQ,
+                    silk_NSQ_wrapper_FLP( psEnc, &sEncCtrl, &psEnc->sCmn.indices, &psEnc->sCmn.sNSQ, psEnc->sCmn.pulses, x_frame ) );
 
                 if ( iter == maxIter && !found_lower ) {
                     silk_memcpy( &sRangeEnc_copy2, psRangeEnc, sizeof( ec_enc ) );
@@ -202,13 +207,15 @@ opus_int silk_encode_frame_FLP(
                 /****************************************/
                 /* Encode Parameters                    */
                 /****************************************/
-                silk_encode_indices( &psEnc->sCmn, psRangeEnc, psEnc->sCmn.nFramesEncoded, 0, condCoding );
+                OPUS_PROFILE( psEnc->sCmn.profile, OPUS_PROFILE_ENC_RANGE_CODING,
+                    silk_encode_indices( &psEnc->sCmn, psRangeEnc, psEnc->sCmn.nFramesEncoded, 0, condCoding ) );
 
                 /****************************************/
                 /* Encode Excitation Signal             */
                 /****************************************/
-                silk_encode_pulses( psRangeEnc, psEnc->sCmn.indices.signalType, psEnc->sCmn.indices.quantOffsetType,
-                      psEnc->sCmn.pulses, psEnc->sCmn.frame_length );
+                OPUS_PROFILE( psEnc->sCmn.profile, OPUS_PROFILE_ENC_RANGE_CODING,
+                    silk_encode_pulses( psRangeEnc, psEnc->sCmn.indices.signalType, psEnc->sCmn.indices.quantOffsetType,
+                          psEnc->sCmn.pulses, psEnc->sCmn.frame_length ) );
 
                 nBits = ec_tell( psRangeEnc );
 
@@ -231,10 +238,12 @@ opus_int silk_encode_frame_FLP(
                         psEnc->sCmn.pulses[ i ] = 0;
                     }
 
-                    silk_encode_indices( &psEnc->sCmn, psRangeEnc, psEnc->sCmn.nFramesEncoded, 0, condCoding );
+                    OPUS_PROFILE( psEnc->sCmn.profile, OPUS_PROFILE_ENC_RANGE_CODING,
+                        silk_encode_indices( &psEnc->sCmn, psRangeEnc, psEnc->sCmn.nFramesEncoded, 0, condCoding ) );
 
-                    silk_encode_pulses( psRangeEnc, psEnc->sCmn.indices.signalType, psEnc->sCmn.indices.quantOffsetType,
-                        psEnc->sCmn.pulses, psEnc->sCmn.frame_length );
+                    OPUS_PROFILE( psEnc->sCmn.profile, OPUS_PROFILE_ENC_RANGE_CODING,
+                        silk_encode_pulses( psRangeEnc, psEnc->sCmn.indices.signalType, psEnc->sCmn.indices.quantOffsetType,
+                            psEnc->sCmn.pulses, psEnc->sCmn.frame_length ) );
 
                     nBits = ec_tell( psRangeEnc );
                 }
@@ -426,8 +435,9 @@ static OPUS_INLINE void silk_LBRR_encode_FLP(
         /*****************************************/
         /* Noise shaping quantization            */
         /*****************************************/
-        silk_NSQ_wrapper_FLP( psEnc, psEncCtrl, psIndices_LBRR, &sNSQ_LBRR,
-            psEnc->sCmn.pulses_LBRR[ psEnc->sCmn.nFramesEncoded ], xfw );
+        OPUS_PROFILE( psEnc->sCmn.profile, OPUS_PROFILE_ENC_SILK_NSQ,
+            silk_NSQ_wrapper_FLP( psEnc, psEncCtrl, psIndices_LBRR, &sNSQ_LBRR,
+                psEnc->sCmn.pulses_LBRR[ psEnc->sCmn.nFramesEncoded ], xfw ) );
 
         /* Restore original gains */
         silk_memcpy( psEncCtrl->Gains, TempGains, psEnc->sCmn.nb_subfr * sizeof( silk_float ) );
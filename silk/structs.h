@@ -225,6 +225,10 @@ typedef struct {
     opus_int                     LBRR_GainIncreases;                /* Gains increment for coding LBRR frames                           */
     SideInfoIndices              indices_LBRR[ MAX_FRAMES_PER_PACKET ];
     opus_int8                    pulses_LBRR[ MAX_FRAMES_PER_PACKET ][ MAX_FRAME_LENGTH ];
+
+#ifdef ENABLE_PROFILING
+    opus_uint64                  profile[ OPUS_PROFILE_STAGES ];    /* Time spent per stage, see OPUS_GET_PROFILE                       */
+#endif
 } silk_encoder_state;
 
 
@@ -306,6 +310,9 @@ typedef struct {
 
     silk_PLC_struct sPLC;
 
+#ifdef ENABLE_PROFILING
+    opus_uint64                 profile[ OPUS_PROFILE_STAGES ];
+#endif
 } silk_decoder_state;
 
 /************************/
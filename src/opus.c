@@ -31,22 +31,30 @@
 
 #include "opus.h"
 #include "opus_private.h"
+#include "cpu_support.h"
+#include "mathops.h"
 
 #ifndef DISABLE_FLOAT_API
 OPUS_EXPORT void opus_pcm_soft_clip(float *_x, int N, int C, float *declip_mem)
+{
+   opus_pcm_soft_clip_impl(_x, N, C, declip_mem, opus_select_arch());
+}
+
+void opus_pcm_soft_clip_impl(float *_x, int N, int C, float *declip_mem, int arch)
 {
    int c;
    int i;
    float *x;
+   int all_within_neg1pos1;
 
    if (C<1 || N<1 || !_x || !declip_mem) return;
 
    /* First thing: saturate everything to +/- 2 which is the highest level our
       non-linearity can handle. At the point where the signal reaches +/-2,
       the derivative will be zero anyway, so this doesn't introduce any
-      discontinuity in the derivative. */
-   for (i=0;i<N*C;i++)
-      _x[i] = MAX16(-2.f, MIN16(2.f, _x[i]));
+      discontinuity in the derivative. The same pass tells us whether any
+      sample needs clipping at all, which is almost never the case. */
+   all_within_neg1pos1 = celt_limit2_checkwithin1(_x, N*C, arch);
    for (c=0;c<C;c++)
    {
       float a;
@@ -64,6 +72,14 @@ OPUS_EXPORT void opus_pcm_soft_clip(float *_x, int N, int C, float *declip_mem)
          x[i*C] = x[i*C]+a*x[i*C]*x[i*C];
       }
 
+      /* The non-linearity above only brings samples closer to zero, so
+         there is nothing left to clip. */
+      if (all_within_neg1pos1)
+      {
+         declip_mem[c] = 0;
+         continue;
+      }
+
       curr=0;
       x0 = x[0];
       while(1)
@@ -354,3 +370,90 @@ int opus_packet_parse(const unsigned char *data, opus_int32 len,
                                  frames, size, payload_offset, NULL);
 }
 
+int opus_packet_iter_init(OpusPacketIter *it, const unsigned char *data,
+      opus_int32 len, int self_delimited)
+{
+   int i;
+   int count;
+   int payload_offset;
+   unsigned char toc;
+   opus_int32 packet_offset;
+   opus_int32 total;
+   opus_int16 size[48];
+
+   count = opus_packet_parse_impl(data, len, self_delimited, &toc, NULL,
+                                  size, &payload_offset, &packet_offset);
+   if (count<0)
+      return count;
+   total = 0;
+   for (i=0;i<count;i++)
+      total += size[i];
+
+   it->data = data;
+   it->len = len;
+   it->packet_len = packet_offset;
+   it->padding = packet_offset-payload_offset-total;
+   it->payload_offset = payload_offset;
+   it->nb_frames = count;
+   it->toc = toc;
+   /* The last size is the only one that may not be coded explicitly (or is
+      coded after the others when self-delimited), and CBR frames all have
+      that size. The VBR sizes of the other frames are read back one by one
+      from the packet, starting after the TOC or after the count and padding
+      bytes. */
+   it->last_size = size[count-1];
+   if ((toc&0x3)==2)
+   {
+      it->vbr = 1;
+      it->size_start = 1;
+   } else if ((toc&0x3)==3)
+   {
+      it->vbr = (data[1]&0x80)!=0;
+      it->size_start = 2;
+      if (data[1]&0x40)
+      {
+         while (data[it->size_start++]==255);
+      }
+   } else {
+      it->vbr = 0;
+      it->size_start = 1;
+   }
+   opus_packet_iter_rewind(it);
+   return count;
+}
+
+int opus_packet_iter_next(OpusPacketIter *it, opus_int32 *offset,
+      opus_int16 *size)
+{
+   opus_int16 frame_size;
+   if (it->frame >= it->nb_frames)
+      return 0;
+   if (it->vbr && it->frame < it->nb_frames-1)
+   {
+      it->size_offset += parse_size(it->data+it->size_offset,
+            it->len-it->size_offset, &frame_size);
+   } else {
+      frame_size = it->last_size;
+   }
+   *offset = it->frame_offset;
+   *size = frame_size;
+   it->frame_offset += frame_size;
+   it->frame++;
+   return 1;
+}
+
+void opus_packet_iter_rewind(OpusPacketIter *it)
+{
+   it->frame = 0;
+   it->frame_offset = it->payload_offset;
+   it->size_offset = it->size_start;
+}
+
+int opus_packet_iter_next_stream(OpusPacketIter *it, int self_delimited)
+{
+   if (it->len-it->packet_len<=0)
+      return OPUS_INVALID_PACKET;
+   return opus_packet_iter_init(it, it->data+it->packet_len,
+         it->len-it->packet_len, self_delimited);
+}
+
@@ -0,0 +1,574 @@
+/* Copyright (c) 2026 Opus contributors */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Encode/decode throughput benchmark. Every combination of signal,
+   application, mode, bandwidth, frame size, channel count and complexity
+   selected on the command line is run over a deterministic synthetic
+   signal, and one CSV line is printed per combination. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include "opus.h"
+#include "opus_private.h"
+
+#define MAX_PACKET 1500
+#define BENCH_FS 48000
+
+#ifndef M_PI
+#define M_PI (3.141592653589793)
+#endif
+
+#define SIGNAL_SPEECH 0
+#define SIGNAL_MUSIC  1
+#define SIGNAL_NOISE  2
+
+static const char *signal_names[3] = {"speech", "music", "noise"};
+
+static const int applications[3] = {
+    OPUS_APPLICATION_VOIP,
+    OPUS_APPLICATION_AUDIO,
+    OPUS_APPLICATION_RESTRICTED_LOWDELAY
+};
+static const char *application_names[3] = {"voip", "audio", "restricted-lowdelay"};
+
+static const int modes[3] = {MODE_SILK_ONLY, MODE_HYBRID, MODE_CELT_ONLY};
+static const char *mode_names[3] = {"silk", "hybrid", "celt"};
+
+static const int bandwidths[5] = {
+    OPUS_BANDWIDTH_NARROWBAND,
+    OPUS_BANDWIDTH_MEDIUMBAND,
+    OPUS_BANDWIDTH_WIDEBAND,
+    OPUS_BANDWIDTH_SUPERWIDEBAND,
+    OPUS_BANDWIDTH_FULLBAND
+};
+static const char *bandwidth_names[5] = {"NB", "MB", "WB", "SWB", "FB"};
+
+/* Frame sizes in samples at 48 kHz, from 2.5 to 120 ms */
+static const int frame_sizes[9] = {120, 240, 480, 960, 1920, 2880, 3840, 4800, 5760};
+
+/* Default bitrates per channel, indexed by bandwidth */
+static const opus_int32 silk_rates[5] = {10000, 14000, 20000, 0, 0};
+static const opus_int32 hybrid_rates[5] = {0, 0, 0, 32000, 40000};
+static const opus_int32 celt_rates[5] = {32000, 0, 48000, 64000, 80000};
+
+static void print_usage( char* argv[] )
+{
+    fprintf(stderr, "Usage: %s [options]\n", argv[0]);
+    fprintf(stderr, "Runs every selected configuration and prints one CSV line per configuration.\n");
+    fprintf(stderr, "options (each one restricts the matrix, default: all):\n" );
+    fprintf(stderr, "-signal <speech|music|noise>                 : synthetic input signal\n" );
+    fprintf(stderr, "-application <voip|audio|restricted-lowdelay>: encoder application\n" );
+    fprintf(stderr, "-mode <silk|hybrid|celt>                     : coding mode\n" );
+    fprintf(stderr, "-bandwidth <NB|MB|WB|SWB|FB>                 : audio bandwidth\n" );
+    fprintf(stderr, "-framesize <2.5|5|10|20|40|60|80|100|120>    : frame size in ms\n" );
+    fprintf(stderr, "-complexity <0-10>                           : encoder complexity\n" );
+    fprintf(stderr, "-channels <1|2>                              : channel count\n" );
+    fprintf(stderr, "other options:\n" );
+    fprintf(stderr, "-bitrate <bps>       : bitrate override; default: depends on mode and bandwidth\n" );
+    fprintf(stderr, "-seconds <s>         : length of the signal; default: 2\n" );
+    fprintf(stderr, "-noheader            : do not print the CSV header line\n" );
+    fprintf(stderr, "-lifecycle           : instead time encoder and decoder init, copy and reset\n" );
+}
+
+static opus_uint32 lcg_rand(opus_uint32 *seed)
+{
+    *seed = 1664525 * *seed + 1013904223;
+    return *seed;
+}
+
+/* Uniform in [-1, 1) */
+static float lcg_uniform(opus_uint32 *seed)
+{
+    return (float)((opus_int32)lcg_rand(seed))*(1.f/2147483648.f);
+}
+
+/* Two-pole resonator */
+static float resonate(float x, float freq, float bw, float mem[2])
+{
+    float r, c, y;
+    r = (float)exp(-M_PI*bw/BENCH_FS);
+    c = 2*r*(float)cos(2*M_PI*freq/BENCH_FS);
+    y = (1-r)*x + c*mem[0] - r*r*mem[1];
+    mem[1] = mem[0];
+    mem[0] = y;
+    return y;
+}
+
+/* Glottal pulse train with a wandering pitch through two moving formants,
+   gated by a syllable envelope that includes pauses. */
+static void gen_speech(float *x, int len, int ch, opus_uint32 seed)
+{
+    int i;
+    float phase = 0;
+    float mem1[2] = {0, 0}, mem2[2] = {0, 0};
+    for (i=0;i<len;i++)
+    {
+        float t, f0, env, src, y;
+        t = (float)i/BENCH_FS;
+        f0 = 110 + 20*ch + 30*(float)sin(2*M_PI*.7*t);
+        phase += f0/BENCH_FS;
+        src = 0;
+        if (phase >= 1)
+        {
+            phase -= 1;
+            src = 1;
+        }
+        src += .02f*lcg_uniform(&seed);
+        env = (float)sin(2*M_PI*2*t);
+        env = env > -.3f ? env + .3f : 0;
+        y = resonate(src, 500 + 300*(float)sin(2*M_PI*1.3*t), 80, mem1);
+        y += .5f*resonate(src, 1600 + 400*(float)sin(2*M_PI*.9*t), 120, mem2);
+        x[i] = 4*env*y;
+    }
+}
+
+/* Harmonic notes changing every half second over percussive noise bursts. */
+static void gen_music(float *x, int len, int ch, opus_uint32 seed)
+{
+    static const float notes[8] = {220.f, 246.9f, 261.6f, 293.7f, 329.6f, 349.2f, 392.f, 440.f};
+    int i, h;
+    for (i=0;i<len;i++)
+    {
+        float t, tn, tb, y;
+        int n;
+        t = (float)i/BENCH_FS;
+        n = (int)(t*2);
+        tn = t - .5f*n;
+        tb = t - .25f*(int)(t*4);
+        y = 0;
+        for (h=1;h<=6;h++)
+        {
+            y += (float)sin(2*M_PI*h*notes[(3*n+ch)&7]*t)/h;
+            y += .5f*(float)sin(2*M_PI*h*notes[(5*n+2)&7]*t)/h;
+        }
+        y *= .15f*(float)exp(-2*tn);
+        y += .3f*(float)exp(-40*tb)*lcg_uniform(&seed);
+        x[i] = y;
+    }
+}
+
+static void gen_noise(float *x, int len, opus_uint32 seed)
+{
+    int i;
+    for (i=0;i<len;i++)
+        x[i] = .3f*lcg_uniform(&seed);
+}
+
+static void gen_signal(opus_int16 *pcm, float *tmp, int len, int channels, int signal)
+{
+    int i, c;
+    for (c=0;c<channels;c++)
+    {
+        opus_uint32 seed = 12345 + 777*c;
+        if (signal == SIGNAL_SPEECH)
+            gen_speech(tmp, len, c, seed);
+        else if (signal == SIGNAL_MUSIC)
+            gen_music(tmp, len, c, seed);
+        else
+            gen_noise(tmp, len, seed);
+        for (i=0;i<len;i++)
+        {
+            float s = tmp[i]*32768.f;
+            s = s > 32767.f ? 32767.f : s < -32768.f ? -32768.f : s;
+            pcm[i*channels+c] = (opus_int16)floor(.5+s);
+        }
+    }
+}
+
+#define LIFECYCLE_POOL 64
+#define LIFECYCLE_ROUNDS 200
+
+/* Encoder settings of a typical call, applied after each init and
+   captured once in the prototype that gets copied. */
+static void lifecycle_setup(OpusEncoder *enc)
+{
+    opus_encoder_ctl(enc, OPUS_SET_BITRATE(24000));
+    opus_encoder_ctl(enc, OPUS_SET_COMPLEXITY(9));
+    opus_encoder_ctl(enc, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+    opus_encoder_ctl(enc, OPUS_SET_INBAND_FEC(1));
+    opus_encoder_ctl(enc, OPUS_SET_PACKET_LOSS_PERC(10));
+}
+
+/* Nanoseconds per state for one operation over a pool of states, averaged
+   over LIFECYCLE_ROUNDS. Each round first encodes or decodes a frame with
+   every state when used is set, which is not timed. */
+#define LIFECYCLE_ENC 0
+#define LIFECYCLE_ENC_COPY 1
+#define LIFECYCLE_ENC_RESET 2
+#define LIFECYCLE_DEC 3
+#define LIFECYCLE_DEC_COPY 4
+#define LIFECYCLE_DEC_RESET 5
+static double lifecycle_time(int op, int used, int channels, char *pool, int size,
+                             const char *proto, const opus_int16 *pcm)
+{
+    int r, i;
+    clock_t elapsed = 0;
+    unsigned char packet[MAX_PACKET];
+    opus_int16 out[960*2];
+    for (r=0;r<LIFECYCLE_ROUNDS;r++)
+    {
+        clock_t start;
+        for (i=0;i<LIFECYCLE_POOL;i++)
+        {
+            char *st = pool+i*size;
+            if (!used)
+                break;
+            if (op <= LIFECYCLE_ENC_RESET)
+            {
+                if (opus_encode((OpusEncoder*)st, pcm, 960, packet, MAX_PACKET) < 0)
+                    exit(EXIT_FAILURE);
+            } else {
+                /* Concealment is enough to dirty the state */
+                if (opus_decode((OpusDecoder*)st, NULL, 0, out, 960, 0) < 0)
+                    exit(EXIT_FAILURE);
+            }
+        }
+        start = clock();
+        for (i=0;i<LIFECYCLE_POOL;i++)
+        {
+            char *st = pool+i*size;
+            switch (op)
+            {
+            case LIFECYCLE_ENC:
+                opus_encoder_init((OpusEncoder*)st, BENCH_FS, channels, OPUS_APPLICATION_VOIP);
+                lifecycle_setup((OpusEncoder*)st);
+                break;
+            case LIFECYCLE_ENC_COPY:
+            case LIFECYCLE_DEC_COPY:
+                memcpy(st, proto, size);
+                break;
+            case LIFECYCLE_ENC_RESET:
+                opus_encoder_ctl((OpusEncoder*)st, OPUS_RESET_STATE);
+                break;
+            case LIFECYCLE_DEC:
+                opus_decoder_init((OpusDecoder*)st, BENCH_FS, channels);
+                break;
+            case LIFECYCLE_DEC_RESET:
+                opus_decoder_ctl((OpusDecoder*)st, OPUS_RESET_STATE);
+                break;
+            }
+        }
+        elapsed += clock()-start;
+    }
+    return (double)elapsed/CLOCKS_PER_SEC*1e9/(LIFECYCLE_ROUNDS*LIFECYCLE_POOL);
+}
+
+static int run_lifecycle(const char *build, int channels_sel, int header)
+{
+    int channels;
+    if (header)
+        printf("build,channels,enc_init_ns,enc_copy_ns,enc_reset_clean_ns,enc_reset_used_ns,"
+               "dec_init_ns,dec_copy_ns,dec_reset_used_ns\n");
+    for (channels=1;channels<=2;channels++)
+    {
+        int enc_size, dec_size, i;
+        char *pool, *enc_proto, *dec_proto;
+        opus_int16 pcm[960*2];
+        float tmp[960];
+        double t[7];
+        if (channels_sel >= 0 && channels != channels_sel)
+            continue;
+        enc_size = opus_encoder_get_size(channels);
+        dec_size = opus_decoder_get_size(channels);
+        pool = (char*)malloc((size_t)LIFECYCLE_POOL*(enc_size > dec_size ? enc_size : dec_size));
+        enc_proto = (char*)malloc(enc_size);
+        dec_proto = (char*)malloc(dec_size);
+        if (!pool || !enc_proto || !dec_proto)
+        {
+            fprintf(stderr, "out of memory\n");
+            return EXIT_FAILURE;
+        }
+        gen_signal(pcm, tmp, 960, channels, SIGNAL_SPEECH);
+        /* The encoder state is position independent, so a configured
+           encoder can be stamped out with memcpy(). */
+        opus_encoder_init((OpusEncoder*)enc_proto, BENCH_FS, channels, OPUS_APPLICATION_VOIP);
+        lifecycle_setup((OpusEncoder*)enc_proto);
+        opus_decoder_init((OpusDecoder*)dec_proto, BENCH_FS, channels);
+
+        t[0] = lifecycle_time(LIFECYCLE_ENC, 0, channels, pool, enc_size, NULL, pcm);
+        t[1] = lifecycle_time(LIFECYCLE_ENC_COPY, 0, channels, pool, enc_size, enc_proto, pcm);
+        t[2] = lifecycle_time(LIFECYCLE_ENC_RESET, 0, channels, pool, enc_size, NULL, pcm);
+        t[3] = lifecycle_time(LIFECYCLE_ENC_RESET, 1, channels, pool, enc_size, NULL, pcm);
+        for (i=0;i<LIFECYCLE_POOL;i++)
+            memcpy(pool+i*dec_size, dec_proto, dec_size);
+        t[4] = lifecycle_time(LIFECYCLE_DEC, 0, channels, pool, dec_size, NULL, pcm);
+        t[5] = lifecycle_time(LIFECYCLE_DEC_COPY, 0, channels, pool, dec_size, dec_proto, pcm);
+        t[6] = lifecycle_time(LIFECYCLE_DEC_RESET, 1, channels, pool, dec_size, NULL, pcm);
+        printf("%s,%d,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f\n", build, channels,
+               t[0], t[1], t[2], t[3], t[4], t[5], t[6]);
+        fflush(stdout);
+        free(pool);
+        free(enc_proto);
+        free(dec_proto);
+    }
+    return EXIT_SUCCESS;
+}
+
+static int config_is_valid(int app, int mode, int bw, int frame_size)
+{
+    if (applications[app] == OPUS_APPLICATION_RESTRICTED_LOWDELAY && modes[mode] != MODE_CELT_ONLY)
+        return 0;
+    if (modes[mode] == MODE_SILK_ONLY)
+        return bandwidths[bw] <= OPUS_BANDWIDTH_WIDEBAND && frame_size >= 480;
+    if (modes[mode] == MODE_HYBRID)
+        return bandwidths[bw] >= OPUS_BANDWIDTH_SUPERWIDEBAND && frame_size >= 480;
+    /* CELT has no mediumband */
+    return bandwidths[bw] != OPUS_BANDWIDTH_MEDIUMBAND;
+}
+
+static int parse_choice(const char *arg, const char **names, int n)
+{
+    int i;
+    for (i=0;i<n;i++)
+    {
+        if (strcmp(arg, names[i]) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static int frame_size_index(const char *arg)
+{
+    int i;
+    double ms = atof(arg);
+    for (i=0;i<9;i++)
+    {
+        if (fabs(ms*BENCH_FS/1000 - frame_sizes[i]) < .5)
+            return i;
+    }
+    return -1;
+}
+
+int main(int argc, char *argv[])
+{
+    int i, err;
+    int sig_sel=-1, app_sel=-1, mode_sel=-1, bw_sel=-1, fs_sel=-1;
+    int complexity_sel=-1, channels_sel=-1;
+    int header=1;
+    int lifecycle=0;
+    opus_int32 bitrate_override=0;
+    double seconds=2;
+    int len;
+    opus_int16 *pcm[2];
+    float *tmp;
+    unsigned char *packets;
+    opus_int32 *packet_len;
+    opus_int16 *out;
+    int sig, app, mode, bw, fs, channels, complexity;
+    const char *build;
+
+    /* The library and this program are not necessarily built with the same
+       defines, so ask the library which arithmetic it uses. */
+    build = strstr(opus_get_version_string(), "-fixed") ? "fixed" : "float";
+
+    for (i=1;i<argc;i++)
+    {
+        if (strcmp(argv[i], "-noheader") == 0)
+        {
+            header = 0;
+            continue;
+        }
+        if (strcmp(argv[i], "-lifecycle") == 0)
+        {
+            lifecycle = 1;
+            continue;
+        }
+        if (i+1 >= argc)
+        {
+            print_usage(argv);
+            return EXIT_FAILURE;
+        }
+        if (strcmp(argv[i], "-signal") == 0)
+            err = (sig_sel = parse_choice(argv[i+1], signal_names, 3)) < 0;
+        else if (strcmp(argv[i], "-application") == 0)
+            err = (app_sel = parse_choice(argv[i+1], application_names, 3)) < 0;
+        else if (strcmp(argv[i], "-mode") == 0)
+            err = (mode_sel = parse_choice(argv[i+1], mode_names, 3)) < 0;
+        else if (strcmp(argv[i], "-bandwidth") == 0)
+            err = (bw_sel = parse_choice(argv[i+1], bandwidth_names, 5)) < 0;
+        else if (strcmp(argv[i], "-framesize") == 0)
+            err = (fs_sel = frame_size_index(argv[i+1])) < 0;
+        else if (strcmp(argv[i], "-complexity") == 0)
+        {
+            complexity_sel = atoi(argv[i+1]);
+            err = complexity_sel < 0 || complexity_sel > 10;
+        } else if (strcmp(argv[i], "-channels") == 0)
+        {
+            channels_sel = atoi(argv[i+1]);
+            err = channels_sel < 1 || channels_sel > 2;
+        } else if (strcmp(argv[i], "-bitrate") == 0)
+        {
+            bitrate_override = atoi(argv[i+1]);
+            err = bitrate_override <= 0;
+        } else if (strcmp(argv[i], "-seconds") == 0)
+        {
+            seconds = atof(argv[i+1]);
+            err = seconds <= 0 || seconds > 3600;
+        } else
+            err = 1;
+        if (err)
+        {
+            fprintf(stderr, "invalid option: %s %s\n", argv[i], argv[i+1]);
+            print_usage(argv);
+            return EXIT_FAILURE;
+        }
+        i++;
+    }
+
+    if (lifecycle)
+        return run_lifecycle(build, channels_sel, header);
+
+    len = (int)(seconds*BENCH_FS);
+    /* Round up to whole 120 ms so that every frame size sees the same audio */
+    len = (len+5759)/5760*5760;
+    tmp = (float*)malloc(len*sizeof(*tmp));
+    pcm[0] = (opus_int16*)malloc(len*sizeof(opus_int16));
+    pcm[1] = (opus_int16*)malloc(2*len*sizeof(opus_int16));
+    out = (opus_int16*)malloc(2*5760*sizeof(opus_int16));
+    /* Up to 2.2 GB of packets at the longest -seconds, so the sizes and
+       offsets must not be computed in int */
+    packets = (unsigned char*)malloc((size_t)(len/120)*MAX_PACKET);
+    packet_len = (opus_int32*)malloc((size_t)(len/120)*sizeof(*packet_len));
+    if (!tmp || !pcm[0] || !pcm[1] || !out || !packets || !packet_len)
+    {
+        fprintf(stderr, "out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    if (header)
+        printf("build,signal,application,mode,bandwidth,frame_ms,channels,complexity,"
+               "bitrate,bytes,enc_realtime,enc_ns_per_sample,dec_realtime,dec_ns_per_sample\n");
+
+    for (sig=0;sig<3;sig++)
+    {
+        if (sig_sel >= 0 && sig != sig_sel)
+            continue;
+        gen_signal(pcm[0], tmp, len, 1, sig);
+        gen_signal(pcm[1], tmp, len, 2, sig);
+        for (app=0;app<3;app++)
+        for (mode=0;mode<3;mode++)
+        for (bw=0;bw<5;bw++)
+        for (fs=0;fs<9;fs++)
+        for (channels=1;channels<=2;channels++)
+        for (complexity=0;complexity<=10;complexity++)
+        {
+            OpusEncoder *enc;
+            OpusDecoder *dec;
+            opus_int32 bitrate, total_bytes;
+            int frame_size, nb_frames, f;
+            clock_t start;
+            double enc_time, dec_time, audio_time;
+
+            if ((app_sel >= 0 && app != app_sel) || (mode_sel >= 0 && mode != mode_sel)
+                || (bw_sel >= 0 && bw != bw_sel) || (fs_sel >= 0 && fs != fs_sel)
+                || (channels_sel >= 0 && channels != channels_sel)
+                || (complexity_sel >= 0 && complexity != complexity_sel))
+                continue;
+            frame_size = frame_sizes[fs];
+            if (!config_is_valid(app, mode, bw, frame_size))
+                continue;
+            if (bitrate_override)
+                bitrate = bitrate_override;
+            else if (modes[mode] == MODE_SILK_ONLY)
+                bitrate = channels*silk_rates[bw];
+            else if (modes[mode] == MODE_HYBRID)
+                bitrate = channels*hybrid_rates[bw];
+            else
+                bitrate = channels*celt_rates[bw];
+
+            enc = opus_encoder_create(BENCH_FS, channels, applications[app], &err);
+            if (err != OPUS_OK)
+            {
+                fprintf(stderr, "Cannot create encoder: %s\n", opus_strerror(err));
+                return EXIT_FAILURE;
+            }
+            dec = opus_decoder_create(BENCH_FS, channels, &err);
+            if (err != OPUS_OK)
+            {
+                fprintf(stderr, "Cannot create decoder: %s\n", opus_strerror(err));
+                return EXIT_FAILURE;
+            }
+            opus_encoder_ctl(enc, OPUS_SET_BITRATE(bitrate));
+            opus_encoder_ctl(enc, OPUS_SET_BANDWIDTH(bandwidths[bw]));
+            opus_encoder_ctl(enc, OPUS_SET_COMPLEXITY(complexity));
+            opus_encoder_ctl(enc, OPUS_SET_FORCE_MODE(modes[mode]));
+
+            nb_frames = len/frame_size;
+            total_bytes = 0;
+            start = clock();
+            for (f=0;f<nb_frames;f++)
+            {
+                packet_len[f] = opus_encode(enc, pcm[channels-1]+f*frame_size*channels,
+                                            frame_size, packets+(size_t)f*MAX_PACKET, MAX_PACKET);
+                if (packet_len[f] < 0)
+                {
+                    fprintf(stderr, "opus_encode() returned %d\n", packet_len[f]);
+                    return EXIT_FAILURE;
+                }
+            }
+            enc_time = (double)(clock()-start)/CLOCKS_PER_SEC;
+
+            start = clock();
+            for (f=0;f<nb_frames;f++)
+            {
+                int ret = opus_decode(dec, packets+(size_t)f*MAX_PACKET, packet_len[f], out, 5760, 0);
+                if (ret != frame_size)
+                {
+                    fprintf(stderr, "opus_decode() returned %d\n", ret);
+                    return EXIT_FAILURE;
+                }
+            }
+            dec_time = (double)(clock()-start)/CLOCKS_PER_SEC;
+
+            for (f=0;f<nb_frames;f++)
+                total_bytes += packet_len[f];
+            audio_time = (double)len/BENCH_FS;
+            printf("%s,%s,%s,%s,%s,%g,%d,%d,%ld,%ld,%.2f,%.2f,%.2f,%.2f\n",
+                   build, signal_names[sig], application_names[app], mode_names[mode],
+                   bandwidth_names[bw], frame_size*1000./BENCH_FS, channels, complexity,
+                   (long)bitrate, (long)total_bytes,
+                   enc_time > 0 ? audio_time/enc_time : 0, enc_time*1e9/len,
+                   dec_time > 0 ? audio_time/dec_time : 0, dec_time*1e9/len);
+            fflush(stdout);
+            opus_encoder_destroy(enc);
+            opus_decoder_destroy(dec);
+        }
+    }
+    free(tmp);
+    free(pcm[0]);
+    free(pcm[1]);
+    free(out);
+    free(packets);
+    free(packet_len);
+    return EXIT_SUCCESS;
+}
@@ -25,10 +25,17 @@
    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 #define OPUS_PI (3.14159265F)
 
@@ -150,6 +157,172 @@ static void band_energy(float *_out,float *_ps,const int *_bands,int _nbands,
   free(window);
 }
 
+/*Mixed-radix FFT used by the fast mode in place of the per-bin DFT above.
+  The window sizes (480 divided by 1, 2, 3, 4 or 6) only have factors 2, 3
+  and 5.*/
+
+#define FFT_MAX_FACTORS (16)
+#define FFT_MAX_RADIX (5)
+
+typedef struct{
+  float r;
+  float i;
+}fft_cpx;
+
+typedef struct{
+  int      n;
+  int      factors[FFT_MAX_FACTORS];
+  fft_cpx *twiddles;
+}fft_state;
+
+static int fft_init(fft_state *_st,int _n){
+  int nfactors;
+  int n;
+  int xi;
+  _st->n=_n;
+  nfactors=0;
+  n=_n;
+  while(n>1){
+    int p;
+    if(n%4==0)p=4;
+    else if(n%2==0)p=2;
+    else if(n%3==0)p=3;
+    else if(n%5==0)p=5;
+    else return -1;
+    if(nfactors>=FFT_MAX_FACTORS)return -1;
+    _st->factors[nfactors++]=p;
+    n/=p;
+  }
+  _st->twiddles=(fft_cpx *)opus_malloc(_n*sizeof(*_st->twiddles));
+  for(xi=0;xi<_n;xi++){
+    double phase;
+    phase=-2*3.141592653589793*xi/_n;
+    _st->twiddles[xi].r=(float)cos(phase);
+    _st->twiddles[xi].i=(float)sin(phase);
+  }
+  return 0;
+}
+
+static void fft_clear(fft_state *_st){
+  free(_st->twiddles);
+}
+
+/*Decimation in time: transform the _radix interleaved sub-sequences of
+  _in (of length _n/_radix each) recursively, then combine them.*/
+static void fft_work(const fft_state *_st,fft_cpx *_out,const fft_cpx *_in,
+ int _n,int _stride,const int *_factors){
+  fft_cpx tmp[FFT_MAX_RADIX];
+  int     radix;
+  int     m;
+  int     k;
+  int     q;
+  int     j;
+  radix=_factors[0];
+  m=_n/radix;
+  if(m==1){
+    for(q=0;q<radix;q++)_out[q]=_in[q*_stride];
+  }
+  else{
+    for(q=0;q<radix;q++){
+      fft_work(_st,_out+q*m,_in+q*_stride,m,_stride*radix,_factors+1);
+    }
+  }
+  for(k=0;k<m;k++){
+    for(q=0;q<radix;q++){
+      fft_cpx a;
+      fft_cpx w;
+      a=_out[k+q*m];
+      w=_st->twiddles[q*k*_stride];
+      tmp[q].r=a.r*w.r-a.i*w.i;
+      tmp[q].i=a.r*w.i+a.i*w.r;
+    }
+    for(j=0;j<radix;j++){
+      float re;
+      float im;
+      int   ti;
+      int   tstep;
+      re=tmp[0].r;
+      im=tmp[0].i;
+      tstep=j*(_st->n/radix);
+      ti=0;
+      for(q=1;q<radix;q++){
+        fft_cpx w;
+        ti+=tstep;
+        if(ti>=_st->n)ti-=_st->n;
+        w=_st->twiddles[ti];
+        re+=tmp[q].r*w.r-tmp[q].i*w.i;
+        im+=tmp[q].r*w.i+tmp[q].i*w.r;
+      }
+      _out[k+j*m].r=re;
+      _out[k+j*m].i=im;
+    }
+  }
+}
+
+/*Same output as band_energy(), with the spectrum of each frame computed by
+  one FFT instead of one DFT per bin.*/
+static void band_energy_fft(float *_out,float *_ps,const int *_bands,
+ int _nbands,const float *_in,int _nchannels,size_t _nframes,int _window_sz,
+ int _step,int _downsample){
+  fft_state  st;
+  float     *window;
+  fft_cpx   *x;
+  fft_cpx   *X;
+  size_t     xi;
+  int        xj;
+  int        ps_sz;
+  if(fft_init(&st,_window_sz)<0){
+    band_energy(_out,_ps,_bands,_nbands,_in,_nchannels,_nframes,_window_sz,
+     _step,_downsample);
+    return;
+  }
+  window=(float *)opus_malloc(_window_sz*sizeof(*window));
+  x=(fft_cpx *)opus_malloc(_window_sz*sizeof(*x));
+  X=(fft_cpx *)opus_malloc(_nchannels*_window_sz*sizeof(*X));
+  ps_sz=_window_sz/2;
+  for(xj=0;xj<_window_sz;xj++){
+    window[xj]=0.5F-0.5F*OPUS_COSF((2*OPUS_PI/(_window_sz-1))*xj);
+  }
+  for(xi=0;xi<_nframes;xi++){
+    const float *in;
+    float       *ps;
+    int          ci;
+    int          bi;
+    in=_in+xi*_step*_nchannels;
+    for(ci=0;ci<_nchannels;ci++){
+      for(xj=0;xj<_window_sz;xj++){
+        x[xj].r=window[xj]*in[xj*_nchannels+ci];
+        x[xj].i=0;
+      }
+      fft_work(&st,X+ci*_window_sz,x,_window_sz,1,st.factors);
+    }
+    ps=_ps+xi*ps_sz*_nchannels;
+    for(xj=0;xj<_bands[_nbands];xj++){
+      for(ci=0;ci<_nchannels;ci++){
+        float re;
+        float im;
+        re=X[ci*_window_sz+xj].r*_downsample;
+        im=X[ci*_window_sz+xj].i*_downsample;
+        ps[xj*_nchannels+ci]=re*re+im*im+100000;
+      }
+    }
+    if(_out){
+      for(bi=0;bi<_nbands;bi++){
+        for(ci=0;ci<_nchannels;ci++){
+          float p;
+          p=0;
+          for(xj=_bands[bi];xj<_bands[bi+1];xj++)p+=ps[xj*_nchannels+ci];
+          _out[(xi*_nbands+bi)*_nchannels+ci]=p/(_bands[bi+1]-_bands[bi]);
+        }
+      }
+    }
+  }
+  free(window);
+  free(x);
+  free(X);
+  fft_clear(&st);
+}
+
 #define NBANDS (21)
 #define NFREQS (240)
 
@@ -162,88 +335,62 @@ static const int BANDS[NBANDS+1]={
 #define TEST_WIN_SIZE (480)
 #define TEST_WIN_STEP (120)
 
-int main(int _argc,const char **_argv){
-  FILE    *fin1;
-  FILE    *fin2;
+#define COMPARE_PASS  (0)
+#define COMPARE_FAIL  (1)
+#define COMPARE_ERROR (2)
+
+#define COMPARE_MSG_SZ (512)
+
+/*Compares decoded samples against their reference and computes the quality
+  metric. _x holds _xlength stereo samples at 48 kHz, _y holds _ylength
+  samples with nchannels channels at the given rate. Returns one of the
+  COMPARE_* codes; on COMPARE_ERROR, _msg says why the signals could not be
+  compared.*/
+static int compare_pcm(const float *_x,size_t _xlength,const float *_y,
+ size_t _ylength,int nchannels,unsigned rate,int _fast,double *_err,
+ float *_Q,char *_msg){
   float   *x;
-  float   *y;
   float   *xb;
   float   *X;
   float   *Y;
   double    err;
   float    Q;
   size_t   xlength;
-  size_t   ylength;
   size_t   nframes;
   size_t   xi;
   int      ci;
   int      xj;
   int      bi;
-  int      nchannels;
-  unsigned rate;
   int      downsample;
   int      ybands;
   int      yfreqs;
   int      max_compare;
-  if(_argc<3||_argc>6){
-    fprintf(stderr,"Usage: %s [-s] [-r rate2] <file1.sw> <file2.sw>\n",
-     _argv[0]);
-    return EXIT_FAILURE;
-  }
-  nchannels=1;
-  if(strcmp(_argv[1],"-s")==0){
-    nchannels=2;
-    _argv++;
-  }
-  rate=48000;
   ybands=NBANDS;
   yfreqs=NFREQS;
-  downsample=1;
-  if(strcmp(_argv[1],"-r")==0){
-    rate=atoi(_argv[2]);
-    if(rate!=8000&&rate!=12000&&rate!=16000&&rate!=24000&&rate!=48000){
-      fprintf(stderr,
-       "Sampling rate must be 8000, 12000, 16000, 24000, or 48000\n");
-      return EXIT_FAILURE;
-    }
-    downsample=48000/rate;
-    switch(rate){
-      case  8000:ybands=13;break;
-      case 12000:ybands=15;break;
-      case 16000:ybands=17;break;
-      case 24000:ybands=19;break;
-    }
-    yfreqs=NFREQS/downsample;
-    _argv+=2;
-  }
-  fin1=fopen(_argv[1],"rb");
-  if(fin1==NULL){
-    fprintf(stderr,"Error opening '%s'.\n",_argv[1]);
-    return EXIT_FAILURE;
-  }
-  fin2=fopen(_argv[2],"rb");
-  if(fin2==NULL){
-    fprintf(stderr,"Error opening '%s'.\n",_argv[2]);
-    fclose(fin1);
-    return EXIT_FAILURE;
+  downsample=48000/rate;
+  switch(rate){
+    case  8000:ybands=13;break;
+    case 12000:ybands=15;break;
+    case 16000:ybands=17;break;
+    case 24000:ybands=19;break;
   }
-  /*Read in the data and allocate scratch space.*/
-  xlength=read_pcm16(&x,fin1,2);
-  if(nchannels==1){
-    for(xi=0;xi<xlength;xi++)x[xi]=.5*(x[2*xi]+x[2*xi+1]);
-  }
-  fclose(fin1);
-  ylength=read_pcm16(&y,fin2,nchannels);
-  fclose(fin2);
-  if(xlength!=ylength*downsample){
-    fprintf(stderr,"Sample counts do not match (%lu!=%lu).\n",
-     (unsigned long)xlength,(unsigned long)ylength*downsample);
-    return EXIT_FAILURE;
+  yfreqs=NFREQS/downsample;
+  xlength=_xlength;
+  if(xlength!=_ylength*downsample){
+    sprintf(_msg,"Sample counts do not match (%lu!=%lu).",
+     (unsigned long)xlength,(unsigned long)_ylength*downsample);
+    return COMPARE_ERROR;
   }
   if(xlength<TEST_WIN_SIZE){
-    fprintf(stderr,"Insufficient sample data (%lu<%i).\n",
+    sprintf(_msg,"Insufficient sample data (%lu<%i).",
      (unsigned long)xlength,TEST_WIN_SIZE);
-    return EXIT_FAILURE;
+    return COMPARE_ERROR;
+  }
+  x=NULL;
+  if(nchannels==1){
+    x=(float *)opus_malloc(xlength*sizeof(*x));
+    for(xi=0;xi<xlength;xi++)x[xi]=.5*(_x[2*xi]+_x[2*xi+1]);
+    _x=x;
   }
   nframes=(xlength-TEST_WIN_SIZE+TEST_WIN_STEP)/TEST_WIN_STEP;
   xb=(float *)opus_malloc(nframes*NBANDS*nchannels*sizeof(*xb));
@@ -251,12 +398,23 @@ int main(int _argc,const char **_argv){
   Y=(float *)opus_malloc(nframes*yfreqs*nchannels*sizeof(*Y));
   /*Compute the per-band spectral energy of the original signal
      and the error.*/
-  band_energy(xb,X,BANDS,NBANDS,x,nchannels,nframes,
-   TEST_WIN_SIZE,TEST_WIN_STEP,1);
+  if(_fast){
+    band_energy_fft(xb,X,BANDS,NBANDS,_x,nchannels,nframes,
+     TEST_WIN_SIZE,TEST_WIN_STEP,1);
+  }
+  else{
+    band_energy(xb,X,BANDS,NBANDS,_x,nchannels,nframes,
+     TEST_WIN_SIZE,TEST_WIN_STEP,1);
+  }
   free(x);
-  band_energy(NULL,Y,BANDS,ybands,y,nchannels,nframes,
-   TEST_WIN_SIZE/downsample,TEST_WIN_STEP/downsample,downsample);
-  free(y);
+  if(_fast){
+    band_energy_fft(NULL,Y,BANDS,ybands,_y,nchannels,nframes,
+     TEST_WIN_SIZE/downsample,TEST_WIN_STEP/downsample,downsample);
+  }
+  else{
+    band_energy(NULL,Y,BANDS,ybands,_y,nchannels,nframes,
+     TEST_WIN_SIZE/downsample,TEST_WIN_STEP/downsample,downsample);
+  }
   for(xi=0;xi<nframes;xi++){
     /*Frequency masking (low to high): 10 dB/Bark slope.*/
     for(bi=1;bi<NBANDS;bi++){
@@ -368,15 +526,280 @@ int main(int _argc,const char **_argv){
   free(Y);
   err=pow(err/nframes,1.0/16);
   Q=100*(1-0.5*log(1+err)/log(1.13));
-  if(Q<0){
-    fprintf(stderr,"Test vector FAILS\n");
-    fprintf(stderr,"Internal weighted error is %f\n",err);
+  *_err=err;
+  *_Q=Q;
+  return Q<0?COMPARE_FAIL:COMPARE_PASS;
+}
+
+#ifndef OPUS_COMPARE_NO_MAIN
+
+/*Compares a decoded file against its reference and computes the quality
+  metric. Returns one of the COMPARE_* codes; on COMPARE_ERROR, _msg says why
+  the files could not be compared.*/
+static int compare_files(const char *_file1,const char *_file2,int nchannels,
+ unsigned rate,int _fast,double *_err,float *_Q,char *_msg){
+  FILE    *fin1;
+  FILE    *fin2;
+  float   *x;
+  float   *y;
+  size_t   xlength;
+  size_t   ylength;
+  int      ret;
+  fin1=fopen(_file1,"rb");
+  if(fin1==NULL){
+    sprintf(_msg,"Error opening '%.400s'.",_file1);
+    return COMPARE_ERROR;
+  }
+  fin2=fopen(_file2,"rb");
+  if(fin2==NULL){
+    sprintf(_msg,"Error opening '%.400s'.",_file2);
+    fclose(fin1);
+    return COMPARE_ERROR;
+  }
+  xlength=read_pcm16(&x,fin1,2);
+  fclose(fin1);
+  ylength=read_pcm16(&y,fin2,nchannels);
+  fclose(fin2);
+  ret=compare_pcm(x,xlength,y,ylength,nchannels,rate,_fast,_err,_Q,_msg);
+  free(x);
+  free(y);
+  return ret;
+}
+
+typedef struct{
+  char   *file1;
+  char   *file2;
+  int     status;
+  double  err;
+  float   Q;
+  char    msg[COMPARE_MSG_SZ];
+}compare_job;
+
+typedef struct{
+  compare_job *jobs;
+  int          njobs;
+  int          next;
+  int          nchannels;
+  unsigned     rate;
+  int          fast;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_t lock;
+#endif
+}compare_queue;
+
+static void *compare_worker(void *_arg){
+  compare_queue *queue;
+  queue=(compare_queue *)_arg;
+  for(;;){
+    compare_job *job;
+    int          ji;
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&queue->lock);
+#endif
+    ji=queue->next++;
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&queue->lock);
+#endif
+    if(ji>=queue->njobs)break;
+    job=queue->jobs+ji;
+    job->msg[0]='\0';
+    job->status=compare_files(job->file1,job->file2,queue->nchannels,
+     queue->rate,queue->fast,&job->err,&job->Q,job->msg);
+  }
+  return NULL;
+}
+
+/*Reads "<reference> <decoded>" pairs, one per line. Empty lines and lines
+  starting with '#' are skipped.*/
+static int read_job_list(compare_job **_jobs,const char *_list){
+  FILE        *fin;
+  compare_job *jobs;
+  char         line[4096];
+  int          njobs;
+  int          cjobs;
+  fin=fopen(_list,"r");
+  if(fin==NULL){
+    fprintf(stderr,"Error opening '%s'.\n",_list);
+    return -1;
+  }
+  jobs=NULL;
+  njobs=cjobs=0;
+  while(fgets(line,sizeof(line),fin)!=NULL){
+    char *file1;
+    char *file2;
+    file1=strtok(line," \t\r\n");
+    if(file1==NULL||file1[0]=='#')continue;
+    file2=strtok(NULL," \t\r\n");
+    if(file2==NULL){
+      fprintf(stderr,"Missing decoded file for '%s' in '%s'.\n",file1,_list);
+      continue;
+    }
+    if(njobs>=cjobs){
+      cjobs=cjobs<<1|1;
+      jobs=(compare_job *)opus_realloc(jobs,cjobs*sizeof(*jobs));
+    }
+    jobs[njobs].file1=(char *)opus_malloc(strlen(file1)+1);
+    strcpy(jobs[njobs].file1,file1);
+    jobs[njobs].file2=(char *)opus_malloc(strlen(file2)+1);
+    strcpy(jobs[njobs].file2,file2);
+    njobs++;
+  }
+  fclose(fin);
+  *_jobs=jobs;
+  return njobs;
+}
+
+static const char *STATUS_NAMES[3]={"PASS","FAIL","ERROR"};
+
+static void usage(const char *_argv0){
+  fprintf(stderr,"Usage: %s [-s] [-r rate2] <file1.sw> <file2.sw>\n",
+   _argv0);
+  fprintf(stderr,"       %s [-s] [-r rate2] [-fast] [-csv] [-j threads] "
+   "-list <pairs.txt>\n",_argv0);
+  fprintf(stderr,"  -fast       : compute the spectra with an FFT (same metric, "
+   "not bit-exact)\n");
+  fprintf(stderr,"  -csv        : print one CSV line per comparison\n");
+  fprintf(stderr,"  -j threads  : compare that many pairs in parallel\n");
+  fprintf(stderr,"  -list file  : compare each '<file1.sw> <file2.sw>' line "
+   "of the file\n");
+}
+
+int main(int _argc,const char **_argv){
+  compare_queue  queue;
+  compare_job    single;
+  const char    *argv0;
+  const char    *list;
+  int            nchannels;
+  unsigned       rate;
+  int            fast;
+  int            csv;
+  int            nthreads;
+  int            ji;
+  int            ret;
+  argv0=_argv[0];
+  nchannels=1;
+  rate=48000;
+  fast=csv=0;
+  nthreads=1;
+  list=NULL;
+  for(;_argc>1&&_argv[1][0]=='-';_argc--,_argv++){
+    if(strcmp(_argv[1],"-s")==0)nchannels=2;
+    else if(strcmp(_argv[1],"-fast")==0)fast=1;
+    else if(strcmp(_argv[1],"-csv")==0)csv=1;
+    else if(_argc>2&&strcmp(_argv[1],"-r")==0){
+      rate=atoi(_argv[2]);
+      if(rate!=8000&&rate!=12000&&rate!=16000&&rate!=24000&&rate!=48000){
+        fprintf(stderr,
+         "Sampling rate must be 8000, 12000, 16000, 24000, or 48000\n");
+        return EXIT_FAILURE;
+      }
+      _argc--;
+      _argv++;
+    }
+    else if(_argc>2&&strcmp(_argv[1],"-j")==0){
+      nthreads=atoi(_argv[2]);
+      _argc--;
+      _argv++;
+    }
+    else if(_argc>2&&strcmp(_argv[1],"-list")==0){
+      list=_argv[2];
+      _argc--;
+      _argv++;
+    }
+    else{
+      usage(argv0);
+      return EXIT_FAILURE;
+    }
+  }
+  if(list==NULL?_argc!=3:_argc!=1){
+    usage(argv0);
     return EXIT_FAILURE;
   }
+  if(nthreads<1)nthreads=1;
+#ifndef HAVE_PTHREAD
+  if(nthreads>1){
+    fprintf(stderr,"This build of %s has no thread support.\n",argv0);
+    return EXIT_FAILURE;
+  }
+#endif
+  queue.nchannels=nchannels;
+  queue.rate=rate;
+  queue.fast=fast;
+  queue.next=0;
+  if(list==NULL){
+    single.file1=(char *)_argv[1];
+    single.file2=(char *)_argv[2];
+    queue.jobs=&single;
+    queue.njobs=1;
+  }
   else{
-    fprintf(stderr,"Test vector PASSES\n");
-    fprintf(stderr,
-     "Opus quality metric: %.1f %% (internal weighted error is %f)\n",Q,err);
-    return EXIT_SUCCESS;
+    queue.njobs=read_job_list(&queue.jobs,list);
+    if(queue.njobs<0)return EXIT_FAILURE;
+  }
+  if(nthreads>queue.njobs)nthreads=queue.njobs;
+#ifdef HAVE_PTHREAD
+  if(nthreads>1){
+    pthread_t *threads;
+    int        ti;
+    threads=(pthread_t *)opus_malloc(nthreads*sizeof(*threads));
+    pthread_mutex_init(&queue.lock,NULL);
+    for(ti=0;ti<nthreads;ti++){
+      if(pthread_create(threads+ti,NULL,compare_worker,&queue)!=0){
+        fprintf(stderr,"Error creating thread %i.\n",ti);
+        exit(EXIT_FAILURE);
+      }
+    }
+    for(ti=0;ti<nthreads;ti++)pthread_join(threads[ti],NULL);
+    pthread_mutex_destroy(&queue.lock);
+    free(threads);
+  }
+  else
+#endif
+  compare_worker(&queue);
+  ret=EXIT_SUCCESS;
+  if(csv)printf("file1,file2,channels,rate,status,quality,error\n");
+  for(ji=0;ji<queue.njobs;ji++){
+    compare_job *job;
+    job=queue.jobs+ji;
+    if(job->status!=COMPARE_PASS)ret=EXIT_FAILURE;
+    if(csv){
+      if(job->status==COMPARE_ERROR){
+        printf("%s,%s,%i,%u,%s,,\n",job->file1,job->file2,nchannels,rate,
+         STATUS_NAMES[job->status]);
+      }
+      else{
+        printf("%s,%s,%i,%u,%s,%.1f,%f\n",job->file1,job->file2,nchannels,
+         rate,STATUS_NAMES[job->status],job->Q,job->err);
+      }
+    }
+    else if(job->status==COMPARE_ERROR){
+      if(list!=NULL)fprintf(stderr,"%s: ",job->file2);
+      fprintf(stderr,"%s\n",job->msg);
+    }
+    else if(list!=NULL){
+      fprintf(stderr,"%s: %s (quality %.1f %%, internal weighted error %f)\n",
+       job->file2,job->status==COMPARE_PASS?"PASSES":"FAILS",job->Q,
+       job->err);
+    }
+    else if(job->status==COMPARE_FAIL){
+      fprintf(stderr,"Test vector FAILS\n");
+      fprintf(stderr,"Internal weighted error is %f\n",job->err);
+    }
+    else{
+      fprintf(stderr,"Test vector PASSES\n");
+      fprintf(stderr,
+       "Opus quality metric: %.1f %% (internal weighted error is %f)\n",
+       job->Q,job->err);
+    }
+  }
+  if(list!=NULL){
+    for(ji=0;ji<queue.njobs;ji++){
+      free(queue.jobs[ji].file1);
+      free(queue.jobs[ji].file2);
+    }
+    free(queue.jobs);
   }
+  return ret;
 }
+
+#endif
@@ -217,8 +217,12 @@ static int opus_packet_get_mode(const unsigned char *data)
    return mode;
 }
 
+/* When lbrr_dec is not NULL, an FEC decode stores the range decoder state
+   reached after the LBRR data in it, and a regular decode of the same frame
+   resumes from that state instead of parsing the SILK header again. */
 static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
-      opus_int32 len, opus_val16 *pcm, int frame_size, int decode_fec)
+      opus_int32 len, opus_val16 *pcm, int frame_size, int decode_fec,
+      ec_dec *lbrr_dec)
 {
    void *silk_dec;
    CELTDecoder *celt_dec;
@@ -275,7 +279,10 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
       audiosize = st->frame_size;
       mode = st->mode;
       bandwidth = st->bandwidth;
-      ec_dec_init(&dec,(unsigned char*)data,len);
+      if (lbrr_dec != NULL && !decode_fec)
+         dec = *lbrr_dec;
+      else
+         ec_dec_init(&dec,(unsigned char*)data,len);
    } else {
       audiosize = frame_size;
       mode = st->prev_mode;
@@ -295,7 +302,7 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
       if (audiosize > F20)
       {
          do {
-            int ret = opus_decode_frame(st, NULL, 0, pcm, IMIN(audiosize, F20), 0);
+            int ret = opus_decode_frame(st, NULL, 0, pcm, IMIN(audiosize, F20), 0, NULL);
             if (ret<0)
             {
                RESTORE_STACK;
@@ -341,7 +348,7 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
    if (transition && mode == MODE_CELT_ONLY)
    {
       pcm_transition = pcm_transition_celt;
-      opus_decode_frame(st, NULL, 0, pcm_transition, IMIN(F5, audiosize), 0);
+      opus_decode_frame(st, NULL, 0, pcm_transition, IMIN(F5, audiosize), 0, NULL);
    }
    if (audiosize > frame_size)
    {
@@ -394,7 +401,14 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
         }
      }
 
-     lost_flag = data == NULL ? 1 : 2 * decode_fec;
+     if (data == NULL)
+        lost_flag = FLAG_PACKET_LOST;
+     else if (decode_fec)
+        lost_flag = FLAG_DECODE_LBRR;
+     else if (lbrr_dec != NULL)
+        lost_flag = FLAG_DECODE_AFTER_LBRR;
+     else
+        lost_flag = FLAG_DECODE_NORMAL;
      decoded_samples = 0;
      do {
         /* Call SILK decoder */
@@ -402,7 +416,7 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
         silk_ret = silk_Decode( silk_dec, &st->DecControl,
                                 lost_flag, first_frame, &dec, pcm_ptr, &silk_frame_size, st->arch );
         if( silk_ret ) {
-           if (lost_flag) {
+           if (lost_flag == FLAG_PACKET_LOST || lost_flag == FLAG_DECODE_LBRR) {
               /* PLC failure should not be fatal */
               silk_frame_size = frame_size;
               for (i=0;i<frame_size*st->channels;i++)
@@ -415,6 +429,8 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
         pcm_ptr += silk_frame_size * st->channels;
         decoded_samples += silk_frame_size;
       } while( decoded_samples < frame_size );
+      if (lbrr_dec != NULL && decode_fec && data != NULL)
+         *lbrr_dec = dec;
    }
 
    start_band = 0;
@@ -461,7 +477,7 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
    if (transition && mode != MODE_CELT_ONLY)
    {
       pcm_transition = pcm_transition_silk;
-      opus_decode_frame(st, NULL, 0, pcm_transition, IMIN(F5, audiosize), 0);
+      opus_decode_frame(st, NULL, 0, pcm_transition, IMIN(F5, audiosize), 0, NULL);
    }
 
 
@@ -623,16 +639,105 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
 
 }
 
+int opus_decode_iter_native(OpusDecoder *st, const OpusPacketIter *it,
+      opus_val16 *pcm, int frame_size, int decode_fec, int soft_clip)
+{
+   int nb_samples;
+   int packet_frame_size, packet_bandwidth, packet_mode, packet_stream_channels;
+   const unsigned char *data;
+   opus_int32 offset;
+   opus_int16 size;
+   OpusPacketIter frames;
+   VALIDATE_OPUS_DECODER(st);
+   if (decode_fec<0 || decode_fec>1)
+      return OPUS_BAD_ARG;
+   /* For FEC, frame_size has to be to have a multiple of 2.5 ms */
+   if (decode_fec && frame_size%(st->Fs/400)!=0)
+      return OPUS_BAD_ARG;
+
+   data = it->data;
+   packet_mode = opus_packet_get_mode(data);
+   packet_bandwidth = opus_packet_get_bandwidth(data);
+   packet_frame_size = opus_packet_get_samples_per_frame(data, st->Fs);
+   packet_stream_channels = opus_packet_get_nb_channels(data);
+
+   frames = *it;
+   opus_packet_iter_rewind(&frames);
+
+   if (decode_fec)
+   {
+      int duration_copy;
+      int ret;
+      /* If no FEC can be present, run the PLC (recursive call) */
+      if (frame_size < packet_frame_size || packet_mode == MODE_CELT_ONLY || st->mode == MODE_CELT_ONLY)
+         return opus_decode_native(st, NULL, 0, pcm, frame_size, 0, 0, NULL, soft_clip);
+      /* Otherwise, run the PLC on everything except the size for which we might have FEC */
+      duration_copy = st->last_packet_duration;
+      if (frame_size-packet_frame_size!=0)
+      {
+         ret = opus_decode_native(st, NULL, 0, pcm, frame_size-packet_frame_size, 0, 0, NULL, soft_clip);
+         if (ret<0)
+         {
+            st->last_packet_duration = duration_copy;
+            return ret;
+         }
+         celt_assert(ret==frame_size-packet_frame_size);
+      }
+      /* Complete with FEC */
+      st->mode = packet_mode;
+      st->bandwidth = packet_bandwidth;
+      st->frame_size = packet_frame_size;
+      st->stream_channels = packet_stream_channels;
+      opus_packet_iter_next(&frames, &offset, &size);
+      ret = opus_decode_frame(st, data+offset, size, pcm+st->channels*(frame_size-packet_frame_size),
+            packet_frame_size, 1, NULL);
+      if (ret<0)
+         return ret;
+      else {
+         if (OPUS_CHECK_ARRAY(pcm, frame_size*st->channels))
+            OPUS_PRINT_INT(frame_size);
+         st->last_packet_duration = frame_size;
+         return frame_size;
+      }
+   }
+
+   if (frames.nb_frames*packet_frame_size > frame_size)
+      return OPUS_BUFFER_TOO_SMALL;
+
+   /* Update the state as the last step to avoid updating it on an invalid packet */
+   st->mode = packet_mode;
+   st->bandwidth = packet_bandwidth;
+   st->frame_size = packet_frame_size;
+   st->stream_channels = packet_stream_channels;
+
+   nb_samples=0;
+   while (opus_packet_iter_next(&frames, &offset, &size))
+   {
+      int ret;
+      ret = opus_decode_frame(st, data+offset, size, pcm+nb_samples*st->channels, frame_size-nb_samples, 0, NULL);
+      if (ret<0)
+         return ret;
+      celt_assert(ret==packet_frame_size);
+      nb_samples += ret;
+   }
+   st->last_packet_duration = nb_samples;
+   if (OPUS_CHECK_ARRAY(pcm, nb_samples*st->channels))
+      OPUS_PRINT_INT(nb_samples);
+#ifndef FIXED_POINT
+   if (soft_clip)
+      opus_pcm_soft_clip_impl(pcm, nb_samples, st->channels, st->softclip_mem, st->arch);
+   else
+      st->softclip_mem[0]=st->softclip_mem[1]=0;
+#endif
+   return nb_samples;
+}
+
 int opus_decode_native(OpusDecoder *st, const unsigned char *data,
       opus_int32 len, opus_val16 *pcm, int frame_size, int decode_fec,
       int self_delimited, opus_int32 *packet_offset, int soft_clip)
 {
-   int i, nb_samples;
-   int count, offset;
-   unsigned char toc;
-   int packet_frame_size, packet_bandwidth, packet_mode, packet_stream_channels;
-   /* 48 x 2.5 ms = 120 ms */
-   opus_int16 size[48];
+   int count;
+   OpusPacketIter it;
    VALIDATE_OPUS_DECODER(st);
    if (decode_fec<0 || decode_fec>1)
       return OPUS_BAD_ARG;
@@ -644,7 +749,7 @@ int opus_decode_native(OpusDecoder *st, const unsigned char *data,
       int pcm_count=0;
       do {
          int ret;
-         ret = opus_decode_frame(st, NULL, 0, pcm+pcm_count*st->channels, frame_size-pcm_count, 0);
+         ret = opus_decode_frame(st, NULL, 0, pcm+pcm_count*st->channels, frame_size-pcm_count, 0, NULL);
          if (ret<0)
             return ret;
          pcm_count += ret;
@@ -657,58 +762,85 @@ int opus_decode_native(OpusDecoder *st, const unsigned char *data,
    } else if (len<0)
       return OPUS_BAD_ARG;
 
+   count = opus_packet_iter_init(&it, data, len, self_delimited);
+   if (count<0)
+      return count;
+   if (packet_offset)
+      *packet_offset = it.packet_len;
+
+   return opus_decode_iter_native(st, &it, pcm, frame_size, decode_fec, soft_clip);
+}
+
+/* Decodes the FEC data of a packet into pcm_lost (concealing whatever part of
+   lost_frame_size it does not cover), then the packet itself into pcm. The
+   packet is parsed once and the SILK decoder resumes right after the LBRR
+   frames rather than decoding the header a second time. The result is
+   identical to an FEC call to opus_decode_native() followed by a regular one. */
+static int opus_decode_recover_native(OpusDecoder *st, const unsigned char *data,
+      opus_int32 len, opus_val16 *pcm_lost, int lost_frame_size, opus_val16 *pcm,
+      int frame_size, int soft_clip)
+{
+   int i, nb_samples;
+   int count, offset;
+   unsigned char toc;
+   int packet_frame_size, packet_bandwidth, packet_mode, packet_stream_channels;
+   int use_fec;
+   ec_dec lbrr_dec;
+   /* 48 x 2.5 ms = 120 ms */
+   opus_int16 size[48];
+   VALIDATE_OPUS_DECODER(st);
+   if (data==NULL || len<=0 || lost_frame_size<=0 || frame_size<=0)
+      return OPUS_BAD_ARG;
+   /* As for FEC/PLC, lost_frame_size has to be a multiple of 2.5 ms */
+   if (lost_frame_size%(st->Fs/400)!=0)
+      return OPUS_BAD_ARG;
+
    packet_mode = opus_packet_get_mode(data);
    packet_bandwidth = opus_packet_get_bandwidth(data);
    packet_frame_size = opus_packet_get_samples_per_frame(data, st->Fs);
    packet_stream_channels = opus_packet_get_nb_channels(data);
 
-   count = opus_packet_parse_impl(data, len, self_delimited, &toc, NULL,
-                                  size, &offset, packet_offset);
+   count = opus_packet_parse_impl(data, len, 0, &toc, NULL,
+                                  size, &offset, NULL);
    if (count<0)
       return count;
+   if (count*packet_frame_size > frame_size)
+      return OPUS_BUFFER_TOO_SMALL;
 
    data += offset;
 
-   if (decode_fec)
+   use_fec = lost_frame_size >= packet_frame_size && packet_mode != MODE_CELT_ONLY
+         && st->mode != MODE_CELT_ONLY;
+   if (use_fec)
    {
-      int duration_copy;
       int ret;
-      /* If no FEC can be present, run the PLC (recursive call) */
-      if (frame_size < packet_frame_size || packet_mode == MODE_CELT_ONLY || st->mode == MODE_CELT_ONLY)
-         return opus_decode_native(st, NULL, 0, pcm, frame_size, 0, 0, NULL, soft_clip);
-      /* Otherwise, run the PLC on everything except the size for which we might have FEC */
-      duration_copy = st->last_packet_duration;
-      if (frame_size-packet_frame_size!=0)
+      /* Run the PLC on everything except the size for which we might have FEC */
+      if (lost_frame_size-packet_frame_size!=0)
       {
-         ret = opus_decode_native(st, NULL, 0, pcm, frame_size-packet_frame_size, 0, 0, NULL, soft_clip);
+         ret = opus_decode_native(st, NULL, 0, pcm_lost, lost_frame_size-packet_frame_size, 0, 0, NULL, soft_clip);
          if (ret<0)
-         {
-            st->last_packet_duration = duration_copy;
             return ret;
-         }
-         celt_assert(ret==frame_size-packet_frame_size);
+         celt_assert(ret==lost_frame_size-packet_frame_size);
       }
       /* Complete with FEC */
       st->mode = packet_mode;
       st->bandwidth = packet_bandwidth;
       st->frame_size = packet_frame_size;
       st->stream_channels = packet_stream_channels;
-      ret = opus_decode_frame(st, data, size[0], pcm+st->channels*(frame_size-packet_frame_size),
-            packet_frame_size, 1);
+      ret = opus_decode_frame(st, data, size[0], pcm_lost+st->channels*(lost_frame_size-packet_frame_size),
+            packet_frame_size, 1, &lbrr_dec);
       if (ret<0)
          return ret;
-      else {
-         if (OPUS_CHECK_ARRAY(pcm, frame_size*st->channels))
-            OPUS_PRINT_INT(frame_size);
-         st->last_packet_duration = frame_size;
-         return frame_size;
-      }
+   } else {
+      int ret;
+      ret = opus_decode_native(st, NULL, 0, pcm_lost, lost_frame_size, 0, 0, NULL, soft_clip);
+      if (ret<0)
+         return ret;
+      celt_assert(ret==lost_frame_size);
    }
+   if (OPUS_CHECK_ARRAY(pcm_lost, lost_frame_size*st->channels))
+      OPUS_PRINT_INT(lost_frame_size);
 
-   if (count*packet_frame_size > frame_size)
-      return OPUS_BUFFER_TOO_SMALL;
-
-   /* Update the state as the last step to avoid updating it on an invalid packet */
    st->mode = packet_mode;
    st->bandwidth = packet_bandwidth;
    st->frame_size = packet_frame_size;
@@ -718,7 +850,8 @@ int opus_decode_native(OpusDecoder *st, const unsigned char *data,
    for (i=0;i<count;i++)
    {
       int ret;
-      ret = opus_decode_frame(st, data, size[i], pcm+nb_samples*st->channels, frame_size-nb_samples, 0);
+      ret = opus_decode_frame(st, data, size[i], pcm+nb_samples*st->channels, frame_size-nb_samples, 0,
+            use_fec && i==0 ? &lbrr_dec : NULL);
       if (ret<0)
          return ret;
       celt_assert(ret==packet_frame_size);
@@ -730,7 +863,7 @@ int opus_decode_native(OpusDecoder *st, const unsigned char *data,
       OPUS_PRINT_INT(nb_samples);
 #ifndef FIXED_POINT
    if (soft_clip)
-      opus_pcm_soft_clip(pcm, nb_samples, st->channels, st->softclip_mem);
+      opus_pcm_soft_clip_impl(pcm, nb_samples, st->channels, st->softclip_mem, st->arch);
    else
       st->softclip_mem[0]=st->softclip_mem[1]=0;
 #endif
@@ -750,6 +883,40 @@ int opus_decode(OpusDecoder *st, const unsigned char *data,
 #ifndef DISABLE_FLOAT_API
 int opus_decode_float(OpusDecoder *st, const unsigned char *data,
       opus_int32 len, float *pcm, int frame_size, int decode_fec)
+{
+   VARDECL(opus_int16, out);
+   int ret;
+   int nb_samples;
+   ALLOC_STACK;
+
+   if(frame_size<=0)
+   {
+      RESTORE_STACK;
+      return OPUS_BAD_ARG;
+   }
+   if (data != NULL && len > 0 && !decode_fec)
+   {
+      nb_samples = opus_decoder_get_nb_samples(st, data, len);
+      if (nb_samples>0)
+         frame_size = IMIN(frame_size, nb_samples);
+      else
+         return OPUS_INVALID_PACKET;
+   }
+   celt_assert(st->channels == 1 || st->channels == 2);
+   ALLOC(out, frame_size*st->channels, opus_int16);
+
+   ret = opus_decode_native(st, data, len, out, frame_size, decode_fec, 0, NULL, 0);
+   if (ret > 0)
+   {
+      celt_int16tofloat(out, pcm, ret*st->channels, st->arch);
+   }
+   RESTORE_STACK;
+   return ret;
+}
+#endif
+
+int opus_decode24(OpusDecoder *st, const unsigned char *data,
+      opus_int32 len, opus_int32 *pcm, int frame_size, int decode_fec)
 {
    VARDECL(opus_int16, out);
    int ret, i;
@@ -776,7 +943,88 @@ int opus_decode_float(OpusDecoder *st, const unsigned char *data,
    if (ret > 0)
    {
       for (i=0;i<ret*st->channels;i++)
-         pcm[i] = (1.f/32768.f)*(out[i]);
+         pcm[i] = SHL32(EXTEND32(out[i]), 8);
+   }
+   RESTORE_STACK;
+   return ret;
+}
+
+int opus_decode_parsed(OpusDecoder *st, const OpusPacketIter *it,
+      opus_val16 *pcm, int frame_size, int decode_fec)
+{
+   if(frame_size<=0)
+      return OPUS_BAD_ARG;
+   return opus_decode_iter_native(st, it, pcm, frame_size, decode_fec, 0);
+}
+
+#ifndef DISABLE_FLOAT_API
+int opus_decode_parsed_float(OpusDecoder *st, const OpusPacketIter *it,
+      float *pcm, int frame_size, int decode_fec)
+{
+   VARDECL(opus_int16, out);
+   int ret;
+   ALLOC_STACK;
+
+   if(frame_size<=0)
+   {
+      RESTORE_STACK;
+      return OPUS_BAD_ARG;
+   }
+   if (!decode_fec)
+      frame_size = IMIN(frame_size, it->nb_frames*opus_packet_get_samples_per_frame(it->data, st->Fs));
+   celt_assert(st->channels == 1 || st->channels == 2);
+   ALLOC(out, frame_size*st->channels, opus_int16);
+
+   ret = opus_decode_iter_native(st, it, out, frame_size, decode_fec, 0);
+   if (ret > 0)
+   {
+      celt_int16tofloat(out, pcm, ret*st->channels, st->arch);
+   }
+   RESTORE_STACK;
+   return ret;
+}
+#endif
+
+int opus_decode_recover(OpusDecoder *st, const unsigned char *data,
+      opus_int32 len, opus_val16 *pcm_lost, int lost_frame_size,
+      opus_val16 *pcm, int frame_size)
+{
+   return opus_decode_recover_native(st, data, len, pcm_lost, lost_frame_size, pcm, frame_size, 0);
+}
+
+#ifndef DISABLE_FLOAT_API
+int opus_decode_recover_float(OpusDecoder *st, const unsigned char *data,
+      opus_int32 len, float *pcm_lost, int lost_frame_size,
+      float *pcm, int frame_size)
+{
+   VARDECL(opus_int16, out_lost);
+   VARDECL(opus_int16, out);
+   int ret;
+   int nb_samples;
+   ALLOC_STACK;
+
+   if(lost_frame_size<=0 || frame_size<=0 || data==NULL || len<=0)
+   {
+      RESTORE_STACK;
+      return OPUS_BAD_ARG;
+   }
+   nb_samples = opus_decoder_get_nb_samples(st, data, len);
+   if (nb_samples>0)
+      frame_size = IMIN(frame_size, nb_samples);
+   else
+   {
+      RESTORE_STACK;
+      return OPUS_INVALID_PACKET;
+   }
+   celt_assert(st->channels == 1 || st->channels == 2);
+   ALLOC(out_lost, lost_frame_size*st->channels, opus_int16);
+   ALLOC(out, frame_size*st->channels, opus_int16);
+
+   ret = opus_decode_recover_native(st, data, len, out_lost, lost_frame_size, out, frame_size, 0);
+   if (ret > 0)
+   {
+      celt_int16tofloat(out_lost, pcm_lost, lost_frame_size*st->channels, st->arch);
+      celt_int16tofloat(out, pcm, ret*st->channels, st->arch);
    }
    RESTORE_STACK;
    return ret;
@@ -789,7 +1037,7 @@ int opus_decode(OpusDecoder *st, const unsigned char *data,
       opus_int32 len, opus_int16 *pcm, int frame_size, int decode_fec)
 {
    VARDECL(float, out);
-   int ret, i;
+   int ret;
    int nb_samples;
    ALLOC_STACK;
 
@@ -813,8 +1061,7 @@ int opus_decode(OpusDecoder *st, const unsigned char *data,
    ret = opus_decode_native(st, data, len, out, frame_size, decode_fec, 0, NULL, 1);
    if (ret > 0)
    {
-      for (i=0;i<ret*st->channels;i++)
-         pcm[i] = FLOAT2INT16(out[i]);
+      celt_float2int16(out, pcm, ret*st->channels, st->arch);
    }
    RESTORE_STACK;
    return ret;
@@ -828,6 +1075,120 @@ int opus_decode_float(OpusDecoder *st, const unsigned char *data,
    return opus_decode_native(st, data, len, pcm, frame_size, decode_fec, 0, NULL, 0);
 }
 
+int opus_decode24(OpusDecoder *st, const unsigned char *data,
+      opus_int32 len, opus_int32 *pcm, int frame_size, int decode_fec)
+{
+   VARDECL(float, out);
+   int ret, i;
+   int nb_samples;
+   ALLOC_STACK;
+
+   if(frame_size<=0)
+   {
+      RESTORE_STACK;
+      return OPUS_BAD_ARG;
+   }
+
+   if (data != NULL && len > 0 && !decode_fec)
+   {
+      nb_samples = opus_decoder_get_nb_samples(st, data, len);
+      if (nb_samples>0)
+         frame_size = IMIN(frame_size, nb_samples);
+      else
+         return OPUS_INVALID_PACKET;
+   }
+   celt_assert(st->channels == 1 || st->channels == 2);
+   ALLOC(out, frame_size*st->channels, float);
+
+   /* Soft clipping as for opus_decode(), since the output saturates too */
+   ret = opus_decode_native(st, data, len, out, frame_size, decode_fec, 0, NULL, 1);
+   if (ret > 0)
+   {
+      for (i=0;i<ret*st->channels;i++)
+         pcm[i] = FLOAT2INT24(out[i]);
+   }
+   RESTORE_STACK;
+   return ret;
+}
+
+int opus_decode_parsed(OpusDecoder *st, const OpusPacketIter *it,
+      opus_int16 *pcm, int frame_size, int decode_fec)
+{
+   VARDECL(float, out);
+   int ret;
+   ALLOC_STACK;
+
+   if(frame_size<=0)
+   {
+      RESTORE_STACK;
+      return OPUS_BAD_ARG;
+   }
+   if (!decode_fec)
+      frame_size = IMIN(frame_size, it->nb_frames*opus_packet_get_samples_per_frame(it->data, st->Fs));
+   celt_assert(st->channels == 1 || st->channels == 2);
+   ALLOC(out, frame_size*st->channels, float);
+
+   ret = opus_decode_iter_native(st, it, out, frame_size, decode_fec, 1);
+   if (ret > 0)
+   {
+      celt_float2int16(out, pcm, ret*st->channels, st->arch);
+   }
+   RESTORE_STACK;
+   return ret;
+}
+
+int opus_decode_parsed_float(OpusDecoder *st, const OpusPacketIter *it,
+      opus_val16 *pcm, int frame_size, int decode_fec)
+{
+   if(frame_size<=0)
+      return OPUS_BAD_ARG;
+   return opus_decode_iter_native(st, it, pcm, frame_size, decode_fec, 0);
+}
+
+int opus_decode_recover(OpusDecoder *st, const unsigned char *data,
+      opus_int32 len, opus_int16 *pcm_lost, int lost_frame_size,
+      opus_int16 *pcm, int frame_size)
+{
+   VARDECL(float, out_lost);
+   VARDECL(float, out);
+   int ret;
+   int nb_samples;
+   ALLOC_STACK;
+
+   if(lost_frame_size<=0 || frame_size<=0 || data==NULL || len<=0)
+   {
+      RESTORE_STACK;
+      return OPUS_BAD_ARG;
+   }
+   nb_samples = opus_decoder_get_nb_samples(st, data, len);
+   if (nb_samples>0)
+      frame_size = IMIN(frame_size, nb_samples);
+   else
+   {
+      RESTORE_STACK;
+      return OPUS_INVALID_PACKET;
+   }
+   celt_assert(st->channels == 1 || st->channels == 2);
+   ALLOC(out_lost, lost_frame_size*st->channels, float);
+   ALLOC(out, frame_size*st->channels, float);
+
+   ret = opus_decode_recover_native(st, data, len, out_lost, lost_frame_size, out, frame_size, 1);
+   if (ret > 0)
+   {
+      celt_float2int16(out_lost, pcm_lost, lost_frame_size*st->channels, st->arch);
+      celt_float2int16(out, pcm, ret*st->channels, st->arch);
+   }
+   RESTORE_STACK;
+   return ret;
+}
+
+int opus_decode_recover_float(OpusDecoder *st, const unsigned char *data,
+      opus_int32 len, opus_val16 *pcm_lost, int lost_frame_size,
+      opus_val16 *pcm, int frame_size)
+{
+   return opus_decode_recover_native(st, data, len, pcm_lost, lost_frame_size, pcm, frame_size, 0);
+}
+
 #endif
 
 int opus_decoder_ctl(OpusDecoder *st, int request, ...)
@@ -950,6 +1311,59 @@ int opus_decoder_ctl(OpusDecoder *st, int request, ...)
        ret = celt_decoder_ctl(celt_dec, OPUS_GET_PHASE_INVERSION_DISABLED(value));
    }
    break;
+   case OPUS_SET_BANDLIMITED_DECODE_REQUEST:
+   {
+       opus_int32 value = va_arg(ap, opus_int32);
+       if(value<0 || value>1)
+       {
+          goto bad_arg;
+       }
+       ret = celt_decoder_ctl(celt_dec, OPUS_SET_BANDLIMITED_DECODE(value));
+   }
+   break;
+   case OPUS_GET_BANDLIMITED_DECODE_REQUEST:
+   {
+       opus_int32 *value = va_arg(ap, opus_int32*);
+       if (!value)
+       {
+          goto bad_arg;
+       }
+       ret = celt_decoder_ctl(celt_dec, OPUS_GET_BANDLIMITED_DECODE(value));
+   }
+   break;
+   case OPUS_SET_PLC_COMPLEXITY_REQUEST:
+   {
+       opus_int32 value = va_arg(ap, opus_int32);
+       if(value<0 || value>10)
+       {
+          goto bad_arg;
+       }
+       ret = celt_decoder_ctl(celt_dec, OPUS_SET_PLC_COMPLEXITY(value));
+   }
+   break;
+   case OPUS_GET_PLC_COMPLEXITY_REQUEST:
+   {
+       opus_int32 *value = va_arg(ap, opus_int32*);
+       if (!value)
+       {
+          goto bad_arg;
+       }
+       ret = celt_decoder_ctl(celt_dec, OPUS_GET_PLC_COMPLEXITY(value));
+   }
+   break;
+#ifdef ENABLE_PROFILING
+   case OPUS_GET_PROFILE_REQUEST:
+   {
+       opus_uint64 *value = va_arg(ap, opus_uint64*);
+       if (!value)
+       {
+          goto bad_arg;
+       }
+       ret = celt_decoder_ctl(celt_dec, OPUS_GET_PROFILE(value));
+       silk_Get_Decoder_Profile(silk_dec, value);
+   }
+   break;
+#endif
    default:
       /*fprintf(stderr, "unknown opus_decoder_ctl() request: %d", request);*/
       ret = OPUS_UNIMPLEMENTED;
@@ -1030,3 +1444,123 @@ int opus_decoder_get_nb_samples(const OpusDecoder *dec,
 {
    return opus_packet_get_nb_samples(packet, len, dec->Fs);
 }
+
+/* Frames whose estimated level is below this (in Q8 dBFS) are reported as
+   inactive when the codec does not signal voice activity itself. */
+#define OPUS_ACTIVITY_THRESHOLD_Q8 (-60*256)
+
+int opus_packet_get_activity(const unsigned char *data, opus_int32 len,
+      unsigned char activity[48], opus_int16 level[48], opus_int16 *mem)
+{
+   int i;
+   int count;
+   int mode;
+   int bandwidth;
+   int frame_size;
+   int channels;
+   int ret;
+   unsigned char toc;
+   const unsigned char *frames[48];
+   opus_int16 size[48];
+   const CELTMode *celt_mode;
+   opus_val16 oldBandE[OPUS_ACTIVITY_MEM_SIZE];
+
+   if (data==NULL || len<1 || activity==NULL || level==NULL || mem==NULL)
+      return OPUS_BAD_ARG;
+   count = opus_packet_parse_impl(data, len, 0, &toc, frames, size, NULL, NULL);
+   if (count<0)
+      return count;
+   mode = opus_packet_get_mode(data);
+   bandwidth = opus_packet_get_bandwidth(data);
+   frame_size = opus_packet_get_samples_per_frame(data, 48000);
+   channels = opus_packet_get_nb_channels(data);
+   celt_mode = opus_custom_mode_create(48000, 960, NULL);
+
+   if (mode == MODE_CELT_ONLY)
+   {
+      for (i=0;i<OPUS_ACTIVITY_MEM_SIZE;i++)
+#ifdef FIXED_POINT
+         oldBandE[i] = SHL16(mem[i], DB_SHIFT-8);
+#else
+         oldBandE[i] = (1.f/256)*mem[i];
+#endif
+   }
+
+   for (i=0;i<count;i++)
+   {
+      opus_int32 frame_level;
+      if (size[i]<=1)
+      {
+         /* DTX or lost frame, nothing to decode. */
+         activity[i] = 0;
+         level[i] = -32768;
+         continue;
+      }
+      if (mode != MODE_CELT_ONLY)
+      {
+         /* For hybrid frames, the SILK layer carries the bulk of the energy. */
+         silk_DecControlStruct DecControl;
+         ec_dec dec;
+         opus_int VADFlag;
+         opus_int32 gain_Q16;
+
+         DecControl.nChannelsAPI = channels;
+         DecControl.nChannelsInternal = channels;
+         DecControl.API_sampleRate = 48000;
+         DecControl.payloadSize_ms = IMAX(10, 1000 * frame_size / 48000);
+         if (bandwidth == OPUS_BANDWIDTH_NARROWBAND)
+            DecControl.internalSampleRate = 8000;
+         else if (bandwidth == OPUS_BANDWIDTH_MEDIUMBAND)
+            DecControl.internalSampleRate = 12000;
+         else
+            DecControl.internalSampleRate = 16000;
+         ec_dec_init(&dec, (unsigned char*)frames[i], size[i]);
+         ret = silk_Get_Activity(&DecControl, &dec, &VADFlag, &gain_Q16);
+         if (ret)
+            return OPUS_INTERNAL_ERROR;
+         /* 6.0206 dB per octave of gain, in Q8. */
+         frame_level = silk_RSHIFT(silk_MUL(silk_lin2log(IMAX(gain_Q16, 1)) - (31<<7), 1541), 7);
+         activity[i] = VADFlag != 0;
+      } else {
+         int LM;
+         int endband;
+         int silence;
+         if (frame_size < 120 || frame_size > 960)
+            return OPUS_INVALID_PACKET;
+         for (LM=0;LM<=celt_mode->maxLM;LM++)
+            if (celt_mode->shortMdctSize<<LM==frame_size)
+               break;
+         switch(bandwidth)
+         {
+            case OPUS_BANDWIDTH_NARROWBAND:
+               endband = 13;
+               break;
+            case OPUS_BANDWIDTH_MEDIUMBAND:
+            case OPUS_BANDWIDTH_WIDEBAND:
+               endband = 17;
+               break;
+            case OPUS_BANDWIDTH_SUPERWIDEBAND:
+               endband = 19;
+               break;
+            default:
+               endband = 21;
+               break;
+         }
+         silence = celt_decode_coarse_energy(celt_mode, frames[i], size[i], LM,
+               channels, endband, oldBandE, &frame_level);
+         activity[i] = !silence && frame_level > OPUS_ACTIVITY_THRESHOLD_Q8;
+      }
+      level[i] = (opus_int16)IMAX(-32767, IMIN(0, frame_level));
+   }
+
+   if (mode == MODE_CELT_ONLY)
+   {
+      for (i=0;i<OPUS_ACTIVITY_MEM_SIZE;i++)
+#ifdef FIXED_POINT
+         mem[i] = PSHR32(oldBandE[i], DB_SHIFT-8);
+#else
+         mem[i] = (opus_int16)float2int(256.f*oldBandE[i]);
+#endif
+   }
+   return count;
+}
@@ -34,6 +34,15 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 #include "opus.h"
 #include "debug.h"
 #include "opus_types.h"
@@ -47,7 +56,9 @@ void print_usage( char* argv[] )
     fprintf(stderr, "Usage: %s [-e] <application> <sampling rate (Hz)> <channels (1/2)> "
         "<bits per second>  [options] <input> <output>\n", argv[0]);
     fprintf(stderr, "       %s -d <sampling rate (Hz)> <channels (1/2)> "
-        "[options] <input> <output>\n\n", argv[0]);
+        "[options] <input> <output>\n", argv[0]);
+    fprintf(stderr, "       %s -load <application> <sampling rate (Hz)> <channels (1/2)> "
+        "<bits per second> [options] <input>\n\n", argv[0]);
     fprintf(stderr, "application: voip | audio | restricted-lowdelay\n" );
     fprintf(stderr, "options:\n" );
     fprintf(stderr, "-e                   : only runs the encoder (output the bit-stream)\n" );
@@ -63,6 +74,12 @@ void print_usage( char* argv[] )
     fprintf(stderr, "-forcemono           : force mono encoding, even for stereo input\n" );
     fprintf(stderr, "-dtx                 : enable SILK DTX\n" );
     fprintf(stderr, "-loss <perc>         : simulate packet loss, in percent (0-100); default: 0\n" );
+    fprintf(stderr, "-load                : runs independent encoder+decoder instances and reports\n" );
+    fprintf(stderr, "                       the realtime factor, frame latency and peak memory\n" );
+    fprintf(stderr, "-instances <K>       : number of instances in load mode; default: 1\n" );
+    fprintf(stderr, "-threads <T>         : number of threads in load mode; default: 1\n" );
+    fprintf(stderr, "-duration <seconds>  : audio coded by each instance in load mode, looping over\n" );
+    fprintf(stderr, "                       the input; default: length of the input\n" );
 }
 
 static void int_to_char(opus_uint32 i, unsigned char ch[4])
@@ -80,6 +97,7 @@ static opus_uint32 char_to_int(unsigned char ch[4])
 }
 
 #define check_encoder_option(decode_only, opt) do {if (decode_only) {fprintf(stderr, "option %s is only for encoding\n", opt); goto failure;}} while(0)
+#define check_load_option(load_mode, opt) do {if (!load_mode) {fprintf(stderr, "option %s is only for load mode\n", opt); goto failure;}} while(0)
 
 static const int silk8_test[][4] = {
       {MODE_SILK_ONLY, OPUS_BANDWIDTH_NARROWBAND, 960*3, 1},
@@ -207,6 +225,291 @@ static OpusDecoder *ms_opus_decoder_create(opus_int32 Fs, int channels, int *err
 }
 #endif
 
+/* Load mode: K independent encoder+decoder pairs spread over T threads, each
+   coding the input for a given duration, as a server handling many streams. */
+
+#define MAX_LOAD_THREADS 256
+
+typedef struct {
+   const short *pcm;
+   opus_int32 pcm_len;       /* samples per channel */
+   opus_int32 sampling_rate;
+   int channels;
+   int application;
+   opus_int32 bitrate_bps;
+   int bandwidth;
+   int frame_size;
+   int variable_duration;
+   int use_vbr;
+   int cvbr;
+   int complexity;
+   int use_inbandfec;
+   int forcechannels;
+   int use_dtx;
+   int packet_loss_perc;
+   int max_payload_bytes;
+   opus_int32 nb_frames;     /* per instance */
+} LoadConfig;
+
+typedef struct {
+   const LoadConfig *cfg;
+   int first_instance;
+   int nb_instances;
+   int total_instances;      /* over all threads */
+   float *latency;           /* seconds, nb_instances*nb_frames entries */
+   opus_int32 nb_latency;
+   double bits;
+   int error;
+} LoadThread;
+
+static double load_time(void)
+{
+#if defined(_WIN32)
+   LARGE_INTEGER t, f;
+   QueryPerformanceCounter(&t);
+   QueryPerformanceFrequency(&f);
+   return (double)t.QuadPart/(double)f.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + 1e-9*ts.tv_nsec;
+#else
+   return (double)clock()/CLOCKS_PER_SEC;
+#endif
+}
+
+/* Peak resident set size in kB, or -1 where unknown. */
+static long load_peak_rss_kb(void)
+{
+#ifdef _WIN32
+   return -1;
+#else
+   struct rusage ru;
+   if (getrusage(RUSAGE_SELF, &ru) != 0)
+      return -1;
+#ifdef __APPLE__
+   return (long)(ru.ru_maxrss/1024);
+#else
+   return (long)ru.ru_maxrss;
+#endif
+#endif
+}
+
+static void *load_thread(void *arg)
+{
+   LoadThread *t = (LoadThread *)arg;
+   const LoadConfig *cfg = t->cfg;
+   OpusEncoder **enc;
+   OpusDecoder **dec;
+   opus_int32 *pos;
+   short *in, *out;
+   unsigned char *packet;
+   opus_uint32 seed;
+   opus_int32 f;
+   int k, err;
+
+   enc = (OpusEncoder **)calloc(t->nb_instances, sizeof(*enc));
+   dec = (OpusDecoder **)calloc(t->nb_instances, sizeof(*dec));
+   pos = (opus_int32 *)calloc(t->nb_instances, sizeof(*pos));
+   in = (short *)malloc(cfg->frame_size*cfg->channels*sizeof(*in));
+   out = (short *)malloc(cfg->frame_size*cfg->channels*sizeof(*out));
+   packet = (unsigned char *)malloc(cfg->max_payload_bytes);
+   seed = 1+t->first_instance;
+   if (!enc || !dec || !pos || !in || !out || !packet)
+   {
+      t->error = OPUS_ALLOC_FAIL;
+      goto done;
+   }
+   for (k=0;k<t->nb_instances;k++)
+   {
+      int instance = t->first_instance+k;
+      enc[k] = opus_encoder_create(cfg->sampling_rate, cfg->channels, cfg->application, &err);
+      if (err != OPUS_OK)
+      {
+         t->error = err;
+         goto done;
+      }
+      opus_encoder_ctl(enc[k], OPUS_SET_BITRATE(cfg->bitrate_bps));
+      opus_encoder_ctl(enc[k], OPUS_SET_BANDWIDTH(cfg->bandwidth));
+      opus_encoder_ctl(enc[k], OPUS_SET_VBR(cfg->use_vbr));
+      opus_encoder_ctl(enc[k], OPUS_SET_VBR_CONSTRAINT(cfg->cvbr));
+      opus_encoder_ctl(enc[k], OPUS_SET_COMPLEXITY(cfg->complexity));
+      opus_encoder_ctl(enc[k], OPUS_SET_INBAND_FEC(cfg->use_inbandfec));
+      opus_encoder_ctl(enc[k], OPUS_SET_FORCE_CHANNELS(cfg->forcechannels));
+      opus_encoder_ctl(enc[k], OPUS_SET_DTX(cfg->use_dtx));
+      opus_encoder_ctl(enc[k], OPUS_SET_PACKET_LOSS_PERC(cfg->packet_loss_perc));
+      opus_encoder_ctl(enc[k], OPUS_SET_LSB_DEPTH(16));
+      opus_encoder_ctl(enc[k], OPUS_SET_EXPERT_FRAME_DURATION(cfg->variable_duration));
+      dec[k] = opus_decoder_create(cfg->sampling_rate, cfg->channels, &err);
+      if (err != OPUS_OK)
+      {
+         t->error = err;
+         goto done;
+      }
+      /* Stagger the instances over the input so they don't code the same
+         audio in lockstep. */
+      pos[k] = (opus_int32)((opus_int64)cfg->pcm_len*instance/t->total_instances);
+   }
+   /* Frames are interleaved across instances, as a server would process
+      its streams. The latency of a frame covers its encode and decode. */
+   for (f=0;f<cfg->nb_frames;f++)
+   {
+      for (k=0;k<t->nb_instances;k++)
+      {
+         double start;
+         int i, len, samples, lost;
+         for (i=0;i<cfg->frame_size;i++)
+         {
+            int c;
+            for (c=0;c<cfg->channels;c++)
+               in[i*cfg->channels+c] = cfg->pcm[pos[k]*cfg->channels+c];
+            if (++pos[k] >= cfg->pcm_len)
+               pos[k] = 0;
+         }
+         seed = 1664525*seed + 1013904223;
+         lost = cfg->packet_loss_perc>0 && (int)((seed>>16)%100) < cfg->packet_loss_perc;
+         start = load_time();
+         len = opus_encode(enc[k], in, cfg->frame_size, packet, cfg->max_payload_bytes);
+         if (len < 0)
+         {
+            t->error = len;
+            goto done;
+         }
+         samples = opus_decode(dec[k], lost ? NULL : packet, len, out, cfg->frame_size, 0);
+         if (samples < 0)
+         {
+            t->error = samples;
+            goto done;
+         }
+         t->latency[t->nb_latency++] = (float)(load_time() - start);
+         t->bits += 8.*len;
+      }
+   }
+done:
+   if (enc && dec)
+   {
+      for (k=0;k<t->nb_instances;k++)
+      {
+         opus_encoder_destroy(enc[k]);
+         opus_decoder_destroy(dec[k]);
+      }
+   }
+   free(enc);
+   free(dec);
+   free(pos);
+   free(in);
+   free(out);
+   free(packet);
+   return NULL;
+}
+
+static int compare_float(const void *a, const void *b)
+{
+   float x = *(const float *)a;
+   float y = *(const float *)b;
+   return (x > y) - (x < y);
+}
+
+static int run_load(const LoadConfig *cfg, int nb_instances, int nb_threads)
+{
+   LoadThread threads[MAX_LOAD_THREADS];
+   float *latency;
+   opus_int32 nb_latency;
+   double start, elapsed, audio_seconds, bits;
+   long rss;
+   int i, first;
+   int ret = EXIT_FAILURE;
+
+   if (nb_threads > nb_instances)
+      nb_threads = nb_instances;
+   latency = (float *)malloc((size_t)nb_instances*cfg->nb_frames*sizeof(*latency));
+   if (!latency)
+   {
+      fprintf(stderr, "Cannot allocate latency buffer\n");
+      return EXIT_FAILURE;
+   }
+   first = 0;
+   for (i=0;i<nb_threads;i++)
+   {
+      threads[i].cfg = cfg;
+      threads[i].first_instance = first;
+      threads[i].nb_instances = nb_instances/nb_threads + (i < nb_instances%nb_threads);
+      threads[i].total_instances = nb_instances;
+      threads[i].latency = latency + (size_t)first*cfg->nb_frames;
+      threads[i].nb_latency = 0;
+      threads[i].bits = 0;
+      threads[i].error = OPUS_OK;
+      first += threads[i].nb_instances;
+   }
+
+   fprintf(stderr, "Load test: %d instances on %d threads, %.1f s of audio each\n",
+         nb_instances, nb_threads, (double)cfg->nb_frames*cfg->frame_size/cfg->sampling_rate);
+   start = load_time();
+#ifdef HAVE_PTHREAD
+   {
+      pthread_t tid[MAX_LOAD_THREADS];
+      int j;
+      for (i=1;i<nb_threads;i++)
+      {
+         if (pthread_create(&tid[i], NULL, load_thread, &threads[i]) != 0)
+         {
+            fprintf(stderr, "Cannot create thread %d\n", i);
+            for (j=1;j<i;j++)
+               pthread_join(tid[j], NULL);
+            goto failure;
+         }
+      }
+      load_thread(&threads[0]);
+      for (i=1;i<nb_threads;i++)
+         pthread_join(tid[i], NULL);
+   }
+#else
+   load_thread(&threads[0]);
+#endif
+   elapsed = load_time() - start;
+
+   /* Gather the latencies of all threads in one contiguous block. */
+   nb_latency = 0;
+   for (i=0;i<nb_threads;i++)
+   {
+      if (threads[i].error != OPUS_OK)
+      {
+         fprintf(stderr, "Thread %d failed: %s\n", i, opus_strerror(threads[i].error));
+         goto failure;
+      }
+      memmove(latency+nb_latency, threads[i].latency, threads[i].nb_latency*sizeof(*latency));
+      nb_latency += threads[i].nb_latency;
+   }
+   if (nb_latency == 0 || elapsed <= 0)
+   {
+      fprintf(stderr, "No frames were coded\n");
+      goto failure;
+   }
+   qsort(latency, nb_latency, sizeof(*latency), compare_float);
+
+   audio_seconds = (double)nb_instances*cfg->nb_frames*cfg->frame_size/cfg->sampling_rate;
+   fprintf(stderr, "wall time:                   %7.3f s\n", elapsed);
+   fprintf(stderr, "aggregate realtime factor:   %7.2fx\n", audio_seconds/elapsed);
+   fprintf(stderr, "streams per thread:          %7.2f\n", audio_seconds/elapsed/nb_threads);
+   bits = 0;
+   for (i=0;i<nb_threads;i++)
+      bits += threads[i].bits;
+   fprintf(stderr, "average bitrate:             %7.3f kb/s\n", 1e-3*bits/audio_seconds);
+   fprintf(stderr, "frame latency p50:           %7.3f ms\n", 1e3*latency[(nb_latency-1)/2]);
+   fprintf(stderr, "frame latency p99:           %7.3f ms\n", 1e3*latency[(opus_int32)(0.99*(nb_latency-1))]);
+   fprintf(stderr, "frame latency p99.9:         %7.3f ms\n", 1e3*latency[(opus_int32)(0.999*(nb_latency-1))]);
+   fprintf(stderr, "frame latency max:           %7.3f ms\n", 1e3*latency[nb_latency-1]);
+   rss = load_peak_rss_kb();
+   if (rss >= 0)
+      fprintf(stderr, "peak RSS:                    %7ld kB\n", rss);
+   else
+      fprintf(stderr, "peak RSS:                    unknown\n");
+   ret = EXIT_SUCCESS;
+failure:
+   free(latency);
+   return ret;
+}
+
 int main(int argc, char *argv[])
 {
     int err;
@@ -263,6 +566,11 @@ int main(int argc, char *argv[])
     int remaining=0;
     int variable_duration=OPUS_FRAMESIZE_ARG;
     int delayed_decision=0;
+    int load_mode=0;
+    int nb_instances=1;
+    int nb_threads=1;
+    double duration=0;
+    short *load_pcm=NULL;
     int ret = EXIT_FAILURE;
 
     if (argc < 5 )
@@ -283,6 +591,10 @@ int main(int argc, char *argv[])
     {
         decode_only = 1;
         args++;
+    } else if (strcmp(argv[args], "-load")==0)
+    {
+        load_mode = 1;
+        args++;
     }
     if (!decode_only && argc < 7 )
     {
@@ -340,7 +652,7 @@ int main(int argc, char *argv[])
     use_dtx = 0;
     packet_loss_perc = 0;
 
-    while( args < argc - 2 ) {
+    while( args < argc - 2 + load_mode ) {
         /* process command line options */
         if( strcmp( argv[ args ], "-cbr" ) == 0 ) {
             check_encoder_option(decode_only, "-cbr");
@@ -422,6 +734,18 @@ int main(int argc, char *argv[])
         } else if( strcmp( argv[ args ], "-loss" ) == 0 ) {
             packet_loss_perc = atoi( argv[ args + 1 ] );
             args += 2;
+        } else if( strcmp( argv[ args ], "-instances" ) == 0 ) {
+            check_load_option(load_mode, "-instances");
+            nb_instances = atoi( argv[ args + 1 ] );
+            args += 2;
+        } else if( strcmp( argv[ args ], "-threads" ) == 0 ) {
+            check_load_option(load_mode, "-threads");
+            nb_threads = atoi( argv[ args + 1 ] );
+            args += 2;
+        } else if( strcmp( argv[ args ], "-duration" ) == 0 ) {
+            check_load_option(load_mode, "-duration");
+            duration = atof( argv[ args + 1 ] );
+            args += 2;
         } else if( strcmp( argv[ args ], "-sweep" ) == 0 ) {
             check_encoder_option(decode_only, "-sweep");
             sweep_bps = atoi( argv[ args + 1 ] );
@@ -490,6 +814,92 @@ int main(int argc, char *argv[])
         goto failure;
     }
 
+    if (load_mode)
+    {
+        LoadConfig cfg;
+        long size;
+        if (sweep_bps || sweep_max || random_framesize || random_fec
+              || mode_list || delayed_decision)
+        {
+            fprintf(stderr, "Only fixed encoder settings are supported in load mode\n");
+            goto failure;
+        }
+        if (nb_instances < 1)
+        {
+            fprintf(stderr, "The number of instances must be at least 1\n");
+            goto failure;
+        }
+#ifdef HAVE_PTHREAD
+        if (nb_threads < 1 || nb_threads > MAX_LOAD_THREADS)
+        {
+            fprintf(stderr, "The number of threads must be between 1 and %d\n",
+                            MAX_LOAD_THREADS);
+            goto failure;
+        }
+#else
+        if (nb_threads != 1)
+        {
+            fprintf(stderr, "This build of opus_demo has no thread support\n");
+            goto failure;
+        }
+#endif
+        inFile = argv[argc-1];
+        fin = fopen(inFile, "rb");
+        if (!fin)
+        {
+            fprintf (stderr, "Could not open input file %s\n", inFile);
+            goto failure;
+        }
+        fseek(fin, 0, SEEK_END);
+        size = ftell(fin);
+        fseek(fin, 0, SEEK_SET);
+        cfg.pcm_len = (opus_int32)(size/(long)(sizeof(short)*channels));
+        if (cfg.pcm_len < frame_size)
+        {
+            fprintf(stderr, "The input must hold at least one frame\n");
+            goto failure;
+        }
+        load_pcm = (short*)malloc((size_t)cfg.pcm_len*channels*sizeof(short));
+        fbytes = (unsigned char*)malloc((size_t)cfg.pcm_len*channels*sizeof(short));
+        if (!load_pcm || !fbytes || fread(fbytes, sizeof(short)*channels,
+              cfg.pcm_len, fin) != (size_t)cfg.pcm_len)
+        {
+            fprintf(stderr, "Could not read input file %s\n", inFile);
+            goto failure;
+        }
+        for (k=0;k<cfg.pcm_len*channels;k++)
+        {
+            opus_int32 s;
+            s=fbytes[2*k+1]<<8|fbytes[2*k];
+            s=((s&0xFFFF)^0x8000)-0x8000;
+            load_pcm[k]=s;
+        }
+        cfg.pcm = load_pcm;
+        cfg.sampling_rate = sampling_rate;
+        cfg.channels = channels;
+        cfg.application = application;
+        cfg.bitrate_bps = bitrate_bps;
+        cfg.bandwidth = bandwidth;
+        cfg.frame_size = frame_size;
+        cfg.variable_duration = variable_duration;
+        cfg.use_vbr = use_vbr;
+        cfg.cvbr = cvbr;
+        cfg.complexity = complexity;
+        cfg.use_inbandfec = use_inbandfec;
+        cfg.forcechannels = forcechannels;
+        cfg.use_dtx = use_dtx;
+        cfg.packet_loss_perc = packet_loss_perc;
+        cfg.max_payload_bytes = max_payload_bytes;
+        if (duration > 0)
+           cfg.nb_frames = (opus_int32)(duration*sampling_rate/frame_size + .5);
+        else
+           cfg.nb_frames = cfg.pcm_len/frame_size;
+        if (cfg.nb_frames < 1)
+           cfg.nb_frames = 1;
+        ret = run_load(&cfg, nb_instances, nb_threads);
+        goto failure;
+    }
+
     inFile = argv[argc-2];
     fin = fopen(inFile, "rb");
     if (!fin)
@@ -888,5 +1298,6 @@ failure:
     free(in);
     free(out);
     free(fbytes);
+    free(load_pcm);
     return ret;
 }
@@ -45,6 +45,7 @@
 #include "analysis.h"
 #include "mathops.h"
 #include "tuning_parameters.h"
+#include "profile.h"
 #ifdef FIXED_POINT
 #include "fixed/structs_FIX.h"
 #else
@@ -53,6 +54,12 @@
 
 #define MAX_ENCODER_BUFFER 480
 
+/* Parts of the state that encoding has modified since the last init or
+   reset (OpusEncoder.dirty), so that OPUS_RESET_STATE can skip the rest */
+#define DIRTY_ENCODER  1
+#define DIRTY_SILK     2
+#define DIRTY_ANALYSIS 4
+
 #ifndef DISABLE_FLOAT_API
 #define PSEUDO_SNR_THRESHOLD 316.23f    /* 10^(25/10) */
 #endif
@@ -87,8 +94,14 @@ struct OpusEncoder {
     int          lfe;
     int          arch;
     int          use_dtx;                 /* general DTX for both SILK and CELT */
+    int          user_complexity;         /* upper bound when adapting to cpu_budget_us */
+    opus_int32   cpu_budget_us;
+    opus_encoder_trace_func trace_callback;
+    void        *trace_user_data;
 #ifndef DISABLE_FLOAT_API
-    TonalityAnalysisState analysis;
+    /* Offset of the TonalityAnalysisState after the CELT encoder, 0 if the
+       encoder was initialized with OPUS_ENCODER_NO_ANALYSIS */
+    int          analysis_offset;
 #endif
 
 #define OPUS_ENCODER_RESET_START stream_channels
@@ -115,8 +128,20 @@ struct OpusEncoder {
     int          nb_no_activity_ms_Q1;
     opus_val32   peak_signal_energy;
 #endif
+    int          prev_dtx;      /* last frame was an Opus DTX frame */
+    unsigned char prev_dtx_toc;
     int          nonfinal_frame; /* current frame is not the final in a packet */
     opus_uint32  rangeFinal;
+    int          dirty;
+    /* Adaptive complexity (OPUS_SET_CPU_BUDGET_US) */
+    opus_int32   cpu_avg_us_Q4;
+    int          cpu_hold;
+    int          cpu_up_wait;
+    int          cpu_up_delay;
+    int          cpu_probe;
+#ifdef ENABLE_PROFILING
+    opus_uint64  profile[OPUS_PROFILE_STAGES];
+#endif
 };
 
 /* Transition tables for the voice and music. First column is the
@@ -165,21 +190,40 @@ static const opus_int32 fec_thresholds[] = {
         22000, 1000, /* FB */
 };
 
-int opus_encoder_get_size(int channels)
+#ifndef DISABLE_FLOAT_API
+static OPUS_INLINE TonalityAnalysisState *get_analysis(OpusEncoder *st)
+{
+   if (!st->analysis_offset)
+      return NULL;
+   return (TonalityAnalysisState*)(void*)((char*)st+st->analysis_offset);
+}
+#endif
+
+int opus_encoder_get_size_ext(int channels, int flags)
 {
     int silkEncSizeBytes, celtEncSizeBytes;
     int ret;
-    if (channels<1 || channels > 2)
+    if (channels<1 || channels > 2 || (flags & ~OPUS_ENCODER_NO_ANALYSIS))
         return 0;
     ret = silk_Get_Encoder_Size( &silkEncSizeBytes );
     if (ret)
         return 0;
     silkEncSizeBytes = align(silkEncSizeBytes);
     celtEncSizeBytes = celt_encoder_get_size(channels);
+#ifndef DISABLE_FLOAT_API
+    if (!(flags & OPUS_ENCODER_NO_ANALYSIS))
+        return align(sizeof(OpusEncoder))+silkEncSizeBytes+align(celtEncSizeBytes)
+              +sizeof(TonalityAnalysisState);
+#endif
     return align(sizeof(OpusEncoder))+silkEncSizeBytes+celtEncSizeBytes;
 }
 
-int opus_encoder_init(OpusEncoder* st, opus_int32 Fs, int channels, int application)
+int opus_encoder_get_size(int channels)
+{
+    return opus_encoder_get_size_ext(channels, 0);
+}
+
+int opus_encoder_init_ext(OpusEncoder* st, opus_int32 Fs, int channels, int application, int flags)
 {
     void *silk_enc;
     CELTEncoder *celt_enc;
@@ -188,10 +232,11 @@ int opus_encoder_init(OpusEncoder* st, opus_int32 Fs, int channels, int applicat
 
    if((Fs!=48000&&Fs!=24000&&Fs!=16000&&Fs!=12000&&Fs!=8000)||(channels!=1&&channels!=2)||
         (application != OPUS_APPLICATION_VOIP && application != OPUS_APPLICATION_AUDIO
-        && application != OPUS_APPLICATION_RESTRICTED_LOWDELAY))
+        && application != OPUS_APPLICATION_RESTRICTED_LOWDELAY)||
+        (flags & ~OPUS_ENCODER_NO_ANALYSIS))
         return OPUS_BAD_ARG;
 
-    OPUS_CLEAR((char*)st, opus_encoder_get_size(channels));
+    OPUS_CLEAR((char*)st, opus_encoder_get_size_ext(channels, flags));
     /* Create SILK encoder */
     ret = silk_Get_Encoder_Size( &silkEncSizeBytes );
     if (ret)
@@ -199,6 +244,10 @@ int opus_encoder_init(OpusEncoder* st, opus_int32 Fs, int channels, int applicat
     silkEncSizeBytes = align(silkEncSizeBytes);
     st->silk_enc_offset = align(sizeof(OpusEncoder));
     st->celt_enc_offset = st->silk_enc_offset+silkEncSizeBytes;
+#ifndef DISABLE_FLOAT_API
+    if (!(flags & OPUS_ENCODER_NO_ANALYSIS))
+        st->analysis_offset = st->celt_enc_offset+align(celt_encoder_get_size(channels));
+#endif
     silk_enc = (char*)st+st->silk_enc_offset;
     celt_enc = (CELTEncoder*)((char*)st+st->celt_enc_offset);
 
@@ -234,6 +283,7 @@ int opus_encoder_init(OpusEncoder* st, opus_int32 Fs, int channels, int applicat
 
     celt_encoder_ctl(celt_enc, CELT_SET_SIGNALLING(0));
     celt_encoder_ctl(celt_enc, OPUS_SET_COMPLEXITY(st->silk_mode.complexity));
+    st->user_complexity = st->silk_mode.complexity;
 
     st->use_vbr = 1;
     /* Makes constrained VBR the default (safer for real-time use) */
@@ -263,13 +313,22 @@ int opus_encoder_init(OpusEncoder* st, opus_int32 Fs, int channels, int applicat
     st->bandwidth = OPUS_BANDWIDTH_FULLBAND;
 
 #ifndef DISABLE_FLOAT_API
-    tonality_analysis_init(&st->analysis, st->Fs);
-    st->analysis.application = st->application;
+    if (st->analysis_offset)
+    {
+        TonalityAnalysisState *analysis = get_analysis(st);
+        tonality_analysis_init(analysis, st->Fs);
+        analysis->application = st->application;
+    }
 #endif
 
     return OPUS_OK;
 }
 
+int opus_encoder_init(OpusEncoder* st, opus_int32 Fs, int channels, int application)
+{
+    return opus_encoder_init_ext(st, Fs, channels, application, 0);
+}
+
 static unsigned char gen_toc(int mode, int framerate, int bandwidth, int channels)
 {
    int period;
@@ -513,26 +572,27 @@ static void gain_fade(const opus_val16 *in, opus_val16 *out, opus_val16 g1, opus
     while (++c<channels);
 }
 
-OpusEncoder *opus_encoder_create(opus_int32 Fs, int channels, int application, int *error)
+OpusEncoder *opus_encoder_create_ext(opus_int32 Fs, int channels, int application, int flags, int *error)
 {
    int ret;
    OpusEncoder *st;
    if((Fs!=48000&&Fs!=24000&&Fs!=16000&&Fs!=12000&&Fs!=8000)||(channels!=1&&channels!=2)||
        (application != OPUS_APPLICATION_VOIP && application != OPUS_APPLICATION_AUDIO
-       && application != OPUS_APPLICATION_RESTRICTED_LOWDELAY))
+       && application != OPUS_APPLICATION_RESTRICTED_LOWDELAY)||
+       (flags & ~OPUS_ENCODER_NO_ANALYSIS))
    {
       if (error)
          *error = OPUS_BAD_ARG;
       return NULL;
    }
-   st = (OpusEncoder *)opus_alloc(opus_encoder_get_size(channels));
+   st = (OpusEncoder *)opus_alloc(opus_encoder_get_size_ext(channels, flags));
    if (st == NULL)
    {
       if (error)
          *error = OPUS_ALLOC_FAIL;
       return NULL;
    }
-   ret = opus_encoder_init(st, Fs, channels, application);
+   ret = opus_encoder_init_ext(st, Fs, channels, application, flags);
    if (error)
       *error = ret;
    if (ret != OPUS_OK)
@@ -543,6 +603,11 @@ OpusEncoder *opus_encoder_create(opus_int32 Fs, int channels, int application, i
    return st;
 }
 
+OpusEncoder *opus_encoder_create(opus_int32 Fs, int channels, int application, int *error)
+{
+   return opus_encoder_create_ext(Fs, channels, application, 0, error);
+}
+
 static opus_int32 user_bitrate_to_bitrate(OpusEncoder *st, int frame_size, int max_data_bytes)
 {
   if(!frame_size)frame_size=st->Fs/400;
@@ -608,6 +673,35 @@ void downmix_int(const void *_x, opus_val32 *y, int subframe, int offset, int c1
    }
 }
 
+#ifdef FIXED_POINT
+#define INT24TOVAL(x) SHR32(x, 8)
+#else
+#define INT24TOVAL(x) ((1.f/256)*(x))
+#endif
+
+void downmix_int24(const void *_x, opus_val32 *y, int subframe, int offset, int c1, int c2, int C)
+{
+   const opus_int32 *x;
+   int j;
+
+   x = (const opus_int32 *)_x;
+   for (j=0;j<subframe;j++)
+      y[j] = INT24TOVAL(x[(j+offset)*C+c1]);
+   if (c2>-1)
+   {
+      for (j=0;j<subframe;j++)
+         y[j] += INT24TOVAL(x[(j+offset)*C+c2]);
+   } else if (c2==-2)
+   {
+      int c;
+      for (c=1;c<C;c++)
+      {
+         for (j=0;j<subframe;j++)
+            y[j] += INT24TOVAL(x[(j+offset)*C+c]);
+      }
+   }
+}
+
 opus_int32 frame_size_select(opus_int32 frame_size, int variable_duration, opus_int32 Fs)
 {
    int new_size;
@@ -921,6 +1015,11 @@ static int decide_dtx_mode(opus_int activity,            /* indicates if this fr
 
 #endif
 
+static opus_int32 opus_encode_frame_native(OpusEncoder *st, const opus_val16 *pcm, int frame_size,
+                unsigned char *data, opus_int32 out_data_bytes, int lsb_depth,
+                const void *analysis_pcm, opus_int32 analysis_size, int c1, int c2,
+                int analysis_channels, downmix_func downmix, int float_api);
+
 static opus_int32 encode_multiframe_packet(OpusEncoder *st,
                                            const opus_val16 *pcm,
                                            int nb_frames,
@@ -983,7 +1082,7 @@ static opus_int32 encode_multiframe_packet(OpusEncoder *st,
       if (to_celt && i==nb_frames-1)
          st->user_forced_mode = MODE_CELT_ONLY;
 
-      tmp_len = opus_encode_native(st, pcm+i*(st->channels*frame_size), frame_size,
+      tmp_len = opus_encode_frame_native(st, pcm+i*(st->channels*frame_size), frame_size,
          tmp_data+i*bytes_per_frame, bytes_per_frame, lsb_depth, NULL, 0, 0, 0, 0,
          NULL, float_api);
 
@@ -1048,7 +1147,80 @@ static int compute_redundancy_bytes(opus_int32 max_data_bytes, opus_int32 bitrat
    return redundancy_bytes;
 }
 
-opus_int32 opus_encode_native(OpusEncoder *st, const opus_val16 *pcm, int frame_size,
+static void set_complexity(OpusEncoder *st, int complexity)
+{
+   CELTEncoder *celt_enc = (CELTEncoder*)(void*)((char*)st+st->celt_enc_offset);
+   st->silk_mode.complexity = complexity;
+   celt_encoder_ctl(celt_enc, OPUS_SET_COMPLEXITY(complexity));
+}
+
+/* Frames to wait after a complexity change before judging the new setting */
+#define CPU_BUDGET_HOLD 8
+/* Frames to wait before trying a higher complexity again. Doubled each time
+   an increase has to be undone, so that a setting just over budget is not
+   retried too often. */
+#define CPU_UP_DELAY_MIN 32
+#define CPU_UP_DELAY_MAX 1024
+
+/* Adapts the complexity to the OPUS_SET_CPU_BUDGET_US budget from the time
+   the last frame took. The average cost is tracked per complexity setting and
+   only one step is taken at a time, down as soon as the average exceeds the
+   budget and up only when it is below 3/4 of it. */
+static void update_cpu_budget(OpusEncoder *st, opus_int32 elapsed_us)
+{
+   opus_int32 elapsed_Q4;
+   opus_int32 budget_Q4;
+   int complexity;
+
+   elapsed_Q4 = SHL32(elapsed_us, 4);
+   if (st->cpu_avg_us_Q4 == 0)
+      st->cpu_avg_us_Q4 = elapsed_Q4;
+   else
+      st->cpu_avg_us_Q4 += (elapsed_Q4 - st->cpu_avg_us_Q4)/8;
+   if (st->cpu_up_wait > 0)
+      st->cpu_up_wait--;
+   if (st->cpu_hold > 0)
+   {
+      st->cpu_hold--;
+      return;
+   }
+   budget_Q4 = SHL32(st->cpu_budget_us, 4);
+   complexity = st->silk_mode.complexity;
+   if (st->cpu_avg_us_Q4 > budget_Q4 && complexity > 0)
+   {
+      if (st->cpu_probe)
+         st->cpu_up_delay = IMIN(2*st->cpu_up_delay, CPU_UP_DELAY_MAX);
+      st->cpu_up_wait = st->cpu_up_delay;
+      set_complexity(st, complexity-1);
+   } else if (st->cpu_avg_us_Q4 < budget_Q4 - budget_Q4/4
+         && complexity < st->user_complexity && st->cpu_up_wait == 0)
+   {
+      set_complexity(st, complexity+1);
+   } else {
+      /* An increase that stayed within the budget resets the delay. */
+      if (st->cpu_probe)
+         st->cpu_up_delay = CPU_UP_DELAY_MIN;
+      st->cpu_probe = 0;
+      return;
+   }
+   st->cpu_probe = st->silk_mode.complexity > complexity;
+   st->cpu_hold = CPU_BUDGET_HOLD;
+   st->cpu_avg_us_Q4 = 0;
+}
+
+static void trace_frame(OpusEncoder *st, OpusEncoderFrameInfo *info,
+      int frame_size, opus_int32 bytes, opus_uint64 start)
+{
+   info->frame_size = frame_size;
+   info->stream_channels = st->stream_channels;
+   info->bitrate = st->bitrate_bps;
+   info->complexity = st->silk_mode.complexity;
+   info->bytes = bytes;
+   info->elapsed = opus_profile_ns() - start;
+   st->trace_callback(st->trace_user_data, info);
+}
+
+static opus_int32 opus_encode_frame_native(OpusEncoder *st, const opus_val16 *pcm, int frame_size,
                 unsigned char *data, opus_int32 out_data_bytes, int lsb_depth,
                 const void *analysis_pcm, opus_int32 analysis_size, int c1, int c2,
                 int analysis_channels, downmix_func downmix, int float_api)
@@ -1082,17 +1254,26 @@ opus_int32 opus_encode_native(OpusEncoder *st, const opus_val16 *pcm, int frame_
     opus_val16 stereo_width;
     const CELTMode *celt_mode;
 #ifndef DISABLE_FLOAT_API
+    TonalityAnalysisState *analysis;
     AnalysisInfo analysis_info;
     int analysis_read_pos_bak=-1;
     int analysis_read_subframe_bak=-1;
     int is_silence = 0;
 #endif
     opus_int activity = VAD_NO_DECISION;
+    OpusEncoderFrameInfo frame_info;
+    opus_uint64 trace_start=0;
 
     VARDECL(opus_val16, tmp_prefill);
 
     ALLOC_STACK;
 
+    if (st->trace_callback)
+       trace_start = opus_profile_ns();
+    OPUS_CLEAR(&frame_info, 1);
+    frame_info.music_prob = frame_info.tonality = -1;
+    frame_info.tf_select = frame_info.transient = frame_info.spread_decision = -1;
+
     max_data_bytes = IMIN(1276, out_data_bytes);
 
     st->rangeFinal = 0;
@@ -1120,27 +1301,59 @@ opus_int32 opus_encode_native(OpusEncoder *st, const opus_val16 *pcm, int frame_
 
     celt_encoder_ctl(celt_enc, CELT_GET_MODE(&celt_mode));
 #ifndef DISABLE_FLOAT_API
+    analysis = get_analysis(st);
     analysis_info.valid = 0;
 #ifdef FIXED_POINT
-    if (st->silk_mode.complexity >= 10 && st->Fs>=16000)
+    if (analysis != NULL && st->silk_mode.complexity >= 10 && st->Fs>=16000)
 #else
-    if (st->silk_mode.complexity >= 7 && st->Fs>=16000)
+    if (analysis != NULL && st->silk_mode.complexity >= 7 && st->Fs>=16000)
 #endif
     {
        is_silence = is_digital_silence(pcm, frame_size, st->channels, lsb_depth);
-       analysis_read_pos_bak = st->analysis.read_pos;
-       analysis_read_subframe_bak = st->analysis.read_subframe;
-       run_analysis(&st->analysis, celt_mode, analysis_pcm, analysis_size, frame_size,
-             c1, c2, analysis_channels, st->Fs,
-             lsb_depth, downmix, &analysis_info);
+       /* Sustained digital silence in DTX: the previous frame was already a
+          DTX frame, so unless the DTX logic asks for a keep-alive frame,
+          this one goes out as the same TOC-only frame. Skip the analysis,
+          filters, SILK and CELT. This is not bit-exact: the skipped frames
+          would still have advanced the CELT rng, the SILK VAD and DTX
+          counters and the analysis history, so the first frames coded after
+          the silence differ slightly. The ctls that can change the TOC
+          clear prev_dtx. */
+       if (is_silence && st->use_dtx && st->prev_dtx && analysis_pcm != NULL
+             && frame_size == st->prev_framesize)
+       {
+          int nb_no_activity_ms_Q1 = st->nb_no_activity_ms_Q1;
+          if (decide_dtx_mode(0, &nb_no_activity_ms_Q1, 2*1000*frame_size/st->Fs))
+          {
+             st->nb_no_activity_ms_Q1 = nb_no_activity_ms_Q1;
+             st->rangeFinal = 0;
+             data[0] = st->prev_dtx_toc;
+             if (st->trace_callback)
+             {
+                frame_info.mode = st->mode;
+                frame_info.bandwidth = st->bandwidth;
+                frame_info.in_dtx = 1;
+                trace_frame(st, &frame_info, frame_size, 1, trace_start);
+             }
+             RESTORE_STACK;
+             return 1;
+          }
+       }
+       analysis_read_pos_bak = analysis->read_pos;
+       analysis_read_subframe_bak = analysis->read_subframe;
+       st->dirty |= DIRTY_ANALYSIS;
+       OPUS_PROFILE(st->profile, OPUS_PROFILE_ENC_ANALYSIS,
+             run_analysis(analysis, celt_mode, analysis_pcm, analysis_size, frame_size,
+                c1, c2, analysis_channels, st->Fs,
+                lsb_depth, downmix, &analysis_info));
 
        /* Track the peak signal energy */
        if (!is_silence && analysis_info.activity_probability > DTX_ACTIVITY_THRESHOLD)
           st->peak_signal_energy = MAX32(MULT16_32_Q15(QCONST16(0.999f, 15), st->peak_signal_energy),
                 compute_frame_energy(pcm, frame_size, st->channels, st->arch));
-    } else if (st->analysis.initialized) {
-       tonality_analysis_reset(&st->analysis);
+    } else if (analysis != NULL && analysis->initialized) {
+       tonality_analysis_reset(analysis);
     }
+    st->prev_dtx = 0;
 #else
     (void)analysis_pcm;
     (void)analysis_size;
@@ -1174,6 +1387,8 @@ opus_int32 opus_encode_native(OpusEncoder *st, const opus_val16 *pcm, int frame_
     if (analysis_info.valid)
     {
        int analysis_bandwidth;
+       frame_info.music_prob = analysis_info.music_prob;
+       frame_info.tonality = analysis_info.tonality;
        if (st->signal_type == OPUS_AUTO)
        {
           float prob;
@@ -1285,6 +1500,12 @@ opus_int32 opus_encode_native(OpusEncoder *st, const opus_val16 *pcm, int frame_
           else
              ret = OPUS_INTERNAL_ERROR;
        }
+       if (st->trace_callback && ret > 0)
+       {
+          frame_info.mode = tocmode;
+          frame_info.bandwidth = bw;
+          trace_frame(st, &frame_info, frame_size, ret, trace_start);
+       }
        RESTORE_STACK;
        return ret;
     }
@@ -1587,8 +1808,8 @@ opus_int32 opus_encode_native(OpusEncoder *st, const opus_val16 *pcm, int frame_
 #ifndef DISABLE_FLOAT_API
        if (analysis_read_pos_bak!= -1)
        {
-          st->analysis.read_pos = analysis_read_pos_bak;
-          st->analysis.read_subframe = analysis_read_subframe_bak;
+          analysis->read_pos = analysis_read_pos_bak;
+          analysis->read_subframe = analysis_read_subframe_bak;
        }
 #endif
 
@@ -1644,9 +1865,11 @@ opus_int32 opus_encode_native(OpusEncoder *st, const opus_val16 *pcm, int frame_
 
     if (st->application == OPUS_APPLICATION_VOIP)
     {
-       hp_cutoff(pcm, cutoff_Hz, &pcm_buf[total_buffer*st->channels], st->hp_mem, frame_size, st->channels, st->Fs, st->arch);
+       OPUS_PROFILE(st->profile, OPUS_PROFILE_ENC_HP_FILTER,
+             hp_cutoff(pcm, cutoff_Hz, &pcm_buf[total_buffer*st->channels], st->hp_mem, frame_size, st->channels, st->Fs, st->arch));
     } else {
-       dc_reject(pcm, 3, &pcm_buf[total_buffer*st->channels], st->hp_mem, frame_size, st->channels, st->Fs);
+       OPUS_PROFILE(st->profile, OPUS_PROFILE_ENC_HP_FILTER,
+             dc_reject(pcm, 3, &pcm_buf[total_buffer*st->channels], st->hp_mem, frame_size, st->channels, st->Fs));
     }
 #ifndef FIXED_POINT
     if (float_api)
@@ -1820,9 +2043,9 @@ opus_int32 opus_encode_native(OpusEncoder *st, const opus_val16 *pcm, int frame_
 #ifdef FIXED_POINT
             pcm_silk = st->delay_buffer;
 #else
-            for (i=0;i<st->encoder_buffer*st->channels;i++)
-                pcm_silk[i] = FLOAT2INT16(st->delay_buffer[i]);
+            celt_float2int16(st->delay_buffer, pcm_silk, st->encoder_buffer*st->channels, st->arch);
 #endif
+            st->dirty |= DIRTY_SILK;
             silk_Encode( silk_enc, &st->silk_mode, pcm_silk, st->encoder_buffer, NULL, &zero, prefill, activity );
             /* Prevent a second switch in the real encode call. */
             st->silk_mode.opusCanSwitch = 0;
@@ -1831,9 +2054,10 @@ opus_int32 opus_encode_native(OpusEncoder *st, const opus_val16 *pcm, int frame_
 #ifdef FIXED_POINT
         pcm_silk = pcm_buf+total_buffer*st->channels;
 #else
-        for (i=0;i<frame_size*st->channels;i++)
-            pcm_silk[i] = FLOAT2INT16(pcm_buf[total_buffer*st->channels + i]);
+        celt_float2int16(pcm_buf+total_buffer*st->channels, pcm_silk, frame_size*st->channels, st->arch);
 #endif
+        frame_info.silk_bitrate = st->silk_mode.bitRate;
+        st->dirty |= DIRTY_SILK;
         ret = silk_Encode( silk_enc, &st->silk_mode, pcm_silk, frame_size, &enc, &nBytes, 0, activity );
         if( ret ) {
             /*fprintf (stderr, "SILK encode error: %d\n", ret);*/
@@ -1861,6 +2085,14 @@ opus_int32 opus_encode_native(OpusEncoder *st, const opus_val16 *pcm, int frame_
         {
            st->rangeFinal = 0;
            data[-1] = gen_toc(st->mode, st->Fs/frame_size, curr_bandwidth, st->stream_channels);
+           if (st->trace_callback)
+           {
+              frame_info.mode = st->mode;
+              frame_info.bandwidth = curr_bandwidth;
+              frame_info.equiv_rate = equiv_rate;
+              frame_info.in_dtx = 1;
+              trace_frame(st, &frame_info, frame_size, 1, trace_start);
+           }
            RESTORE_STACK;
            return 1;
         }
@@ -2073,6 +2305,14 @@ opus_int32 opus_encode_native(OpusEncoder *st, const opus_val16 *pcm, int frame_
               RESTORE_STACK;
               return OPUS_INTERNAL_ERROR;
            }
+           if (st->trace_callback)
+           {
+              CELTFrameInfo celt_info;
+              celt_encoder_ctl(celt_enc, CELT_GET_FRAME_INFO(&celt_info));
+              frame_info.tf_select = celt_info.tf_select;
+              frame_info.transient = celt_info.transient;
+              frame_info.spread_decision = celt_info.spread_decision;
+           }
            /* Put CELT->SILK redundancy data in the right place. */
            if (redundancy && celt_to_silk && st->mode==MODE_HYBRID && st->use_vbr)
            {
@@ -2140,6 +2380,17 @@ opus_int32 opus_encode_native(OpusEncoder *st, const opus_val16 *pcm, int frame_
        {
           st->rangeFinal = 0;
           data[0] = gen_toc(st->mode, st->Fs/frame_size, curr_bandwidth, st->stream_channels);
+          st->prev_dtx = 1;
+          st->prev_dtx_toc = data[0];
+          if (st->trace_callback)
+          {
+             frame_info.mode = st->mode;
+             frame_info.bandwidth = curr_bandwidth;
+             frame_info.equiv_rate = equiv_rate;
+             frame_info.redundancy_bytes = redundancy_bytes;
+             frame_info.in_dtx = 1;
+             trace_frame(st, &frame_info, frame_size, 1, trace_start);
+          }
           RESTORE_STACK;
           return 1;
        }
@@ -2181,17 +2432,45 @@ opus_int32 opus_encode_native(OpusEncoder *st, const opus_val16 *pcm, int frame_
        }
        ret = max_data_bytes;
     }
+    if (st->trace_callback)
+    {
+       frame_info.mode = st->mode;
+       frame_info.bandwidth = curr_bandwidth;
+       frame_info.equiv_rate = equiv_rate;
+       frame_info.redundancy_bytes = redundancy_bytes;
+       trace_frame(st, &frame_info, frame_size, ret, trace_start);
+    }
     RESTORE_STACK;
     return ret;
 }
 
+opus_int32 opus_encode_native(OpusEncoder *st, const opus_val16 *pcm, int frame_size,
+                unsigned char *data, opus_int32 out_data_bytes, int lsb_depth,
+                const void *analysis_pcm, opus_int32 analysis_size, int c1, int c2,
+                int analysis_channels, downmix_func downmix, int float_api)
+{
+   opus_int32 ret;
+   opus_uint64 start=0;
+   st->dirty |= DIRTY_ENCODER;
+   if (st->cpu_budget_us)
+      start = opus_profile_ns();
+   ret = opus_encode_frame_native(st, pcm, frame_size, data, out_data_bytes, lsb_depth,
+         analysis_pcm, analysis_size, c1, c2, analysis_channels, downmix, float_api);
+   if (st->cpu_budget_us && ret > 0)
+   {
+      opus_uint64 elapsed_us = (opus_profile_ns() - start)/1000;
+      update_cpu_budget(st, elapsed_us < 1000000 ? (opus_int32)elapsed_us : 1000000);
+   }
+   return ret;
+}
+
 #ifdef FIXED_POINT
 
 #ifndef DISABLE_FLOAT_API
 opus_int32 opus_encode_float(OpusEncoder *st, const float *pcm, int analysis_frame_size,
       unsigned char *data, opus_int32 max_data_bytes)
 {
-   int i, ret;
+   int ret;
    int frame_size;
    VARDECL(opus_int16, in);
    ALLOC_STACK;
@@ -2204,8 +2483,7 @@ opus_int32 opus_encode_float(OpusEncoder *st, const float *pcm, int analysis_fra
    }
    ALLOC(in, frame_size*st->channels, opus_int16);
 
-   for (i=0;i<frame_size*st->channels;i++)
-      in[i] = FLOAT2INT16(pcm[i]);
+   celt_float2int16(pcm, in, frame_size*st->channels, st->arch);
    ret = opus_encode_native(st, in, frame_size, data, max_data_bytes, 16,
                             pcm, analysis_frame_size, 0, -2, st->channels, downmix_float, 1);
    RESTORE_STACK;
@@ -2222,11 +2500,36 @@ opus_int32 opus_encode(OpusEncoder *st, const opus_int16 *pcm, int analysis_fram
                              pcm, analysis_frame_size, 0, -2, st->channels, downmix_int, 0);
 }
 
+opus_int32 opus_encode24(OpusEncoder *st, const opus_int32 *pcm, int analysis_frame_size,
+      unsigned char *data, opus_int32 max_data_bytes)
+{
+   int i, ret;
+   int frame_size;
+   VARDECL(opus_int16, in);
+   ALLOC_STACK;
+
+   frame_size = frame_size_select(analysis_frame_size, st->variable_duration, st->Fs);
+   if (frame_size <= 0)
+   {
+      RESTORE_STACK;
+      return OPUS_BAD_ARG;
+   }
+   ALLOC(in, frame_size*st->channels, opus_int16);
+
+   /* Round to 16 bits, the resolution of the fixed-point encoder */
+   for (i=0;i<frame_size*st->channels;i++)
+      in[i] = SAT16(SHR32(ADD32(MIN32(MAX32(pcm[i], -8388608), 8388607), 128), 8));
+   ret = opus_encode_native(st, in, frame_size, data, max_data_bytes, 16,
+                            pcm, analysis_frame_size, 0, -2, st->channels, downmix_int24, 0);
+   RESTORE_STACK;
+   return ret;
+}
+
 #else
 opus_int32 opus_encode(OpusEncoder *st, const opus_int16 *pcm, int analysis_frame_size,
       unsigned char *data, opus_int32 max_data_bytes)
 {
-   int i, ret;
+   int ret;
    int frame_size;
    VARDECL(float, in);
    ALLOC_STACK;
@@ -2239,8 +2542,7 @@ opus_int32 opus_encode(OpusEncoder *st, const opus_int16 *pcm, int analysis_fram
    }
    ALLOC(in, frame_size*st->channels, float);
 
-   for (i=0;i<frame_size*st->channels;i++)
-      in[i] = (1.0f/32768)*pcm[i];
+   celt_int16tofloat(pcm, in, frame_size*st->channels, st->arch);
    ret = opus_encode_native(st, in, frame_size, data, max_data_bytes, 16,
                             pcm, analysis_frame_size, 0, -2, st->channels, downmix_int, 0);
    RESTORE_STACK;
@@ -2254,6 +2556,30 @@ opus_int32 opus_encode_float(OpusEncoder *st, const float *pcm, int analysis_fra
    return opus_encode_native(st, pcm, frame_size, data, out_data_bytes, 24,
                              pcm, analysis_frame_size, 0, -2, st->channels, downmix_float, 1);
 }
+
+opus_int32 opus_encode24(OpusEncoder *st, const opus_int32 *pcm, int analysis_frame_size,
+      unsigned char *data, opus_int32 max_data_bytes)
+{
+   int i, ret;
+   int frame_size;
+   VARDECL(float, in);
+   ALLOC_STACK;
+
+   frame_size = frame_size_select(analysis_frame_size, st->variable_duration, st->Fs);
+   if (frame_size <= 0)
+   {
+      RESTORE_STACK;
+      return OPUS_BAD_ARG;
+   }
+   ALLOC(in, frame_size*st->channels, float);
+
+   for (i=0;i<frame_size*st->channels;i++)
+      in[i] = (1.0f/8388608)*pcm[i];
+   ret = opus_encode_native(st, in, frame_size, data, max_data_bytes, 24,
+                            pcm, analysis_frame_size, 0, -2, st->channels, downmix_int24, 0);
+   RESTORE_STACK;
+   return ret;
+}
 #endif
 
 
@@ -2282,7 +2608,8 @@ int opus_encoder_ctl(OpusEncoder *st, int request, ...)
             }
             st->application = value;
 #ifndef DISABLE_FLOAT_API
-            st->analysis.application = value;
+            if (st->analysis_offset)
+               get_analysis(st)->application = value;
 #endif
         }
         break;
@@ -2309,6 +2636,7 @@ int opus_encoder_ctl(OpusEncoder *st, int request, ...)
                     value = (opus_int32)300000*st->channels;
             }
             st->user_bitrate_bps = value;
+            st->prev_dtx = 0;
         }
         break;
         case OPUS_GET_BITRATE_REQUEST:
@@ -2329,6 +2657,7 @@ int opus_encoder_ctl(OpusEncoder *st, int request, ...)
                goto bad_arg;
             }
             st->force_channels = value;
+            st->prev_dtx = 0;
         }
         break;
         case OPUS_GET_FORCE_CHANNELS_REQUEST:
@@ -2349,6 +2678,7 @@ int opus_encoder_ctl(OpusEncoder *st, int request, ...)
                goto bad_arg;
             }
             st->max_bandwidth = value;
+            st->prev_dtx = 0;
             if (st->max_bandwidth == OPUS_BANDWIDTH_NARROWBAND) {
                 st->silk_mode.maxInternalSampleRate = 8000;
             } else if (st->max_bandwidth == OPUS_BANDWIDTH_MEDIUMBAND) {
@@ -2376,6 +2706,7 @@ int opus_encoder_ctl(OpusEncoder *st, int request, ...)
                goto bad_arg;
             }
             st->user_bandwidth = value;
+            st->prev_dtx = 0;
             if (st->user_bandwidth == OPUS_BANDWIDTH_NARROWBAND) {
                 st->silk_mode.maxInternalSampleRate = 8000;
             } else if (st->user_bandwidth == OPUS_BANDWIDTH_MEDIUMBAND) {
@@ -2422,6 +2753,7 @@ int opus_encoder_ctl(OpusEncoder *st, int request, ...)
             {
                goto bad_arg;
             }
+            st->user_complexity = value;
             st->silk_mode.complexity = value;
             celt_encoder_ctl(celt_enc, OPUS_SET_COMPLEXITY(value));
         }
@@ -2433,7 +2765,39 @@ int opus_encoder_ctl(OpusEncoder *st, int request, ...)
             {
                goto bad_arg;
             }
-            *value = st->silk_mode.complexity;
+            *value = st->user_complexity;
+        }
+        break;
+        case OPUS_SET_CPU_BUDGET_US_REQUEST:
+        {
+            opus_int32 value = va_arg(ap, opus_int32);
+            if (value<0 || value>1000000)
+            {
+               goto bad_arg;
+            }
+            /* Process CPU time would also count the other threads' work, so
+               without a wall clock there is nothing to adapt to. */
+            if (value && !opus_profile_has_clock())
+            {
+               ret = OPUS_UNIMPLEMENTED;
+               break;
+            }
+            st->cpu_budget_us = value;
+            st->cpu_avg_us_Q4 = 0;
+            st->cpu_hold = st->cpu_up_wait = st->cpu_probe = 0;
+            st->cpu_up_delay = CPU_UP_DELAY_MIN;
+            if (!value)
+               set_complexity(st, st->user_complexity);
+        }
+        break;
+        case OPUS_GET_CPU_BUDGET_US_REQUEST:
+        {
+            opus_int32 *value = va_arg(ap, opus_int32*);
+            if (!value)
+            {
+               goto bad_arg;
+            }
+            *value = st->cpu_budget_us;
         }
         break;
         case OPUS_SET_INBAND_FEC_REQUEST:
@@ -2506,6 +2870,7 @@ int opus_encoder_ctl(OpusEncoder *st, int request, ...)
                goto bad_arg;
             }
             st->voice_ratio = value;
+            st->prev_dtx = 0;
         }
         break;
         case OPUS_GET_VOICE_RATIO_REQUEST:
@@ -2546,6 +2911,7 @@ int opus_encoder_ctl(OpusEncoder *st, int request, ...)
                goto bad_arg;
             }
             st->signal_type = value;
+            st->prev_dtx = 0;
         }
         break;
         case OPUS_GET_SIGNAL_REQUEST:
@@ -2675,16 +3041,27 @@ int opus_encoder_ctl(OpusEncoder *st, int request, ...)
            void *silk_enc;
            silk_EncControlStruct dummy;
            char *start;
+           int dirty;
+           /* Nothing to do if no frame was encoded since the init or the
+              last reset, which is common for pooled encoders. */
+           dirty = st->dirty;
+           if (!dirty)
+              break;
            silk_enc = (char*)st+st->silk_enc_offset;
 #ifndef DISABLE_FLOAT_API
-           tonality_analysis_reset(&st->analysis);
+           if (dirty & DIRTY_ANALYSIS)
+              tonality_analysis_reset(get_analysis(st));
 #endif
 
            start = (char*)&st->OPUS_ENCODER_RESET_START;
            OPUS_CLEAR(start, sizeof(OpusEncoder) - (start - (char*)st));
 
            celt_encoder_ctl(celt_enc, OPUS_RESET_STATE);
-           silk_InitEncoder( silk_enc, st->arch, &dummy );
+           /* CELT-only streams never touch the SILK state */
+           if (dirty & DIRTY_SILK)
+              silk_InitEncoder( silk_enc, st->arch, &dummy );
+           set_complexity(st, st->user_complexity);
+           st->cpu_up_delay = CPU_UP_DELAY_MIN;
            st->stream_channels = st->channels;
            st->hybrid_stereo_width_Q14 = 1 << 14;
            st->prev_HB_gain = Q15ONE;
@@ -2702,6 +3079,7 @@ int opus_encoder_ctl(OpusEncoder *st, int request, ...)
                goto bad_arg;
             }
             st->user_forced_mode = value;
+            st->prev_dtx = 0;
         }
         break;
         case OPUS_SET_LFE_REQUEST:
@@ -2715,6 +3093,7 @@ int opus_encoder_ctl(OpusEncoder *st, int request, ...)
         {
             opus_val16 *value = va_arg(ap, opus_val16*);
             st->energy_masking = value;
+            st->dirty |= DIRTY_ENCODER;
             ret = celt_encoder_ctl(celt_enc, OPUS_SET_ENERGY_MASK(value));
         }
         break;
@@ -2755,6 +3134,22 @@ int opus_encoder_ctl(OpusEncoder *st, int request, ...)
            ret = celt_encoder_ctl(celt_enc, CELT_GET_MODE(value));
         }
         break;
+#ifdef ENABLE_PROFILING
+        case OPUS_GET_PROFILE_REQUEST:
+        {
+            opus_uint64 *value = va_arg(ap, opus_uint64*);
+            int i;
+            if (!value)
+            {
+               goto bad_arg;
+            }
+            ret = celt_encoder_ctl(celt_enc, OPUS_GET_PROFILE(value));
+            silk_Get_Encoder_Profile((char*)st+st->silk_enc_offset, value);
+            for (i=0;i<OPUS_PROFILE_STAGES;i++)
+               value[i] += st->profile[i];
+        }
+        break;
+#endif
         default:
             /* fprintf(stderr, "unknown opus_encoder_ctl() request: %d", request);*/
             ret = OPUS_UNIMPLEMENTED;
@@ -2767,6 +3162,13 @@ bad_arg:
     return OPUS_BAD_ARG;
 }
 
+int opus_encoder_set_trace(OpusEncoder *st, opus_encoder_trace_func callback, void *user_data)
+{
+   st->trace_callback = callback;
+   st->trace_user_data = user_data;
+   return OPUS_OK;
+}
+
 void opus_encoder_destroy(OpusEncoder *st)
 {
     opus_free(st);
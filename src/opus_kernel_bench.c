@@ -0,0 +1,979 @@
+/* Copyright (c) 2026 Opus contributors */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Run-time CPU detection kernel benchmark. Each CELT and SILK kernel that
+   has an optimized implementation is called through its RTCD dispatch
+   macro once for every arch level up to the one detected on this CPU, on
+   the same deterministic input. The output of every level is compared
+   against the C implementation (arch 0) and one CSV line is printed per
+   kernel and level. Integer kernels must match bit-exactly; float kernels
+   report their largest relative deviation. Plain C kernels, such as the
+   range coder, are timed once without arch levels.
+
+   When the build presumes an instruction set (OPUS_X86_PRESUME_SSE2 is the
+   default for x86_64 CMake builds), the dispatch macros call that version
+   directly and the C level is compiled with it too, so the levels below it
+   time the same code. Configure with the presume options off to compare
+   against plain C. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "opus.h"
+#include "opus_custom.h"
+#include "cpu_support.h"
+#include "arch.h"
+#include "os_support.h"
+#include "pitch.h"
+#include "celt_lpc.h"
+#include "celt.h"
+#include "vq.h"
+#include "cwrs.h"
+#include "kiss_fft.h"
+#include "mdct.h"
+#include "bands.h"
+#include "quant_bands.h"
+#include "mathops.h"
+#include "modes.h"
+#include "laplace.h"
+#include "main.h"
+#include "tables.h"
+#ifdef FIXED_POINT
+#include "main_FIX.h"
+#endif
+
+#define OUT_EXACT 0   /* integer result, must be bit-exact */
+#define OUT_FLOAT 1   /* float result, report relative deviation */
+#define OUT_LOOSE 2   /* integer result derived from float arithmetic */
+
+#ifdef FIXED_POINT
+#define CELT_OUT OUT_EXACT
+#define CELT_INT_OUT OUT_EXACT
+#else
+#define CELT_OUT OUT_FLOAT
+#define CELT_INT_OUT OUT_LOOSE
+#endif
+
+/* Largest relative deviation of a float kernel still considered sane. */
+#define FLOAT_TOLERANCE (1e-3)
+
+#define MAX_OUT_BYTES 16384
+
+typedef struct {
+    const char *name;
+    const char *size;
+    void (*run)(int arch);
+    const void *out;
+    int out_bytes;
+    int out_type;
+    int no_arch;  /* plain C, only timed once */
+} KernelDesc;
+
+static opus_uint32 rng_state = 0xdeadbeef;
+
+static int rng_range(int amp)
+{
+    rng_state = rng_state*1664525 + 1013904223;
+    return (int)((rng_state >> 8) % (2*amp + 1)) - amp;
+}
+
+/* CELT kernels */
+
+#define XCORR_LEN       240
+#define XCORR_MAX_PITCH 256
+#define FIR_N           480
+#define FIR_ORD         24
+#define COMB_T          300
+#define COMB_N          480
+#define PVQ_N           16
+#define PVQ_K           8
+
+static opus_val16 celt_x[XCORR_LEN + XCORR_MAX_PITCH];
+static opus_val16 celt_y[XCORR_LEN + XCORR_MAX_PITCH];
+static opus_val16 fir_num[FIR_ORD];
+static opus_val32 comb_x[COMB_T + 2 + COMB_N];
+static celt_norm pvq_x[PVQ_N];
+static const CELTMode *celt_mode;
+static kiss_fft_cpx fft_in[480];
+static kiss_fft_scalar mdct_in[1920];
+static kiss_fft_scalar mdct_coefs[960];
+
+static struct {
+    opus_val32 xcorr[XCORR_MAX_PITCH];
+    opus_val32 sum[4];
+    opus_val32 inner;
+    opus_val32 dual[2];
+    opus_val16 fir[FIR_N];
+    opus_val32 comb[COMB_N];
+    int iy[PVQ_N];
+    kiss_fft_cpx fft[480];
+    kiss_fft_scalar mdct[1920];
+} celt_out;
+
+static void init_celt(void)
+{
+    int i;
+    int err;
+    for (i=0;i<XCORR_LEN + XCORR_MAX_PITCH;i++)
+    {
+#ifdef FIXED_POINT
+        celt_x[i] = rng_range(1000);
+        celt_y[i] = rng_range(1000);
+#else
+        celt_x[i] = rng_range(1000)*(1.f/1000);
+        celt_y[i] = rng_range(1000)*(1.f/1000);
+#endif
+    }
+    for (i=0;i<FIR_ORD;i++)
+        fir_num[i] = MULT16_16_Q15(QCONST16(.04f,15), (opus_val16)rng_range(32767));
+    for (i=0;i<COMB_T + 2 + COMB_N;i++)
+    {
+#ifdef FIXED_POINT
+        comb_x[i] = rng_range(1000000);
+#else
+        comb_x[i] = (float)rng_range(30000);
+#endif
+    }
+    for (i=0;i<PVQ_N;i++)
+    {
+#ifdef FIXED_POINT
+        pvq_x[i] = rng_range(8000);
+#else
+        pvq_x[i] = rng_range(1000)*(1.f/1000);
+#endif
+    }
+    celt_mode = opus_custom_mode_create(48000, 960, &err);
+    for (i=0;i<480;i++)
+    {
+#ifdef FIXED_POINT
+        fft_in[i].r = rng_range(100000);
+        fft_in[i].i = rng_range(100000);
+#else
+        fft_in[i].r = (float)rng_range(30000);
+        fft_in[i].i = (float)rng_range(30000);
+#endif
+    }
+    for (i=0;i<1920;i++)
+    {
+#ifdef FIXED_POINT
+        mdct_in[i] = rng_range(1000000);
+#else
+        mdct_in[i] = (float)rng_range(30000);
+#endif
+    }
+    for (i=0;i<960;i++)
+    {
+#ifdef FIXED_POINT
+        mdct_coefs[i] = rng_range(1000000);
+#else
+        mdct_coefs[i] = (float)rng_range(30000);
+#endif
+    }
+}
+
+static void run_xcorr_kernel(int arch)
+{
+    int i;
+    for (i=0;i<4;i++)
+        celt_out.sum[i] = 0;
+    for (i=0;i<XCORR_MAX_PITCH;i+=4)
+        xcorr_kernel(celt_x, celt_y+i, celt_out.sum, XCORR_LEN, arch);
+}
+
+static void run_pitch_xcorr(int arch)
+{
+    (void)celt_pitch_xcorr(celt_x, celt_y, celt_out.xcorr, XCORR_LEN,
+          XCORR_MAX_PITCH, arch);
+}
+
+static void run_inner_prod(int arch)
+{
+    celt_out.inner = celt_inner_prod(celt_x, celt_y, XCORR_LEN, arch);
+}
+
+static void run_dual_inner_prod(int arch)
+{
+    dual_inner_prod(celt_x, celt_y, celt_y+XCORR_MAX_PITCH, XCORR_LEN,
+          &celt_out.dual[0], &celt_out.dual[1], arch);
+}
+
+static void run_fir(int arch)
+{
+    celt_fir(celt_x+FIR_ORD, fir_num, celt_out.fir, FIR_N, FIR_ORD, arch);
+}
+
+#ifdef OVERRIDE_COMB_FILTER_CONST
+static void run_comb_filter_const(int arch)
+{
+    comb_filter_const(celt_out.comb, comb_x+COMB_T+2, COMB_T, COMB_N,
+          QCONST16(.2f,15), QCONST16(.3f,15), QCONST16(.1f,15), arch);
+}
+#endif
+
+static void run_pvq_search(int arch)
+{
+    int i;
+    celt_norm X[PVQ_N];
+    /* op_pvq_search() works in place, so start from a fresh copy. */
+    for (i=0;i<PVQ_N;i++)
+        X[i] = pvq_x[i];
+    (void)op_pvq_search(X, celt_out.iy, PVQ_K, PVQ_N, arch);
+}
+
+static void run_fft(int arch)
+{
+    opus_fft(celt_mode->mdct.kfft[0], fft_in, celt_out.fft, arch);
+}
+
+static void run_mdct_forward(int arch)
+{
+    clt_mdct_forward(&celt_mode->mdct, mdct_in, celt_out.mdct, celt_mode->window,
+          celt_mode->overlap, 0, 1, arch);
+}
+
+static void run_mdct_backward(int arch)
+{
+    /* The TDAC mirroring reads back part of the output, so clear it to keep
+       the result independent of the previous call. */
+    OPUS_CLEAR(celt_out.mdct, 1920);
+    clt_mdct_backward(&celt_mode->mdct, mdct_coefs, celt_out.mdct,
+          celt_mode->window, celt_mode->overlap, 0, 1, arch);
+}
+
+/* Band energy, normalisation and denormalisation of one 20 ms stereo frame
+   at 48 kHz (21 bands, LM 3). The normalisation and the synthesis start
+   from energies computed once with the C code, so their output does not
+   depend on the energy kernel. */
+
+#define BANDS_N 960
+
+static celt_sig bands_freq[2*BANDS_N];
+static celt_ener bands_E[2*21];
+static opus_val16 bands_logE[2*21];
+static celt_norm bands_X[2*BANDS_N];
+
+static struct {
+    celt_ener bandE[2*21];
+} bands_E_out;
+
+static struct {
+    celt_norm X[2*BANDS_N];
+} bands_norm_out;
+
+static struct {
+    celt_sig freq[2*BANDS_N];
+} bands_denorm_out;
+
+static void init_bands(void)
+{
+    int i;
+    for (i=0;i<2*BANDS_N;i++)
+    {
+        /* Decaying towards the high bands, as in real spectra */
+#ifdef FIXED_POINT
+        bands_freq[i] = rng_range(4000000/(1+(i%BANDS_N)/16));
+#else
+        bands_freq[i] = (float)rng_range(30000/(1+(i%BANDS_N)/16));
+#endif
+    }
+    compute_band_energies(celt_mode, bands_freq, bands_E, 21, 2, 3, 0);
+    amp2Log2(celt_mode, 21, 21, bands_E, bands_logE, 2);
+    normalise_bands(celt_mode, bands_freq, bands_X, bands_E, 21, 2, 8, 0);
+}
+
+static void run_band_energies(int arch)
+{
+    compute_band_energies(celt_mode, bands_freq, bands_E_out.bandE, 21, 2, 3, arch);
+}
+
+static void run_normalise_bands(int arch)
+{
+    normalise_bands(celt_mode, bands_freq, bands_norm_out.X, bands_E, 21, 2, 8, arch);
+}
+
+static void run_denormalise_bands(int arch)
+{
+    int c;
+    for (c=0;c<2;c++)
+        denormalise_bands(celt_mode, bands_X+c*BANDS_N, bands_denorm_out.freq+c*BANDS_N,
+              bands_logE+c*21, 0, 21, 8, 1, 0, arch);
+}
+
+#ifndef DISABLE_FLOAT_API
+/* PCM conversions at the float/int16 API boundary: one 20 ms stereo frame */
+
+#define PCM_N 1920
+
+static float pcm_float[PCM_N];
+static opus_int16 pcm_int16[PCM_N];
+
+static struct {
+    opus_int16 i16[PCM_N];
+    float f[PCM_N];
+} pcm_out;
+
+static struct {
+    float x[PCM_N];
+    int within1;
+} limit2_out;
+
+static void init_pcm(void)
+{
+    int i;
+    for (i=0;i<PCM_N;i++)
+    {
+        /* Slightly over full scale, so that some samples saturate */
+        pcm_float[i] = rng_range(1100000)*(1.f/1000000);
+        pcm_int16[i] = (opus_int16)rng_range(32767);
+    }
+}
+
+static void run_float2int16(int arch)
+{
+    celt_float2int16(pcm_float, pcm_out.i16, PCM_N, arch);
+}
+
+static void run_int16tofloat(int arch)
+{
+    celt_int16tofloat(pcm_int16, pcm_out.f, PCM_N, arch);
+}
+
+/* The soft clipping check on a decoded frame that does not clip, which is
+   the common case. The time includes refreshing the in-place buffer. */
+static void run_limit2_checkwithin1(int arch)
+{
+    int i;
+    for (i=0;i<PCM_N;i++)
+        limit2_out.x[i] = (1.f/32768.f)*pcm_int16[i];
+    limit2_out.within1 = celt_limit2_checkwithin1(limit2_out.x, PCM_N, arch);
+}
+#endif
+
+/* PVQ codeword decoding: one decode_pulses() call for each of these bands.
+   The (N, K) pairs are the most frequent ones when decoding 256 kb/s stereo
+   music, so the time per call is close to the PVQ index decoding cost of a
+   20 ms frame at that rate. */
+
+#define PULSES_NB 24
+#define PULSES_MAX_N 22
+#define PULSES_BYTES 1024
+
+static const int pulses_nk[PULSES_NB][2] = {
+    {11, 7}, {8, 32}, {6, 10}, {8, 18}, {8, 16}, {6, 11}, {6, 9}, {8, 30},
+    {9, 10}, {8, 20}, {6, 13}, {11, 8}, {12, 16}, {11, 5}, {8, 22}, {11, 6},
+    {9, 11}, {6, 8}, {9, 8}, {8, 24}, {22, 9}, {4, 36}, {12, 4}, {4, 128}
+};
+
+static int pulses_y[PULSES_NB][PULSES_MAX_N];
+static unsigned char pulses_buf[PULSES_BYTES];
+
+static struct {
+    int y[PULSES_NB][PULSES_MAX_N];
+    opus_val32 yy[PULSES_NB];
+} pulses_out;
+
+static void init_pulses(void)
+{
+    int b;
+    int i;
+    ec_enc enc;
+    ec_enc_init(&enc, pulses_buf, PULSES_BYTES);
+    for (b=0;b<PULSES_NB;b++)
+    {
+        int n = pulses_nk[b][0];
+        for (i=0;i<pulses_nk[b][1];i++)
+            pulses_y[b][(rng_range(n) + n)%n] += 1;
+        for (i=0;i<n;i++)
+            if (rng_range(1) < 0)
+                pulses_y[b][i] = -pulses_y[b][i];
+        encode_pulses(pulses_y[b], n, pulses_nk[b][1], &enc);
+    }
+    ec_enc_done(&enc);
+}
+
+static void run_decode_pulses(int arch)
+{
+    int b;
+    ec_dec dec;
+    (void)arch;
+    ec_dec_init(&dec, pulses_buf, PULSES_BYTES);
+    for (b=0;b<PULSES_NB;b++)
+        pulses_out.yy[b] = decode_pulses(pulses_out.y[b], pulses_nk[b][0],
+              pulses_nk[b][1], &dec);
+}
+
+/* Range coder: 1000 symbols mixing the types CELT and SILK code (ICDF
+   tables, Laplace energies, bit_logp flags, uniform integers and raw bits),
+   so the time per call is close to the entropy coding cost of a high-rate
+   20 ms CELT frame. */
+
+#define EC_NSYMS 1000
+#define EC_BYTES 2000
+
+static int ec_syms[EC_NSYMS];
+static const unsigned char ec_icdf[8] = {250, 230, 190, 120, 60, 20, 5, 0};
+
+static struct {
+    unsigned char buf[EC_BYTES];
+    opus_uint32 rng;
+} ec_enc_out;
+
+static struct {
+    int sym[EC_NSYMS];
+    opus_uint32 rng;
+} ec_out;
+
+static void init_entropy(void)
+{
+    int i;
+    for (i=0;i<EC_NSYMS;i++)
+    {
+        switch (i%5)
+        {
+        case 0:
+            ec_syms[i] = rng_range(3) + 3;
+            break;
+        case 1:
+            ec_syms[i] = rng_range(4);
+            break;
+        case 2:
+            ec_syms[i] = rng_range(1) != 0;
+            break;
+        case 3:
+            ec_syms[i] = (rng_range(5000) + 5000) % (2 + i%997);
+            break;
+        default:
+            ec_syms[i] = rng_range(7) + 7;
+            break;
+        }
+    }
+}
+
+static void run_entropy_encode(int arch)
+{
+    int i;
+    ec_enc enc;
+    (void)arch;
+    ec_enc_init(&enc, ec_enc_out.buf, EC_BYTES);
+    for (i=0;i<EC_NSYMS;i++)
+    {
+        int v = ec_syms[i];
+        switch (i%5)
+        {
+        case 0:
+            ec_enc_icdf(&enc, v, ec_icdf, 8);
+            break;
+        case 1:
+            ec_laplace_encode(&enc, &v, 72<<7, 127<<6);
+            break;
+        case 2:
+            ec_enc_bit_logp(&enc, v, 1 + i%4);
+            break;
+        case 3:
+            ec_enc_uint(&enc, v, 2 + i%997);
+            break;
+        default:
+            ec_enc_bits(&enc, v, 4);
+            break;
+        }
+    }
+    ec_enc_done(&enc);
+    ec_enc_out.rng = enc.rng;
+}
+
+static void run_entropy_decode(int arch)
+{
+    int i;
+    ec_dec dec;
+    (void)arch;
+    ec_dec_init(&dec, ec_enc_out.buf, EC_BYTES);
+    for (i=0;i<EC_NSYMS;i++)
+    {
+        switch (i%5)
+        {
+        case 0:
+            ec_out.sym[i] = ec_dec_icdf(&dec, ec_icdf, 8);
+            break;
+        case 1:
+            ec_out.sym[i] = ec_laplace_decode(&dec, 72<<7, 127<<6);
+            break;
+        case 2:
+            ec_out.sym[i] = ec_dec_bit_logp(&dec, 1 + i%4);
+            break;
+        case 3:
+            ec_out.sym[i] = ec_dec_uint(&dec, 2 + i%997);
+            break;
+        default:
+            ec_out.sym[i] = ec_dec_bits(&dec, 4);
+            break;
+        }
+    }
+    ec_out.rng = dec.rng;
+}
+
+/* The range coder and the PVQ codeword decoder have no arch variants, so
+   check that they return what was encoded instead. This also leaves the
+   encoded stream in ec_enc_out for the ec_decode kernel. */
+static int check_entropy(void)
+{
+    int failures = 0;
+    run_entropy_encode(0);
+    run_entropy_decode(0);
+    if (memcmp(ec_out.sym, ec_syms, sizeof(ec_syms)) != 0)
+    {
+        fprintf(stderr, "ec_decode did not return the encoded symbols\n");
+        failures++;
+    }
+    run_decode_pulses(0);
+    if (memcmp(pulses_out.y, pulses_y, sizeof(pulses_y)) != 0)
+    {
+        fprintf(stderr, "decode_pulses did not return the encoded vectors\n");
+        failures++;
+    }
+    return failures;
+}
+
+/* SILK kernels */
+
+#define SILK_FS_KHZ      16
+#define SILK_FRAME       (SILK_FS_KHZ*20)
+#define SILK_SUBFR       (SILK_FRAME/MAX_NB_SUBFR)
+#define BURG_ORDER       16
+#define BURG_SUBFR       (SILK_SUBFR + BURG_ORDER)
+#define WARPED_LEN       384
+#define WARPED_ORDER     24
+#define LTP_CBK          2
+
+static opus_int16 silk_in[2*SILK_FRAME + MAX_NB_SUBFR*BURG_SUBFR];
+static silk_encoder_state enc_state;
+static silk_nsq_state nsq_init;
+static SideInfoIndices indices_init;
+static opus_int16 pred_coef_Q12[2*MAX_LPC_ORDER];
+static opus_int16 ltp_coef_Q14[LTP_ORDER*MAX_NB_SUBFR];
+static opus_int16 ar_Q13[MAX_NB_SUBFR*MAX_SHAPE_LPC_ORDER];
+static opus_int harm_shape_gain_Q14[MAX_NB_SUBFR];
+static opus_int tilt_Q14[MAX_NB_SUBFR];
+static opus_int32 lf_shp_Q14[MAX_NB_SUBFR];
+static opus_int32 gains_Q16[MAX_NB_SUBFR];
+static opus_int pitch_lags[MAX_NB_SUBFR];
+static opus_int32 ltp_XX_Q17[LTP_ORDER*LTP_ORDER];
+static opus_int32 ltp_xX_Q17[LTP_ORDER];
+static const opus_int32 biquad_B_Q28[3] = {263066563, -526133126, 263066563};
+static const opus_int32 biquad_A_Q28[2] = {-526120483, 257726013};
+static opus_int16 lpc_A_Q12[MAX_LPC_ORDER];
+
+static struct {
+    silk_VAD_state vad;
+    opus_int vad_ret;
+    opus_int speech_activity_Q8;
+    opus_int input_tilt_Q15;
+    opus_int input_quality_bands_Q15[VAD_N_BANDS];
+} vad_out;
+
+static struct {
+    silk_nsq_state nsq;
+    SideInfoIndices indices;
+    opus_int8 pulses[SILK_FRAME];
+} nsq_out;
+
+static struct {
+    opus_int8 ind;
+    opus_int32 res_nrg_Q15;
+    opus_int32 rate_dist_Q8;
+    opus_int gain_Q7;
+} vq_out;
+
+static struct {
+    opus_int32 S[4];
+    opus_int16 out[2*SILK_FRAME];
+} biquad_out;
+
+static opus_int32 inv_gain_out;
+
+#ifdef FIXED_POINT
+static opus_int64 inner_prod16_out;
+
+static struct {
+    opus_int32 res_nrg;
+    opus_int res_nrg_Q;
+    opus_int32 A_Q16[BURG_ORDER];
+} burg_out;
+
+static struct {
+    opus_int32 corr[WARPED_ORDER + 1];
+    opus_int scale;
+} warped_out;
+#endif
+
+static void init_silk(void)
+{
+    int i, k;
+    for (i=0;i<(int)(sizeof(silk_in)/sizeof(silk_in[0]));i++)
+    {
+        /* A 200 Hz buzz plus noise, so the VAD and NSQ see something
+           speech-like rather than white noise. */
+        silk_in[i] = (opus_int16)((i%80 < 40 ? 3000 : -3000) + rng_range(2000));
+    }
+
+    silk_memset(&enc_state, 0, sizeof(enc_state));
+    enc_state.fs_kHz = SILK_FS_KHZ;
+    enc_state.nb_subfr = MAX_NB_SUBFR;
+    enc_state.subfr_length = SILK_SUBFR;
+    enc_state.frame_length = SILK_FRAME;
+    enc_state.ltp_mem_length = LTP_MEM_LENGTH_MS*SILK_FS_KHZ;
+    enc_state.predictLPCOrder = MAX_LPC_ORDER;
+    enc_state.shapingLPCOrder = MAX_SHAPE_LPC_ORDER;
+    enc_state.warping_Q16 = SILK_FIX_CONST(0.015f*SILK_FS_KHZ, 16);
+    enc_state.nStatesDelayedDecision = MAX_DEL_DEC_STATES;
+    silk_VAD_Init(&enc_state.sVAD);
+
+    silk_memset(&nsq_init, 0, sizeof(nsq_init));
+    nsq_init.lagPrev = 100;
+    nsq_init.prev_gain_Q16 = 65536;
+    silk_memset(&indices_init, 0, sizeof(indices_init));
+    indices_init.signalType = TYPE_VOICED;
+    indices_init.NLSFInterpCoef_Q2 = 4;
+
+    /* Stable by construction: the sum of the absolute coefficients stays
+       below one. */
+    for (i=0;i<MAX_LPC_ORDER;i++)
+    {
+        lpc_A_Q12[i] = (opus_int16)((i&1 ? -1 : 1)*(3686 >> (i+1)));
+        pred_coef_Q12[i] = pred_coef_Q12[MAX_LPC_ORDER + i] = lpc_A_Q12[i];
+    }
+    for (k=0;k<MAX_NB_SUBFR;k++)
+    {
+        ltp_coef_Q14[k*LTP_ORDER + 0] = 0;
+        ltp_coef_Q14[k*LTP_ORDER + 1] = 2000;
+        ltp_coef_Q14[k*LTP_ORDER + 2] = 8000;
+        ltp_coef_Q14[k*LTP_ORDER + 3] = 2000;
+        ltp_coef_Q14[k*LTP_ORDER + 4] = 0;
+        for (i=0;i<MAX_SHAPE_LPC_ORDER;i++)
+            ar_Q13[k*MAX_SHAPE_LPC_ORDER + i] = (opus_int16)rng_range(400);
+        harm_shape_gain_Q14[k] = 4000;
+        tilt_Q14[k] = -2000;
+        lf_shp_Q14[k] = silk_LSHIFT32(14000, 16) | (opus_uint16)-3000;
+        gains_Q16[k] = silk_LSHIFT32(100, 16);
+        pitch_lags[k] = 80;
+    }
+
+    for (i=0;i<LTP_ORDER;i++)
+    {
+        for (k=0;k<LTP_ORDER;k++)
+            ltp_XX_Q17[i*LTP_ORDER + k] = (i == k ? 2 : 1)*(1 << 17) >> (i > k ? i - k : k - i);
+        ltp_xX_Q17[i] = (i == 2 ? 3 : 1)*(1 << 16);
+    }
+}
+
+static void run_vad(int arch)
+{
+    silk_VAD_Init(&enc_state.sVAD);
+    vad_out.vad_ret = silk_VAD_GetSA_Q8(&enc_state, silk_in, arch);
+    vad_out.vad = enc_state.sVAD;
+    vad_out.speech_activity_Q8 = enc_state.speech_activity_Q8;
+    vad_out.input_tilt_Q15 = enc_state.input_tilt_Q15;
+    silk_memcpy(vad_out.input_quality_bands_Q15,
+          enc_state.input_quality_bands_Q15, sizeof(vad_out.input_quality_bands_Q15));
+}
+
+static void run_nsq(int arch)
+{
+    nsq_out.nsq = nsq_init;
+    nsq_out.indices = indices_init;
+    enc_state.arch = arch;
+    silk_NSQ(&enc_state, &nsq_out.nsq, &nsq_out.indices, silk_in, nsq_out.pulses,
+          pred_coef_Q12, ltp_coef_Q14, ar_Q13, harm_shape_gain_Q14, tilt_Q14,
+          lf_shp_Q14, gains_Q16, pitch_lags, 1229, 15565, arch);
+}
+
+static void run_nsq_del_dec(int arch)
+{
+    nsq_out.nsq = nsq_init;
+    nsq_out.indices = indices_init;
+    enc_state.arch = arch;
+    silk_NSQ_del_dec(&enc_state, &nsq_out.nsq, &nsq_out.indices, silk_in,
+          nsq_out.pulses, pred_coef_Q12, ltp_coef_Q14, ar_Q13, harm_shape_gain_Q14,
+          tilt_Q14, lf_shp_Q14, gains_Q16, pitch_lags, 1229, 15565, arch);
+}
+
+static void run_vq_wmat_ec(int arch)
+{
+    silk_VQ_WMat_EC(&vq_out.ind, &vq_out.res_nrg_Q15, &vq_out.rate_dist_Q8,
+          &vq_out.gain_Q7, ltp_XX_Q17, ltp_xX_Q17, silk_LTP_vq_ptrs_Q7[LTP_CBK],
+          silk_LTP_vq_gain_ptrs_Q7[LTP_CBK], silk_LTP_gain_BITS_Q5_ptrs[LTP_CBK],
+          SILK_SUBFR, 200, silk_LTP_vq_sizes[LTP_CBK], arch);
+}
+
+static void run_biquad_alt_stride2(int arch)
+{
+    silk_memset(biquad_out.S, 0, sizeof(biquad_out.S));
+    silk_biquad_alt_stride2(silk_in, biquad_B_Q28, biquad_A_Q28, biquad_out.S,
+          biquad_out.out, SILK_FRAME, arch);
+}
+
+static void run_lpc_inverse_pred_gain(int arch)
+{
+    inv_gain_out = silk_LPC_inverse_pred_gain(lpc_A_Q12, MAX_LPC_ORDER, arch);
+}
+
+#ifdef FIXED_POINT
+static void run_inner_prod16(int arch)
+{
+    inner_prod16_out = silk_inner_prod16(silk_in, silk_in + SILK_FRAME, SILK_FRAME, arch);
+}
+
+static void run_burg_modified(int arch)
+{
+    silk_burg_modified(&burg_out.res_nrg, &burg_out.res_nrg_Q, burg_out.A_Q16,
+          silk_in, SILK_FIX_CONST(1.0f/MAX_PREDICTION_POWER_GAIN, 30), BURG_SUBFR,
+          MAX_NB_SUBFR, BURG_ORDER, arch);
+}
+
+static void run_warped_autocorrelation(int arch)
+{
+    silk_warped_autocorrelation_FIX(warped_out.corr, &warped_out.scale, silk_in,
+          enc_state.warping_Q16, WARPED_LEN, WARPED_ORDER, arch);
+}
+#endif
+
+#define KERNEL(name, size, run, out, type) {name, size, run, &(out), sizeof(out), type, 0}
+#define C_KERNEL(name, size, run, out) {name, size, run, &(out), sizeof(out), OUT_EXACT, 1}
+
+static const KernelDesc kernels[] = {
+    KERNEL("xcorr_kernel", "240x256", run_xcorr_kernel, celt_out.sum, CELT_OUT),
+    KERNEL("celt_pitch_xcorr", "240x256", run_pitch_xcorr, celt_out.xcorr, CELT_OUT),
+    KERNEL("celt_inner_prod", "240", run_inner_prod, celt_out.inner, CELT_OUT),
+    KERNEL("dual_inner_prod", "240", run_dual_inner_prod, celt_out.dual, CELT_OUT),
+    KERNEL("celt_fir", "480x24", run_fir, celt_out.fir, CELT_OUT),
+#ifdef OVERRIDE_COMB_FILTER_CONST
+    KERNEL("comb_filter_const", "480", run_comb_filter_const, celt_out.comb, CELT_OUT),
+#endif
+    KERNEL("op_pvq_search", "16/8", run_pvq_search, celt_out.iy, CELT_INT_OUT),
+    KERNEL("opus_fft", "480", run_fft, celt_out.fft, CELT_OUT),
+    KERNEL("clt_mdct_forward", "1920", run_mdct_forward, celt_out.mdct, CELT_OUT),
+    KERNEL("clt_mdct_backward", "1920", run_mdct_backward, celt_out.mdct, CELT_OUT),
+    KERNEL("compute_band_energies", "2x21", run_band_energies, bands_E_out, CELT_OUT),
+    KERNEL("normalise_bands", "2x21", run_normalise_bands, bands_norm_out, OUT_EXACT),
+    KERNEL("denormalise_bands", "2x21", run_denormalise_bands, bands_denorm_out, OUT_EXACT),
+#ifndef DISABLE_FLOAT_API
+    KERNEL("celt_float2int16", "1920", run_float2int16, pcm_out.i16, OUT_EXACT),
+    KERNEL("celt_int16tofloat", "1920", run_int16tofloat, pcm_out.f, OUT_EXACT),
+    KERNEL("celt_limit2_checkwithin1", "1920", run_limit2_checkwithin1, limit2_out, OUT_EXACT),
+#endif
+    C_KERNEL("ec_encode", "1000", run_entropy_encode, ec_enc_out),
+    C_KERNEL("ec_decode", "1000", run_entropy_decode, ec_out),
+    C_KERNEL("decode_pulses", "24 bands", run_decode_pulses, pulses_out),
+    KERNEL("silk_VAD_GetSA_Q8", "320", run_vad, vad_out, OUT_EXACT),
+    KERNEL("silk_NSQ", "320", run_nsq, nsq_out, OUT_EXACT),
+    KERNEL("silk_NSQ_del_dec", "320", run_nsq_del_dec, nsq_out, OUT_EXACT),
+    KERNEL("silk_VQ_WMat_EC", "32", run_vq_wmat_ec, vq_out, OUT_EXACT),
+    KERNEL("silk_biquad_alt_stride2", "320", run_biquad_alt_stride2, biquad_out, OUT_EXACT),
+    KERNEL("silk_LPC_inverse_pred_gain", "16", run_lpc_inverse_pred_gain, inv_gain_out, OUT_EXACT),
+#ifdef FIXED_POINT
+    KERNEL("silk_inner_prod16", "320", run_inner_prod16, inner_prod16_out, OUT_EXACT),
+    KERNEL("silk_burg_modified", "4x96", run_burg_modified, burg_out, OUT_EXACT),
+    KERNEL("silk_warped_autocorrelation", "384x24", run_warped_autocorrelation, warped_out, OUT_EXACT),
+#endif
+};
+
+#define NB_KERNELS ((int)(sizeof(kernels)/sizeof(kernels[0])))
+
+static const char *arch_name(int arch)
+{
+#if defined(OPUS_HAVE_RTCD) && (OPUS_ARCHMASK == 7)
+    static const char *names[5] = {"c", "sse", "sse2", "sse4.1", "avx"};
+    if (arch >= 0 && arch < 5) return names[arch];
+#elif defined(OPUS_HAVE_RTCD) && (OPUS_ARCHMASK == 3)
+    static const char *names[4] = {"c", "edsp", "media", "neon"};
+    if (arch >= 0 && arch < 4) return names[arch];
+#else
+    (void)arch;
+    return "default";
+#endif
+    return "unknown";
+}
+
+static double time_kernel(const KernelDesc *k, int arch, double min_seconds)
+{
+    long iters;
+    long i;
+    clock_t start;
+    double elapsed;
+    for (iters=16;;iters*=2)
+    {
+        start = clock();
+        for (i=0;i<iters;i++)
+            k->run(arch);
+        elapsed = (double)(clock() - start)/CLOCKS_PER_SEC;
+        if (elapsed >= min_seconds || iters >= (1L<<30))
+            break;
+    }
+    return 1e9*elapsed/iters;
+}
+
+#ifndef FIXED_POINT
+static double float_deviation(const float *ref, const float *out, int n)
+{
+    int i;
+    double max_ref = 0;
+    double max_diff = 0;
+    for (i=0;i<n;i++)
+    {
+        double r = ref[i] < 0 ? -ref[i] : ref[i];
+        double d = ref[i] - out[i];
+        if (d < 0) d = -d;
+        if (r > max_ref) max_ref = r;
+        if (d > max_diff) max_diff = d;
+    }
+    return max_ref > 0 ? max_diff/max_ref : max_diff;
+}
+#endif
+
+static void print_usage(char *argv[])
+{
+    fprintf(stderr, "Usage: %s [-kernel <name>] [-arch <max arch>] "
+                    "[-ms <time per measurement>] [-noheader]\n", argv[0]);
+    fprintf(stderr, "Runs every RTCD kernel at every arch level up to the one "
+                    "detected on this CPU\nand compares each against the C "
+                    "implementation (arch 0).\n");
+}
+
+int main(int argc, char *argv[])
+{
+    int args;
+    int i;
+    int arch;
+    int max_arch;
+    int min_arch;
+    const char *kernel_filter = NULL;
+    double min_seconds = .02;
+    int header = 1;
+    int failures = 0;
+    static unsigned char ref[MAX_OUT_BYTES];
+
+    max_arch = opus_select_arch();
+    for (args=1;args<argc;args++)
+    {
+        if (strcmp(argv[args], "-kernel") == 0 && args + 1 < argc)
+            kernel_filter = argv[++args];
+        else if (strcmp(argv[args], "-arch") == 0 && args + 1 < argc)
+        {
+            int a = atoi(argv[++args]);
+            if (a < max_arch) max_arch = a;
+        }
+        else if (strcmp(argv[args], "-ms") == 0 && args + 1 < argc)
+            min_seconds = atof(argv[++args])*1e-3;
+        else if (strcmp(argv[args], "-noheader") == 0)
+            header = 0;
+        else {
+            print_usage(argv);
+            return EXIT_FAILURE;
+        }
+    }
+#ifdef OPUS_HAVE_RTCD
+    min_arch = 0;
+#else
+    /* Without RTCD only the implementation selected at build time can be
+       reached, so there is nothing to compare against. */
+    min_arch = max_arch;
+#endif
+
+    fprintf(stderr, "%s, detected arch %d (%s)%s\n", opus_get_version_string(),
+          max_arch, arch_name(max_arch),
+#if defined(OPUS_CHECK_ASM) && defined(ENABLE_ASSERTIONS)
+          ", OPUS_CHECK_ASM asserts active"
+#else
+          ""
+#endif
+          );
+
+    init_celt();
+    init_bands();
+#ifndef DISABLE_FLOAT_API
+    init_pcm();
+#endif
+    init_silk();
+    init_entropy();
+    init_pulses();
+    failures += check_entropy();
+    for (i=0;i<NB_KERNELS;i++)
+        celt_assert(kernels[i].out_bytes <= MAX_OUT_BYTES);
+
+    if (header)
+        printf("kernel,size,arch,ns_per_call,speedup,check\n");
+    for (i=0;i<NB_KERNELS;i++)
+    {
+        const KernelDesc *k = &kernels[i];
+        double ref_ns = 0;
+        if (kernel_filter && strcmp(kernel_filter, k->name) != 0)
+            continue;
+        for (arch=min_arch;arch<=(k->no_arch ? min_arch : max_arch);arch++)
+        {
+            double ns;
+            char check[64];
+            k->run(arch);
+            if (arch == min_arch)
+            {
+                memcpy(ref, k->out, k->out_bytes);
+                strcpy(check, min_arch == 0 ? "ref" : "n/a");
+            } else if (memcmp(ref, k->out, k->out_bytes) == 0) {
+                strcpy(check, "exact");
+            } else if (k->out_type == OUT_EXACT) {
+                strcpy(check, "MISMATCH");
+                failures++;
+            } else if (k->out_type == OUT_LOOSE) {
+                strcpy(check, "differs");
+            } else {
+#ifndef FIXED_POINT
+                double dev = float_deviation((const float*)(void*)ref,
+                      (const float*)k->out, k->out_bytes/sizeof(float));
+                if (dev > FLOAT_TOLERANCE)
+                {
+                    sprintf(check, "MISMATCH(%.3g)", dev);
+                    failures++;
+                } else {
+                    sprintf(check, "%.3g", dev);
+                }
+#endif
+            }
+            ns = time_kernel(k, arch, min_seconds);
+            if (arch == min_arch)
+                ref_ns = ns;
+            printf("%s,%s,%s,%.1f,%.2f,%s\n", k->name, k->size, arch_name(arch),
+                  ns, ref_ns/ns, check);
+            fflush(stdout);
+        }
+    }
+    if (failures)
+        fprintf(stderr, "%d kernel/arch combination(s) did not match the C "
+                        "implementation\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
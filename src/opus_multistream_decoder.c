@@ -146,31 +146,30 @@ OpusMSDecoder *opus_multistream_decoder_create(
    return st;
 }
 
+/* Validates all the streams and keeps an iterator over each of them, so that
+   they don't need to be parsed again for decoding. */
 static int opus_multistream_packet_validate(const unsigned char *data,
-      opus_int32 len, int nb_streams, opus_int32 Fs)
+      opus_int32 len, int nb_streams, opus_int32 Fs, OpusPacketIter *streams)
 {
    int s;
    int count;
-   unsigned char toc;
-   opus_int16 size[48];
    int samples=0;
-   opus_int32 packet_offset;
 
    for (s=0;s<nb_streams;s++)
    {
       int tmp_samples;
-      if (len<=0)
-         return OPUS_INVALID_PACKET;
-      count = opus_packet_parse_impl(data, len, s!=nb_streams-1, &toc, NULL,
-                                     size, NULL, &packet_offset);
+      if (s==0)
+         count = opus_packet_iter_init(&streams[0], data, len, nb_streams>1);
+      else {
+         streams[s] = streams[s-1];
+         count = opus_packet_iter_next_stream(&streams[s], s!=nb_streams-1);
+      }
       if (count<0)
          return count;
-      tmp_samples = opus_packet_get_nb_samples(data, packet_offset, Fs);
+      tmp_samples = count*opus_packet_get_samples_per_frame(streams[s].data, Fs);
       if (s!=0 && samples != tmp_samples)
          return OPUS_INVALID_PACKET;
       samples = tmp_samples;
-      data += packet_offset;
-      len -= packet_offset;
    }
    return samples;
 }
@@ -193,7 +192,9 @@ int opus_multistream_decode_native(
    int s, c;
    char *ptr;
    int do_plc=0;
+   OpusPacketIter *streams=NULL;
    VARDECL(opus_val16, buf);
+   VARDECL(void *, streams_mem);
    ALLOC_STACK;
 
    VALIDATE_MS_DECODER(st);
@@ -222,9 +223,16 @@ int opus_multistream_decode_native(
       RESTORE_STACK;
       return OPUS_INVALID_PACKET;
    }
+   /* ALIGN() in the pseudostack assumes a power-of-two element size, so the
+      iterators are laid out in pointer-sized units, which are aligned for
+      every member of OpusPacketIter. */
+   ALLOC(streams_mem, do_plc ? ALLOC_NONE :
+         (st->layout.nb_streams*sizeof(OpusPacketIter)+sizeof(void*)-1)/sizeof(void*), void *);
    if (!do_plc)
    {
-      int ret = opus_multistream_packet_validate(data, len, st->layout.nb_streams, Fs);
+      int ret;
+      streams = (OpusPacketIter*)(void*)streams_mem;
+      ret = opus_multistream_packet_validate(data, len, st->layout.nb_streams, Fs, streams);
       if (ret < 0)
       {
          RESTORE_STACK;
@@ -238,24 +246,15 @@ int opus_multistream_decode_native(
    for (s=0;s<st->layout.nb_streams;s++)
    {
       OpusDecoder *dec;
-      opus_int32 packet_offset;
       int ret;
 
       dec = (OpusDecoder*)ptr;
       ptr += (s < st->layout.nb_coupled_streams) ? align(coupled_size) : align(mono_size);
 
-      if (!do_plc && len<=0)
-      {
-         RESTORE_STACK;
-         return OPUS_INTERNAL_ERROR;
-      }
-      packet_offset = 0;
-      ret = opus_decode_native(dec, data, len, buf, frame_size, decode_fec, s!=st->layout.nb_streams-1, &packet_offset, soft_clip);
-      if (!do_plc)
-      {
-        data += packet_offset;
-        len -= packet_offset;
-      }
+      if (do_plc)
+         ret = opus_decode_native(dec, NULL, 0, buf, frame_size, decode_fec, 0, NULL, soft_clip);
+      else
+         ret = opus_decode_iter_native(dec, &streams[s], buf, frame_size, decode_fec, soft_clip);
       if (ret <= 0)
       {
          RESTORE_STACK;
@@ -433,6 +432,8 @@ int opus_multistream_decoder_ctl_va_list(OpusMSDecoder *st, int request,
        case OPUS_GET_GAIN_REQUEST:
        case OPUS_GET_LAST_PACKET_DURATION_REQUEST:
        case OPUS_GET_PHASE_INVERSION_DISABLED_REQUEST:
+       case OPUS_GET_BANDLIMITED_DECODE_REQUEST:
+       case OPUS_GET_PLC_COMPLEXITY_REQUEST:
        {
           OpusDecoder *dec;
           /* For int32* GET params, just query the first stream */
@@ -465,6 +466,31 @@ int opus_multistream_decoder_ctl_va_list(OpusMSDecoder *st, int request,
           }
        }
        break;
+       case OPUS_GET_PROFILE_REQUEST:
+       {
+          int s, i;
+          opus_uint64 *value = va_arg(ap, opus_uint64*);
+          opus_uint64 tmp[OPUS_PROFILE_STAGES];
+          if (!value)
+          {
+             goto bad_arg;
+          }
+          OPUS_CLEAR(value, OPUS_PROFILE_STAGES);
+          for (s=0;s<st->layout.nb_streams;s++)
+          {
+             OpusDecoder *dec;
+             dec = (OpusDecoder*)ptr;
+             if (s < st->layout.nb_coupled_streams)
+                ptr += align(coupled_size);
+             else
+                ptr += align(mono_size);
+             ret = opus_decoder_ctl(dec, request, tmp);
+             if (ret != OPUS_OK) break;
+             for (i=0;i<OPUS_PROFILE_STAGES;i++)
+                value[i] += tmp[i];
+          }
+       }
+       break;
        case OPUS_RESET_STATE:
        {
           int s;
@@ -508,6 +534,8 @@ int opus_multistream_decoder_ctl_va_list(OpusMSDecoder *st, int request,
        break;
        case OPUS_SET_GAIN_REQUEST:
        case OPUS_SET_PHASE_INVERSION_DISABLED_REQUEST:
+       case OPUS_SET_BANDLIMITED_DECODE_REQUEST:
+       case OPUS_SET_PLC_COMPLEXITY_REQUEST:
        {
           int s;
           /* This works for int32 params */
@@ -1166,6 +1166,7 @@ int opus_multistream_encoder_ctl_va_list(OpusMSEncoder *st, int request,
    case OPUS_GET_APPLICATION_REQUEST:
    case OPUS_GET_BANDWIDTH_REQUEST:
    case OPUS_GET_COMPLEXITY_REQUEST:
+   case OPUS_GET_CPU_BUDGET_US_REQUEST:
    case OPUS_GET_PACKET_LOSS_PERC_REQUEST:
    case OPUS_GET_DTX_REQUEST:
    case OPUS_GET_VOICE_RATIO_REQUEST:
@@ -1209,8 +1210,34 @@ int opus_multistream_encoder_ctl_va_list(OpusMSEncoder *st, int request,
       }
    }
    break;
+   case OPUS_GET_PROFILE_REQUEST:
+   {
+      int s, i;
+      opus_uint64 *value = va_arg(ap, opus_uint64*);
+      opus_uint64 tmp[OPUS_PROFILE_STAGES];
+      if (!value)
+      {
+         goto bad_arg;
+      }
+      OPUS_CLEAR(value, OPUS_PROFILE_STAGES);
+      for (s=0;s<st->layout.nb_streams;s++)
+      {
+         OpusEncoder *enc;
+         enc = (OpusEncoder*)ptr;
+         if (s < st->layout.nb_coupled_streams)
+            ptr += align(coupled_size);
+         else
+            ptr += align(mono_size);
+         ret = opus_encoder_ctl(enc, request, tmp);
+         if (ret != OPUS_OK) break;
+         for (i=0;i<OPUS_PROFILE_STAGES;i++)
+            value[i] += tmp[i];
+      }
+   }
+   break;
    case OPUS_SET_LSB_DEPTH_REQUEST:
    case OPUS_SET_COMPLEXITY_REQUEST:
+   case OPUS_SET_CPU_BUDGET_US_REQUEST:
    case OPUS_SET_VBR_REQUEST:
    case OPUS_SET_VBR_CONSTRAINT_REQUEST:
    case OPUS_SET_MAX_BANDWIDTH_REQUEST:
@@ -0,0 +1,465 @@
+/* Copyright (c) 2026 Opus contributors */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*In-process equivalent of tests/run_vectors.sh: loads the RFC 6716 test
+  vectors once, then decodes and compares every vector at every output rate
+  and channel count on a pool of threads.*/
+
+#define OPUS_COMPARE_NO_MAIN
+#include "opus_compare.c"
+
+#include <time.h>
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+#include "opus.h"
+
+#define NVECTORS (12)
+#define MAX_PACKET (1500)
+#define MAX_FRAME_SIZE (48000*2)
+
+static const opus_int32 RATES[5]={48000,24000,16000,12000,8000};
+
+typedef struct{
+  unsigned char *bits;
+  size_t         nbytes;
+  float         *ref;
+  size_t         ref_length;
+  float         *ref_m;
+  size_t         ref_m_length;
+}test_vector;
+
+typedef struct{
+  const test_vector *vector;
+  int                vi;
+  opus_int32         rate;
+  int                nchannels;
+  int                status;
+  double             err;
+  float              Q;
+  float              Q_m;
+  double             decode_time;
+  double             compare_time;
+  char               msg[COMPARE_MSG_SZ];
+}vector_job;
+
+typedef struct{
+  vector_job *jobs;
+  int         njobs;
+  int         next;
+  int         fast;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_t lock;
+#endif
+}vector_queue;
+
+static double wall_time(void){
+#if defined(_WIN32)
+  LARGE_INTEGER t;
+  LARGE_INTEGER f;
+  QueryPerformanceCounter(&t);
+  QueryPerformanceFrequency(&f);
+  return (double)t.QuadPart/(double)f.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+1e-9*ts.tv_nsec;
+#else
+  return (double)clock()/CLOCKS_PER_SEC;
+#endif
+}
+
+/*Per-job times use the thread's CPU time where available, so they do not
+  grow when there are more threads than cores.*/
+static double job_time(void){
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID,&ts);
+  return ts.tv_sec+1e-9*ts.tv_nsec;
+#else
+  return wall_time();
+#endif
+}
+
+static unsigned char *read_file(const char *_path,size_t *_nbytes){
+  FILE          *fin;
+  unsigned char *buf;
+  size_t         nbytes;
+  size_t         cbytes;
+  size_t         nread;
+  fin=fopen(_path,"rb");
+  if(fin==NULL)return NULL;
+  buf=NULL;
+  nbytes=cbytes=0;
+  do{
+    if(nbytes>=cbytes){
+      cbytes=cbytes<<1|65535;
+      buf=(unsigned char *)opus_realloc(buf,cbytes);
+    }
+    nread=fread(buf+nbytes,1,cbytes-nbytes,fin);
+    nbytes+=nread;
+  }
+  while(nread>0);
+  fclose(fin);
+  *_nbytes=nbytes;
+  return buf;
+}
+
+static int read_reference(float **_samples,size_t *_nsamples,
+ const char *_path){
+  FILE *fin;
+  fin=fopen(_path,"rb");
+  if(fin==NULL)return -1;
+  *_nsamples=read_pcm16(_samples,fin,2);
+  fclose(fin);
+  return 0;
+}
+
+static opus_uint32 char_to_int(const unsigned char _ch[4]){
+  return ((opus_uint32)_ch[0]<<24)|((opus_uint32)_ch[1]<<16)
+   |((opus_uint32)_ch[2]<<8)|(opus_uint32)_ch[3];
+}
+
+/*Decodes an opus_demo bitstream the same way opus_demo -d does, checking the
+  final range coder state of every packet. Returns the number of decoded
+  samples per channel, or -1 on error.*/
+static long decode_vector(float **_out,const test_vector *_vector,
+ opus_int32 _rate,int _nchannels,char *_msg){
+  OpusDecoder *dec;
+  opus_int16  *pcm;
+  float       *out;
+  size_t       pos;
+  size_t       nout;
+  size_t       cout;
+  long         count;
+  int          lost_prev;
+  int          err;
+  dec=opus_decoder_create(_rate,_nchannels,&err);
+  if(err!=OPUS_OK){
+    sprintf(_msg,"Cannot create decoder: %s",opus_strerror(err));
+    return -1;
+  }
+  pcm=(opus_int16 *)opus_malloc(MAX_FRAME_SIZE*_nchannels*sizeof(*pcm));
+  out=NULL;
+  nout=cout=0;
+  pos=0;
+  count=0;
+  lost_prev=1;
+  while(pos+8<=_vector->nbytes){
+    const unsigned char *data;
+    opus_uint32          enc_final_range;
+    opus_uint32          dec_final_range;
+    opus_int32           output_samples;
+    opus_int32           len;
+    int                  lost;
+    int                  i;
+    len=(opus_int32)char_to_int(_vector->bits+pos);
+    enc_final_range=char_to_int(_vector->bits+pos+4);
+    pos+=8;
+    if(len>MAX_PACKET||len<0){
+      sprintf(_msg,"Invalid payload length: %ld",(long)len);
+      break;
+    }
+    if(pos+len>_vector->nbytes){
+      sprintf(_msg,"Ran out of input, expecting %ld bytes got %ld",
+       (long)len,(long)(_vector->nbytes-pos));
+      break;
+    }
+    data=_vector->bits+pos;
+    pos+=len;
+    lost=len==0;
+    if(lost){
+      opus_decoder_ctl(dec,OPUS_GET_LAST_PACKET_DURATION(&output_samples));
+    }
+    else output_samples=MAX_FRAME_SIZE;
+    output_samples=opus_decode(dec,lost?NULL:data,len,pcm,output_samples,0);
+    if(output_samples>0){
+      if(nout+output_samples>cout){
+        do cout=cout<<1|1;
+        while(nout+output_samples>cout);
+        out=(float *)opus_realloc(out,_nchannels*cout*sizeof(*out));
+      }
+      for(i=0;i<output_samples*_nchannels;i++){
+        out[nout*_nchannels+i]=pcm[i];
+      }
+      nout+=output_samples;
+    }
+    opus_decoder_ctl(dec,OPUS_GET_FINAL_RANGE(&dec_final_range));
+    if(enc_final_range!=0&&!lost&&!lost_prev
+     &&dec_final_range!=enc_final_range){
+      sprintf(_msg,"Range coder state mismatch between encoder and decoder "
+       "in frame %ld: 0x%8lx vs 0x%8lx",count,(unsigned long)enc_final_range,
+       (unsigned long)dec_final_range);
+      free(out);
+      free(pcm);
+      opus_decoder_destroy(dec);
+      return -1;
+    }
+    lost_prev=lost;
+    count++;
+  }
+  free(pcm);
+  opus_decoder_destroy(dec);
+  *_out=out;
+  return (long)nout;
+}
+
+static void run_vector_job(vector_job *_job,int _fast){
+  const test_vector *vector;
+  float             *y;
+  double             start;
+  double             err_m;
+  long               ylength;
+  int                status_m;
+  char               msg_m[COMPARE_MSG_SZ];
+  vector=_job->vector;
+  _job->msg[0]='\0';
+  _job->Q=_job->Q_m=0;
+  start=job_time();
+  ylength=decode_vector(&y,vector,_job->rate,_job->nchannels,_job->msg);
+  _job->decode_time=job_time()-start;
+  if(ylength<0){
+    _job->status=COMPARE_ERROR;
+    return;
+  }
+  start=job_time();
+  _job->status=compare_pcm(vector->ref,vector->ref_length,y,ylength,
+   _job->nchannels,_job->rate,_fast,&_job->err,&_job->Q,_job->msg);
+  /*Either reference output is acceptable, as in run_vectors.sh.*/
+  if(vector->ref_m!=NULL){
+    msg_m[0]='\0';
+    status_m=compare_pcm(vector->ref_m,vector->ref_m_length,y,ylength,
+     _job->nchannels,_job->rate,_fast,&err_m,&_job->Q_m,msg_m);
+    if(_job->status!=COMPARE_PASS&&status_m==COMPARE_PASS){
+      _job->status=COMPARE_PASS;
+      _job->err=err_m;
+    }
+  }
+  _job->compare_time=job_time()-start;
+  free(y);
+}
+
+static void *vector_worker(void *_arg){
+  vector_queue *queue;
+  queue=(vector_queue *)_arg;
+  for(;;){
+    int ji;
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&queue->lock);
+#endif
+    ji=queue->next++;
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&queue->lock);
+#endif
+    if(ji>=queue->njobs)break;
+    run_vector_job(queue->jobs+ji,queue->fast);
+  }
+  return NULL;
+}
+
+static void usage(const char *_argv0){
+  fprintf(stderr,"Usage: %s [-r rate] [-j threads] [-fast] <vector path>\n",
+   _argv0);
+  fprintf(stderr,"  -r rate     : only decode at this rate; default: all of "
+   "8000, 12000, 16000, 24000 and 48000\n");
+  fprintf(stderr,"  -j threads  : decode that many vectors in parallel; "
+   "default: 1\n");
+  fprintf(stderr,"  -fast       : compare with an FFT (same metric, "
+   "not bit-exact)\n");
+}
+
+int main(int _argc,const char **_argv){
+  test_vector   vectors[NVECTORS];
+  vector_queue  queue;
+  const char   *argv0;
+  const char   *path;
+  char          name[4096];
+  opus_int32    rate;
+  double        start;
+  double        elapsed;
+  double        busy;
+  int           nthreads;
+  int           nfailed;
+  int           vi;
+  int           ri;
+  int           ci;
+  int           ji;
+  argv0=_argv[0];
+  rate=0;
+  nthreads=1;
+  queue.fast=0;
+  for(;_argc>1&&_argv[1][0]=='-';_argc--,_argv++){
+    if(strcmp(_argv[1],"-fast")==0)queue.fast=1;
+    else if(_argc>2&&strcmp(_argv[1],"-r")==0){
+      rate=atoi(_argv[2]);
+      if(rate!=8000&&rate!=12000&&rate!=16000&&rate!=24000&&rate!=48000){
+        fprintf(stderr,
+         "Sampling rate must be 8000, 12000, 16000, 24000, or 48000\n");
+        return EXIT_FAILURE;
+      }
+      _argc--;
+      _argv++;
+    }
+    else if(_argc>2&&strcmp(_argv[1],"-j")==0){
+      nthreads=atoi(_argv[2]);
+      _argc--;
+      _argv++;
+    }
+    else{
+      usage(argv0);
+      return EXIT_FAILURE;
+    }
+  }
+  if(_argc!=2){
+    usage(argv0);
+    return EXIT_FAILURE;
+  }
+  path=_argv[1];
+  if(nthreads<1)nthreads=1;
+#ifndef HAVE_PTHREAD
+  if(nthreads>1){
+    fprintf(stderr,"This build of %s has no thread support.\n",argv0);
+    return EXIT_FAILURE;
+  }
+#endif
+  fprintf(stderr,"Testing %s\n",opus_get_version_string());
+  start=wall_time();
+  for(vi=0;vi<NVECTORS;vi++){
+    test_vector *vector;
+    vector=vectors+vi;
+    sprintf(name,"%.4000s/testvector%02d.bit",path,vi+1);
+    vector->bits=read_file(name,&vector->nbytes);
+    if(vector->bits==NULL){
+      /*The vectors are distributed separately, so a missing directory is
+        not a failure, but a missing vector in it is.*/
+      if(vi==0){
+        fprintf(stderr,"No test vectors found in %s\n",path);
+        return EXIT_SUCCESS;
+      }
+      fprintf(stderr,"Bitstream file not found: %s\n",name);
+      return EXIT_FAILURE;
+    }
+    sprintf(name,"%.4000s/testvector%02d.dec",path,vi+1);
+    if(read_reference(&vector->ref,&vector->ref_length,name)<0){
+      fprintf(stderr,"Reference file not found: %s\n",name);
+      return EXIT_FAILURE;
+    }
+    sprintf(name,"%.4000s/testvector%02dm.dec",path,vi+1);
+    if(read_reference(&vector->ref_m,&vector->ref_m_length,name)<0){
+      vector->ref_m=NULL;
+    }
+  }
+  fprintf(stderr,"Loaded %d test vectors in %.3f s\n",NVECTORS,
+   wall_time()-start);
+  queue.njobs=0;
+  queue.jobs=(vector_job *)opus_malloc(5*2*NVECTORS*sizeof(*queue.jobs));
+  for(ri=0;ri<5;ri++){
+    if(rate!=0&&RATES[ri]!=rate)continue;
+    for(ci=1;ci<=2;ci++){
+      for(vi=0;vi<NVECTORS;vi++){
+        vector_job *job;
+        job=queue.jobs+queue.njobs++;
+        job->vector=vectors+vi;
+        job->vi=vi;
+        job->rate=RATES[ri];
+        job->nchannels=ci;
+      }
+    }
+  }
+  queue.next=0;
+  if(nthreads>queue.njobs)nthreads=queue.njobs;
+  start=wall_time();
+#ifdef HAVE_PTHREAD
+  if(nthreads>1){
+    pthread_t *threads;
+    int        ti;
+    threads=(pthread_t *)opus_malloc(nthreads*sizeof(*threads));
+    pthread_mutex_init(&queue.lock,NULL);
+    for(ti=0;ti<nthreads;ti++){
+      if(pthread_create(threads+ti,NULL,vector_worker,&queue)!=0){
+        fprintf(stderr,"Error creating thread %i.\n",ti);
+        exit(EXIT_FAILURE);
+      }
+    }
+    for(ti=0;ti<nthreads;ti++)pthread_join(threads[ti],NULL);
+    pthread_mutex_destroy(&queue.lock);
+    free(threads);
+  }
+  else
+#endif
+  vector_worker(&queue);
+  elapsed=wall_time()-start;
+  nfailed=0;
+  busy=0;
+  for(ji=0;ji<queue.njobs;ji++){
+    vector_job *job;
+    job=queue.jobs+ji;
+    busy+=job->decode_time+job->compare_time;
+    if(job->status==COMPARE_ERROR){
+      fprintf(stderr,"testvector%02d %5ld Hz %s: ERROR: %s\n",job->vi+1,
+       (long)job->rate,job->nchannels==2?"stereo":"mono  ",job->msg);
+    }
+    else{
+      fprintf(stderr,"testvector%02d %5ld Hz %s: %s (quality %5.1f %%), "
+       "decode %7.2f ms, compare %7.2f ms\n",job->vi+1,(long)job->rate,
+       job->nchannels==2?"stereo":"mono  ",
+       job->status==COMPARE_PASS?"PASS":"FAIL",job->Q>job->Q_m?job->Q:job->Q_m,
+       1e3*job->decode_time,1e3*job->compare_time);
+    }
+    if(job->status!=COMPARE_PASS)nfailed++;
+    /*Same summary as run_vectors.sh: average each reference set separately
+      over the 12 vectors and report the better of the two.*/
+    if(job->vi==NVECTORS-1){
+      double q;
+      double q_m;
+      int    vj;
+      q=q_m=0;
+      for(vj=0;vj<NVECTORS;vj++){
+        q+=job[vj-job->vi].Q;
+        q_m+=job[vj-job->vi].Q_m;
+      }
+      q/=NVECTORS;
+      q_m/=NVECTORS;
+      fprintf(stderr,"Average %s quality at %ld Hz is %.1f %%\n",
+       job->nchannels==2?"stereo":"mono",(long)job->rate,q>q_m?q:q_m);
+    }
+  }
+  fprintf(stderr,"%d of %d decodes passed in %.3f s on %d thread(s) "
+   "(%.3f s of work)\n",queue.njobs-nfailed,queue.njobs,elapsed,nthreads,
+   busy);
+  free(queue.jobs);
+  for(vi=0;vi<NVECTORS;vi++){
+    free(vectors[vi].bits);
+    free(vectors[vi].ref);
+    free(vectors[vi].ref_m);
+  }
+  if(nfailed>0){
+    fprintf(stderr,"ERROR: %d decode(s) do not match the reference\n",nfailed);
+    return EXIT_FAILURE;
+  }
+  fprintf(stderr,"All tests have passed successfully\n");
+  return EXIT_SUCCESS;
+}
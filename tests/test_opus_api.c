@@ -92,8 +92,10 @@ opus_int32 test_dec_api(void)
    unsigned char packet[1276];
 #ifndef DISABLE_FLOAT_API
    float fbuf[960*2];
+   float flostbuf[960*2];
 #endif
    short sbuf[960*2];
+   short slostbuf[960*2];
    int c,err;
 
    cfgs=0;
@@ -203,6 +205,25 @@ opus_int32 test_dec_api(void)
    cfgs++;
    fprintf(stdout,"    OPUS_GET_PITCH ............................... OK.\n");
 
+   {
+      opus_uint64 prof[OPUS_PROFILE_STAGES];
+      opus_uint64 total;
+      err=opus_decoder_ctl(dec, OPUS_GET_PROFILE((opus_uint64 *)NULL));
+      if(err != OPUS_BAD_ARG && err != OPUS_UNIMPLEMENTED)test_failed();
+      cfgs++;
+      err=opus_decoder_ctl(dec, OPUS_GET_PROFILE(prof));
+      if(err != OPUS_OK && err != OPUS_UNIMPLEMENTED)test_failed();
+      if(err == OPUS_OK)
+      {
+         total=0;
+         for(i=0;i<OPUS_PROFILE_STAGES;i++)total+=prof[i];
+         if(total==0)test_failed();
+      }
+      cfgs++;
+      fprintf(stdout,"    OPUS_GET_PROFILE ............................. %s.\n",
+            err == OPUS_OK ? "OK" : "N/A");
+   }
+
    err=opus_decoder_ctl(dec, OPUS_GET_LAST_PACKET_DURATION(null_int_ptr));
    if(err != OPUS_BAD_ARG)test_failed();
    VG_UNDEF(&i,sizeof(i));
@@ -236,6 +257,56 @@ opus_int32 test_dec_api(void)
    fprintf(stdout,"    OPUS_SET_GAIN ................................ OK.\n");
    fprintf(stdout,"    OPUS_GET_GAIN ................................ OK.\n");
 
+   VG_UNDEF(&i,sizeof(i));
+   err=opus_decoder_ctl(dec, OPUS_GET_BANDLIMITED_DECODE(&i));
+   VG_CHECK(&i,sizeof(i));
+   if(err != OPUS_OK || i!=0)test_failed();
+   cfgs++;
+   err=opus_decoder_ctl(dec, OPUS_GET_BANDLIMITED_DECODE(null_int_ptr));
+   if(err != OPUS_BAD_ARG)test_failed();
+   cfgs++;
+   err=opus_decoder_ctl(dec, OPUS_SET_BANDLIMITED_DECODE(-1));
+   if(err != OPUS_BAD_ARG)test_failed();
+   cfgs++;
+   err=opus_decoder_ctl(dec, OPUS_SET_BANDLIMITED_DECODE(2));
+   if(err != OPUS_BAD_ARG)test_failed();
+   cfgs++;
+   err=opus_decoder_ctl(dec, OPUS_SET_BANDLIMITED_DECODE(1));
+   if(err != OPUS_OK)test_failed();
+   cfgs++;
+   VG_UNDEF(&i,sizeof(i));
+   err=opus_decoder_ctl(dec, OPUS_GET_BANDLIMITED_DECODE(&i));
+   VG_CHECK(&i,sizeof(i));
+   if(err != OPUS_OK || i!=1)test_failed();
+   cfgs++;
+   fprintf(stdout,"    OPUS_SET_BANDLIMITED_DECODE .................. OK.\n");
+   fprintf(stdout,"    OPUS_GET_BANDLIMITED_DECODE .................. OK.\n");
+
+   VG_UNDEF(&i,sizeof(i));
+   err=opus_decoder_ctl(dec, OPUS_GET_PLC_COMPLEXITY(&i));
+   VG_CHECK(&i,sizeof(i));
+   if(err != OPUS_OK || i!=10)test_failed();
+   cfgs++;
+   err=opus_decoder_ctl(dec, OPUS_GET_PLC_COMPLEXITY(null_int_ptr));
+   if(err != OPUS_BAD_ARG)test_failed();
+   cfgs++;
+   err=opus_decoder_ctl(dec, OPUS_SET_PLC_COMPLEXITY(-1));
+   if(err != OPUS_BAD_ARG)test_failed();
+   cfgs++;
+   err=opus_decoder_ctl(dec, OPUS_SET_PLC_COMPLEXITY(11));
+   if(err != OPUS_BAD_ARG)test_failed();
+   cfgs++;
+   err=opus_decoder_ctl(dec, OPUS_SET_PLC_COMPLEXITY(3));
+   if(err != OPUS_OK)test_failed();
+   cfgs++;
+   VG_UNDEF(&i,sizeof(i));
+   err=opus_decoder_ctl(dec, OPUS_GET_PLC_COMPLEXITY(&i));
+   VG_CHECK(&i,sizeof(i));
+   if(err != OPUS_OK || i!=3)test_failed();
+   cfgs++;
+   fprintf(stdout,"    OPUS_SET_PLC_COMPLEXITY ...................... OK.\n");
+   fprintf(stdout,"    OPUS_GET_PLC_COMPLEXITY ...................... OK.\n");
+
    /*Reset the decoder*/
    dec2=malloc(opus_decoder_get_size(2));
    memcpy(dec2,dec,opus_decoder_get_size(2));
@@ -286,6 +357,28 @@ opus_int32 test_dec_api(void)
    }
    fprintf(stdout,"    opus_packet_get_bandwidth() .................. OK.\n");
 
+   {
+      unsigned char activity[48];
+      opus_int16 level[48];
+      opus_int16 activity_mem[OPUS_ACTIVITY_MEM_SIZE];
+      memset(activity_mem,0,sizeof(activity_mem));
+      packet[0]=0;
+      if(opus_packet_get_activity(packet,0,activity,level,activity_mem)!=OPUS_BAD_ARG)test_failed();
+      if(opus_packet_get_activity(packet,1,activity,level,NULL)!=OPUS_BAD_ARG)test_failed();
+      /*A TOC byte alone is a DTX frame.*/
+      for(i=0;i<4;i++) {
+         packet[0]=(i<<6)|(i<<4);
+         if(opus_packet_get_activity(packet,1,activity,level,activity_mem)!=1)test_failed();
+         if(activity[0]!=0||level[0]!=-32768)test_failed();
+         cfgs++;
+      }
+      packet[0]=3;
+      packet[1]=0;
+      if(opus_packet_get_activity(packet,2,activity,level,activity_mem)!=OPUS_INVALID_PACKET)test_failed();
+      cfgs+=3;
+   }
+   fprintf(stdout,"    opus_packet_get_activity() ................... OK.\n");
+
    for(i=0;i<256;i++) {
      int fp3s,rate;
      packet[0]=i;
@@ -322,6 +415,48 @@ opus_int32 test_dec_api(void)
    fprintf(stdout,"    opus_decode_float() .......................... OK.\n");
 #endif
 
+   {
+      OpusPacketIter it;
+      if(opus_packet_iter_init(&it, packet, 3, 0)!=1)test_failed();
+      cfgs++;
+      if(opus_decode_parsed(dec, &it, sbuf, 480, 0)!=OPUS_BUFFER_TOO_SMALL)test_failed();
+      cfgs++;
+      if(opus_decode_parsed(dec, &it, sbuf, 960, 2)!=OPUS_BAD_ARG)test_failed();
+      cfgs++;
+      VG_UNDEF(sbuf,sizeof(sbuf));
+      if(opus_decode_parsed(dec, &it, sbuf, 960, 0)!=960)test_failed();
+      cfgs++;
+      fprintf(stdout,"    opus_decode_parsed() ......................... OK.\n");
+#ifndef DISABLE_FLOAT_API
+      VG_UNDEF(fbuf,sizeof(fbuf));
+      if(opus_decode_parsed_float(dec, &it, fbuf, 960, 0)!=960)test_failed();
+      cfgs++;
+      fprintf(stdout,"    opus_decode_parsed_float() ................... OK.\n");
+#endif
+   }
+
+   if(opus_decode_recover(dec, packet, 3, slostbuf, 100, sbuf, 960)!=OPUS_BAD_ARG)test_failed();
+   cfgs++;
+   if(opus_decode_recover(dec, packet, 3, slostbuf, 0, sbuf, 960)!=OPUS_BAD_ARG)test_failed();
+   cfgs++;
+   if(opus_decode_recover(dec, packet, -1, slostbuf, 960, sbuf, 960)!=OPUS_BAD_ARG)test_failed();
+   cfgs++;
+   if(opus_decode_recover(dec, packet, 3, slostbuf, 960, sbuf, 480)!=OPUS_BUFFER_TOO_SMALL)test_failed();
+   cfgs++;
+   VG_UNDEF(slostbuf,sizeof(slostbuf));
+   VG_UNDEF(sbuf,sizeof(sbuf));
+   if(opus_decode_recover(dec, packet, 3, slostbuf, 960, sbuf, 960)!=960)test_failed();
+   cfgs++;
+   VG_CHECK(slostbuf,sizeof(slostbuf));
+   fprintf(stdout,"    opus_decode_recover() ........................ OK.\n");
+#ifndef DISABLE_FLOAT_API
+   VG_UNDEF(flostbuf,sizeof(flostbuf));
+   VG_UNDEF(fbuf,sizeof(fbuf));
+   if(opus_decode_recover_float(dec, packet, 3, flostbuf, 480, fbuf, 960)!=960)test_failed();
+   cfgs++;
+   fprintf(stdout,"    opus_decode_recover_float() .................. OK.\n");
+#endif
+
 #if 0
    /*These tests are disabled because the library crashes with null states*/
    if(opus_decoder_ctl(0,OPUS_RESET_STATE)         !=OPUS_INVALID_STATE)test_failed();
@@ -1033,6 +1168,66 @@ opus_int32 test_parse(void)
    fprintf(stdout,"    code 3 padding (%2d cases) ............... OK.\n",cfgs);
    cfgs_total+=cfgs;
    fprintf(stdout,"    opus_packet_parse ............................ OK.\n");
+
+   {
+      OpusPacketIter it;
+      opus_int32 offset;
+      opus_int16 fsize;
+      const opus_int16 exp_size[3]={5,253,20};
+      const opus_int32 exp_offset[3]={6,11,264};
+      cfgs=0;
+      /*VBR code 3 with 3 frames and 10 bytes of padding*/
+      memset(packet,0,sizeof(char)*1276);
+      packet[0]=(31<<2)+3;
+      packet[1]=128+64+3;
+      packet[2]=10;
+      packet[3]=5;
+      packet[4]=253;
+      packet[5]=0;
+      if(opus_packet_iter_init(&it,packet,273,0)!=OPUS_INVALID_PACKET)test_failed();
+      cfgs++;
+      if(opus_packet_iter_init(&it,packet,294,0)!=3)test_failed();
+      cfgs++;
+      if(it.toc!=packet[0]||it.nb_frames!=3||it.padding!=10)test_failed();
+      if(it.payload_offset!=6||it.packet_len!=294)test_failed();
+      for(j=0;j<2;j++)
+      {
+         for(i=0;i<3;i++)
+         {
+            if(opus_packet_iter_next(&it,&offset,&fsize)!=1)test_failed();
+            cfgs++;
+            if(offset!=exp_offset[i]||fsize!=exp_size[i])test_failed();
+         }
+         if(opus_packet_iter_next(&it,&offset,&fsize)!=0)test_failed();
+         cfgs++;
+         opus_packet_iter_rewind(&it);
+      }
+      /*Same frames self-delimited, followed by a code 0 packet*/
+      memmove(&packet[7],&packet[6],288);
+      packet[6]=20;
+      packet[295]=0;
+      packet[296]=packet[297]=0;
+      if(opus_packet_iter_init(&it,packet,298,1)!=3)test_failed();
+      cfgs++;
+      if(it.payload_offset!=7||it.packet_len!=295||it.padding!=10)test_failed();
+      for(i=0;i<3;i++)
+      {
+         if(opus_packet_iter_next(&it,&offset,&fsize)!=1)test_failed();
+         cfgs++;
+         if(offset!=exp_offset[i]+1||fsize!=exp_size[i])test_failed();
+      }
+      if(opus_packet_iter_next_stream(&it,0)!=1)test_failed();
+      cfgs++;
+      if(it.data!=&packet[295]||it.len!=3||it.packet_len!=3||it.padding!=0)test_failed();
+      if(opus_packet_iter_next(&it,&offset,&fsize)!=1)test_failed();
+      cfgs++;
+      if(offset!=1||fsize!=2)test_failed();
+      if(opus_packet_iter_next_stream(&it,0)!=OPUS_INVALID_PACKET)test_failed();
+      cfgs++;
+      if(it.data!=&packet[295])test_failed();
+      cfgs_total+=cfgs;
+      fprintf(stdout,"    opus_packet_iter ............................. OK.\n");
+   }
    fprintf(stdout,"                      All packet parsing tests passed\n");
    fprintf(stdout,"                          (%d API invocations)\n",cfgs_total);
    return cfgs_total;
@@ -1062,6 +1257,23 @@ opus_int32 test_parse(void)
    fprintf(stdout,gok);\
    cfgs+=6;
 
+static int trace_frames;
+static int trace_samples;
+static int trace_complexity;
+
+static void trace_cb(void *user_data, const OpusEncoderFrameInfo *info)
+{
+   if(user_data!=(void *)&trace_frames)test_failed();
+   if(info->mode<1000 || info->mode>1002)test_failed();
+   if(info->bandwidth<OPUS_BANDWIDTH_NARROWBAND || info->bandwidth>OPUS_BANDWIDTH_FULLBAND)test_failed();
+   if(info->bytes<1 || info->bytes>1276)test_failed();
+   if(info->mode==1002 && info->silk_bitrate!=0)test_failed();
+   if(info->complexity<0 || info->complexity>10)test_failed();
+   trace_complexity=info->complexity;
+   trace_frames++;
+   trace_samples+=info->frame_size;
+}
+
 opus_int32 test_enc_api(void)
 {
    opus_uint32 enc_final_range;
@@ -1073,6 +1285,7 @@ opus_int32 test_enc_api(void)
 #endif
    short sbuf[960*2];
    int c,err,cfgs;
+   int have_cpu_budget;
 
    cfgs=0;
    /*First test invalid configurations which should fail*/
@@ -1295,6 +1508,25 @@ opus_int32 test_enc_api(void)
      "    OPUS_SET_COMPLEXITY .......................... OK.\n",
      "    OPUS_GET_COMPLEXITY .......................... OK.\n")
 
+   err=opus_encoder_ctl(enc,OPUS_GET_CPU_BUDGET_US(null_int_ptr));
+   if(err!=OPUS_BAD_ARG)test_failed();
+   cfgs++;
+   /*A non-zero budget needs a monotonic clock, which not every platform has*/
+   if(opus_encoder_ctl(enc,OPUS_SET_CPU_BUDGET_US(-1))==OPUS_OK)test_failed();
+   if(opus_encoder_ctl(enc,OPUS_SET_CPU_BUDGET_US(1000001))==OPUS_OK)test_failed();
+   have_cpu_budget=opus_encoder_ctl(enc,OPUS_SET_CPU_BUDGET_US(20000));
+   if(have_cpu_budget!=OPUS_OK && have_cpu_budget!=OPUS_UNIMPLEMENTED)test_failed();
+   have_cpu_budget=have_cpu_budget==OPUS_OK;
+   i=-12345;
+   if(opus_encoder_ctl(enc,OPUS_GET_CPU_BUDGET_US(&i))!=OPUS_OK || i!=(have_cpu_budget?20000:0))test_failed();
+   if(opus_encoder_ctl(enc,OPUS_SET_CPU_BUDGET_US(0))!=OPUS_OK)test_failed();
+   i=-12345;
+   if(opus_encoder_ctl(enc,OPUS_GET_CPU_BUDGET_US(&i))!=OPUS_OK || i!=0)test_failed();
+   cfgs+=6;
+   fprintf(stdout,"    OPUS_SET_CPU_BUDGET_US ....................... %s.\n",
+         have_cpu_budget ? "OK" : "N/A");
+   fprintf(stdout,"    OPUS_GET_CPU_BUDGET_US ....................... OK.\n");
+
    err=opus_encoder_ctl(enc,OPUS_GET_INBAND_FEC(null_int_ptr));
    if(err!=OPUS_BAD_ARG)test_failed();
    cfgs++;
@@ -1426,6 +1658,65 @@ opus_int32 test_enc_api(void)
    fprintf(stdout,"    opus_encode_float() .......................... OK.\n");
 #endif
 
+   {
+      opus_uint64 prof[OPUS_PROFILE_STAGES];
+      opus_uint64 total;
+      err=opus_encoder_ctl(enc, OPUS_GET_PROFILE((opus_uint64 *)NULL));
+      if(err != OPUS_BAD_ARG && err != OPUS_UNIMPLEMENTED)test_failed();
+      cfgs++;
+      err=opus_encoder_ctl(enc, OPUS_GET_PROFILE(prof));
+      if(err != OPUS_OK && err != OPUS_UNIMPLEMENTED)test_failed();
+      if(err == OPUS_OK)
+      {
+         total=0;
+         for(i=0;i<OPUS_PROFILE_STAGES;i++)total+=prof[i];
+         if(total==0)test_failed();
+      }
+      cfgs++;
+      fprintf(stdout,"    OPUS_GET_PROFILE ............................. %s.\n",
+            err == OPUS_OK ? "OK" : "N/A");
+   }
+
+   if(opus_encoder_set_trace(enc, trace_cb, &trace_frames)!=OPUS_OK)test_failed();
+   cfgs++;
+   for(j=0;j<4;j++)
+   {
+      trace_frames=trace_samples=0;
+      i=opus_encode(enc, sbuf, 960, packet, sizeof(packet));
+      if(i<1 || (i>(opus_int32)sizeof(packet)))test_failed();
+      if(trace_frames<1 || trace_samples!=960)test_failed();
+      cfgs++;
+   }
+   /*A budget no frame can meet walks the complexity down to 0 without
+     changing the configured value, and disabling it restores that value.*/
+   if(have_cpu_budget)
+   {
+      if(opus_encoder_ctl(enc,OPUS_SET_COMPLEXITY(10))!=OPUS_OK)test_failed();
+      if(opus_encoder_ctl(enc,OPUS_SET_CPU_BUDGET_US(1))!=OPUS_OK)test_failed();
+      cfgs+=2;
+      for(j=0;j<200&&trace_complexity>0;j++)
+      {
+         i=opus_encode(enc, sbuf, 960, packet, sizeof(packet));
+         if(i<1 || (i>(opus_int32)sizeof(packet)))test_failed();
+         cfgs++;
+      }
+      if(trace_complexity!=0)test_failed();
+      if(opus_encoder_ctl(enc,OPUS_GET_COMPLEXITY(&i))!=OPUS_OK || i!=10)test_failed();
+      if(opus_encoder_ctl(enc,OPUS_SET_CPU_BUDGET_US(0))!=OPUS_OK)test_failed();
+      i=opus_encode(enc, sbuf, 960, packet, sizeof(packet));
+      if(i<1 || trace_complexity!=10)test_failed();
+      cfgs+=3;
+   }
+   fprintf(stdout,"    OPUS_SET_CPU_BUDGET_US adaptation ............ %s.\n",
+         have_cpu_budget ? "OK" : "N/A");
+   if(opus_encoder_set_trace(enc, NULL, NULL)!=OPUS_OK)test_failed();
+   cfgs++;
+   trace_frames=0;
+   i=opus_encode(enc, sbuf, 960, packet, sizeof(packet));
+   if(i<1 || trace_frames!=0)test_failed();
+   cfgs++;
+   fprintf(stdout,"    opus_encoder_set_trace() ..................... OK.\n");
+
 #if 0
    /*These tests are disabled because the library crashes with null states*/
    if(opus_encoder_ctl(0,OPUS_RESET_STATE)               !=OPUS_INVALID_STATE)test_failed();
@@ -81,6 +81,10 @@ int test_decoder_code0(int no_fuzz)
       err=OPUS_INTERNAL_ERROR;
       dec[t] = opus_decoder_create(fs, c, &err);
       if(err!=OPUS_OK || dec[t]==NULL)test_failed();
+      /*Band-limited decoding must not affect the final range*/
+      if(fs<48000&&c==2&&opus_decoder_ctl(dec[t], OPUS_SET_BANDLIMITED_DECODE(1))!=OPUS_OK)test_failed();
+      /*Exercise the reduced complexity concealment*/
+      if(c==1&&opus_decoder_ctl(dec[t], OPUS_SET_PLC_COMPLEXITY(t>>1))!=OPUS_OK)test_failed();
       fprintf(stdout,"    opus_decoder_create(%5d,%d) OK. Copy ",fs,c);
       {
          OpusDecoder *dec2;
@@ -182,6 +182,658 @@ int test_encode(OpusEncoder *enc, int channels, int frame_size, OpusDecoder *dec
    return ret;
 }
 
+/* Encodes digital silence, loud music and the same music 30 dB down in
+   each mode, with and without FEC, and checks what opus_packet_get_activity()
+   reports for them. */
+void run_activity_test(void)
+{
+   static const int modes[3]={MODE_SILK_ONLY,MODE_HYBRID,MODE_CELT_ONLY};
+   opus_int16 *inbuf;
+   opus_int16 *quietbuf;
+   opus_int16 *silence;
+   unsigned char packet[MAX_PACKET];
+   unsigned char activity[48];
+   opus_int16 level[48];
+   opus_int16 activity_mem[OPUS_ACTIVITY_MEM_SIZE];
+   OpusEncoder *enc;
+   int m, fec, i, err;
+
+   inbuf=(opus_int16*)malloc(sizeof(*inbuf)*2*48000);
+   quietbuf=(opus_int16*)malloc(sizeof(*quietbuf)*2*48000);
+   silence=(opus_int16*)calloc(2*960, sizeof(*silence));
+   generate_music(inbuf, 48000);
+   for(i=0;i<2*48000;i++)quietbuf[i]=inbuf[i]/32;
+   for(m=0;m<3;m++)
+   {
+      for(fec=0;fec<2;fec++)
+      {
+         opus_int32 loud_level=0;
+         opus_int32 quiet_level=0;
+         int nb_active=0;
+         int pass;
+         /* Loud, silent and quiet input, each from a fresh encoder */
+         for(pass=0;pass<3;pass++)
+         {
+            enc=opus_encoder_create(48000, 2, OPUS_APPLICATION_VOIP, &err);
+            if(err!=OPUS_OK || enc==NULL)test_failed();
+            if(opus_encoder_ctl(enc, OPUS_SET_FORCE_MODE(modes[m]))!=OPUS_OK)test_failed();
+            if(opus_encoder_ctl(enc, OPUS_SET_BANDWIDTH(modes[m]==MODE_SILK_ONLY?OPUS_BANDWIDTH_WIDEBAND:OPUS_BANDWIDTH_FULLBAND))!=OPUS_OK)test_failed();
+            if(opus_encoder_ctl(enc, OPUS_SET_BITRATE(modes[m]==MODE_SILK_ONLY?24000:48000))!=OPUS_OK)test_failed();
+            if(opus_encoder_ctl(enc, OPUS_SET_INBAND_FEC(fec))!=OPUS_OK)test_failed();
+            if(opus_encoder_ctl(enc, OPUS_SET_PACKET_LOSS_PERC(fec?20:0))!=OPUS_OK)test_failed();
+            memset(activity_mem,0,sizeof(activity_mem));
+            /* Skip the 60 ms of silence at the start of generate_music() and
+               give the encoder and the CELT energy prediction time to settle. */
+            for(i=0;i<50;i++)
+            {
+               const opus_int16 *in;
+               int len;
+               in=pass==1?silence:(pass==0?inbuf:quietbuf)+2*i*960;
+               len=opus_encode(enc, in, 960, packet, MAX_PACKET);
+               if(len<2)test_failed();
+               if(opus_packet_get_activity(packet,len,activity,level,activity_mem)!=1)test_failed();
+               if(activity[0]>1 || level[0]>0)test_failed();
+               if(i<10)continue;
+               if(pass==0)
+               {
+                  nb_active+=activity[0];
+                  loud_level+=level[0];
+               } else if(pass==1) {
+                  /* Digital silence is never active */
+                  if(activity[0]!=0)test_failed();
+               } else {
+                  quiet_level+=level[0];
+               }
+            }
+            opus_encoder_destroy(enc);
+         }
+         /* Loud music is mostly active (the SILK VAD drops a few frames of
+            it) and reads well above the same music 30 dB down. The levels
+            are summed over 40 frames, in Q8 dB. */
+         if(nb_active<30)test_failed();
+         if(loud_level-quiet_level<40*256*20)test_failed();
+      }
+   }
+   free(inbuf);
+   free(quietbuf);
+   free(silence);
+   fprintf(stdout,"    opus_packet_get_activity() OK.\n");
+}
+
+/* Decodes CELT and hybrid streams below 48 kHz with and without
+   OPUS_SET_BANDLIMITED_DECODE. Skipping the bands above the output
+   bandwidth must not change the decoded audio. */
+void run_bandlimited_test(void)
+{
+   static const int rates[4]={8000,12000,16000,24000};
+   static const int frame_sizes[4]={120,240,480,960};
+   opus_int16 *inbuf;
+   opus_int16 out[2*960];
+   opus_int16 out2[2*960];
+   unsigned char packet[MAX_PACKET];
+   OpusEncoder *enc;
+   OpusDecoder *dec;
+   OpusDecoder *dec2;
+   int c, fi, ri, i, err;
+
+   inbuf=(opus_int16*)malloc(sizeof(*inbuf)*2*48000);
+   generate_music(inbuf, 48000);
+   for(c=1;c<=2;c++)
+   {
+      for(fi=0;fi<4;fi++)
+      {
+         int frame_size=frame_sizes[fi];
+         for(ri=0;ri<4;ri++)
+         {
+            enc=opus_encoder_create(48000, c, OPUS_APPLICATION_AUDIO, &err);
+            if(err!=OPUS_OK || enc==NULL)test_failed();
+            dec=opus_decoder_create(rates[ri], c, &err);
+            if(err!=OPUS_OK || dec==NULL)test_failed();
+            dec2=opus_decoder_create(rates[ri], c, &err);
+            if(err!=OPUS_OK || dec2==NULL)test_failed();
+            if(opus_decoder_ctl(dec2, OPUS_SET_BANDLIMITED_DECODE(1))!=OPUS_OK)test_failed();
+            for(i=0;i<48000/frame_size;i++)
+            {
+               int len, n, n2;
+               opus_uint32 rng, rng2;
+               /* High-rate CELT for the first half, then hybrid when the
+                  frame size allows it */
+               if(i==24000/frame_size)
+               {
+                  if(opus_encoder_ctl(enc, OPUS_SET_BITRATE(c*16000))!=OPUS_OK)test_failed();
+                  if(opus_encoder_ctl(enc, OPUS_SET_FORCE_MODE(frame_size>=480?MODE_HYBRID:MODE_CELT_ONLY))!=OPUS_OK)test_failed();
+               } else if(i==0) {
+                  if(opus_encoder_ctl(enc, OPUS_SET_BITRATE(c*64000))!=OPUS_OK)test_failed();
+                  if(opus_encoder_ctl(enc, OPUS_SET_FORCE_MODE(MODE_CELT_ONLY))!=OPUS_OK)test_failed();
+               }
+               len=opus_encode(enc, inbuf+c*i*frame_size, frame_size, packet, MAX_PACKET);
+               if(len<0)test_failed();
+               n=opus_decode(dec, packet, len, out, 960, 0);
+               n2=opus_decode(dec2, packet, len, out2, 960, 0);
+               if(n!=frame_size*rates[ri]/48000 || n2!=n)test_failed();
+               if(memcmp(out, out2, sizeof(*out)*c*n)!=0)test_failed();
+               if(opus_decoder_ctl(dec, OPUS_GET_FINAL_RANGE(&rng))!=OPUS_OK)test_failed();
+               if(opus_decoder_ctl(dec2, OPUS_GET_FINAL_RANGE(&rng2))!=OPUS_OK)test_failed();
+               if(rng!=rng2)test_failed();
+            }
+            opus_encoder_destroy(enc);
+            opus_decoder_destroy(dec);
+            opus_decoder_destroy(dec2);
+         }
+      }
+   }
+   free(inbuf);
+   fprintf(stdout,"    Band-limited decoding OK.\n");
+}
+
+/* Conceals bursts of one to six lost CELT frames at every PLC complexity.
+   Complexity 10 must give the same output as the default, and decoding
+   must resume normally after each burst. */
+void run_plc_complexity_test(void)
+{
+   static const int frame_sizes[2]={960,480};
+   opus_int16 *inbuf;
+   opus_int16 out[2*960];
+   opus_int16 out2[2*960];
+   unsigned char packet[MAX_PACKET];
+   OpusEncoder *enc;
+   OpusDecoder *dec;
+   OpusDecoder *dec2;
+   int c, fi, complexity, i, err;
+
+   inbuf=(opus_int16*)malloc(sizeof(*inbuf)*2*48000);
+   generate_music(inbuf, 48000);
+   for(c=1;c<=2;c++)
+   {
+      for(fi=0;fi<2;fi++)
+      {
+         int frame_size=frame_sizes[fi];
+         for(complexity=0;complexity<=10;complexity++)
+         {
+            int burst=0;
+            enc=opus_encoder_create(48000, c, OPUS_APPLICATION_AUDIO, &err);
+            if(err!=OPUS_OK || enc==NULL)test_failed();
+            if(opus_encoder_ctl(enc, OPUS_SET_FORCE_MODE(MODE_CELT_ONLY))!=OPUS_OK)test_failed();
+            if(opus_encoder_ctl(enc, OPUS_SET_BITRATE(c*32000))!=OPUS_OK)test_failed();
+            dec=opus_decoder_create(48000, c, &err);
+            if(err!=OPUS_OK || dec==NULL)test_failed();
+            dec2=opus_decoder_create(48000, c, &err);
+            if(err!=OPUS_OK || dec2==NULL)test_failed();
+            if(opus_decoder_ctl(dec, OPUS_SET_PLC_COMPLEXITY(complexity))!=OPUS_OK)test_failed();
+            for(i=0;i<48000/frame_size;i++)
+            {
+               int len;
+               len=opus_encode(enc, inbuf+c*i*frame_size, frame_size, packet, MAX_PACKET);
+               if(len<0)test_failed();
+               /* Lose 1, 2, ..., 6 frames in a row after every 5 good ones */
+               if(i%5==4 && burst<6)
+               {
+                  int j;
+                  burst++;
+                  for(j=0;j<burst;j++)
+                  {
+                     if(opus_decode(dec, NULL, 0, out, frame_size, 0)!=frame_size)test_failed();
+                     if(opus_decode(dec2, NULL, 0, out2, frame_size, 0)!=frame_size)test_failed();
+                     if(complexity==10 && memcmp(out, out2, sizeof(*out)*c*frame_size)!=0)test_failed();
+                  }
+               }
+               if(opus_decode(dec, packet, len, out, frame_size, 0)!=frame_size)test_failed();
+               if(opus_decode(dec2, packet, len, out2, frame_size, 0)!=frame_size)test_failed();
+               if(complexity==10 && memcmp(out, out2, sizeof(*out)*c*frame_size)!=0)test_failed();
+            }
+            opus_encoder_destroy(enc);
+            opus_decoder_destroy(dec);
+            opus_decoder_destroy(dec2);
+         }
+      }
+   }
+   free(inbuf);
+   fprintf(stdout,"    PLC complexity OK.\n");
+}
+
+/* Recovers lost frames with opus_decode_recover() and checks that the PCM
+   and the final range match decoding the next packet twice, first with
+   decode_fec=1 and then normally. */
+void run_recover_test(void)
+{
+   static const int modes[3]={MODE_SILK_ONLY,MODE_HYBRID,MODE_CELT_ONLY};
+   static const int frame_sizes[4]={480,960,1920,2880};
+   opus_int16 *inbuf;
+   opus_int16 *lost;
+   opus_int16 *out;
+   opus_int16 *lost2;
+   opus_int16 *out2;
+#ifndef DISABLE_FLOAT_API
+   float *flost;
+   float *fout;
+   float *flost2;
+   float *fout2;
+#endif
+   unsigned char packet[MAX_PACKET];
+   OpusEncoder *enc;
+   OpusDecoder *dec;
+   OpusDecoder *dec2;
+   int c, m, fi, i, j, err;
+
+   inbuf=(opus_int16*)malloc(sizeof(*inbuf)*2*48000*2);
+   lost=(opus_int16*)malloc(sizeof(*lost)*2*2*MAX_FRAME_SAMP);
+   out=(opus_int16*)malloc(sizeof(*out)*2*MAX_FRAME_SAMP);
+   lost2=(opus_int16*)malloc(sizeof(*lost2)*2*2*MAX_FRAME_SAMP);
+   out2=(opus_int16*)malloc(sizeof(*out2)*2*MAX_FRAME_SAMP);
+#ifndef DISABLE_FLOAT_API
+   flost=(float*)malloc(sizeof(*flost)*2*2*MAX_FRAME_SAMP);
+   fout=(float*)malloc(sizeof(*fout)*2*MAX_FRAME_SAMP);
+   flost2=(float*)malloc(sizeof(*flost2)*2*2*MAX_FRAME_SAMP);
+   fout2=(float*)malloc(sizeof(*fout2)*2*MAX_FRAME_SAMP);
+#endif
+   generate_music(inbuf, 2*48000);
+   for(c=1;c<=2;c++)
+   {
+      for(m=0;m<3;m++)
+      {
+         for(fi=0;fi<4;fi++)
+         {
+            int frame_size=frame_sizes[fi];
+            enc=opus_encoder_create(48000, c, OPUS_APPLICATION_VOIP, &err);
+            if(err!=OPUS_OK || enc==NULL)test_failed();
+            if(opus_encoder_ctl(enc, OPUS_SET_FORCE_MODE(modes[m]))!=OPUS_OK)test_failed();
+            if(opus_encoder_ctl(enc, OPUS_SET_BITRATE(c*(modes[m]==MODE_SILK_ONLY?20000:32000)))!=OPUS_OK)test_failed();
+            if(opus_encoder_ctl(enc, OPUS_SET_INBAND_FEC(1))!=OPUS_OK)test_failed();
+            if(opus_encoder_ctl(enc, OPUS_SET_PACKET_LOSS_PERC(20))!=OPUS_OK)test_failed();
+            dec=opus_decoder_create(48000, c, &err);
+            if(err!=OPUS_OK || dec==NULL)test_failed();
+            dec2=opus_decoder_create(48000, c, &err);
+            if(err!=OPUS_OK || dec2==NULL)test_failed();
+            for(i=0;i<2*48000/frame_size;i++)
+            {
+               int len, n, n2;
+               opus_uint32 rng, rng2;
+               len=opus_encode(enc, inbuf+c*i*frame_size, frame_size, packet, MAX_PACKET);
+               if(len<0)test_failed();
+               if(i%4!=3)
+               {
+                  if(opus_decode(dec, packet, len, out, MAX_FRAME_SAMP, 0)!=frame_size)test_failed();
+                  if(opus_decode(dec2, packet, len, out2, MAX_FRAME_SAMP, 0)!=frame_size)test_failed();
+                  continue;
+               }
+               /* The previous packet was lost. Every other time, so was the
+                  one before it, which the FEC does not cover. */
+               j=(i&8)?2:1;
+#ifndef DISABLE_FLOAT_API
+               if(i%8==7)
+               {
+                  n=opus_decode_recover_float(dec, packet, len, flost, j*frame_size, fout, MAX_FRAME_SAMP);
+                  if(opus_decode_float(dec2, packet, len, flost2, j*frame_size, 1)!=j*frame_size)test_failed();
+                  n2=opus_decode_float(dec2, packet, len, fout2, MAX_FRAME_SAMP, 0);
+                  if(n!=frame_size || n2!=n)test_failed();
+                  if(memcmp(flost, flost2, sizeof(*flost)*c*j*frame_size)!=0)test_failed();
+                  if(memcmp(fout, fout2, sizeof(*fout)*c*n)!=0)test_failed();
+               } else
+#endif
+               {
+                  n=opus_decode_recover(dec, packet, len, lost, j*frame_size, out, MAX_FRAME_SAMP);
+                  if(opus_decode(dec2, packet, len, lost2, j*frame_size, 1)!=j*frame_size)test_failed();
+                  n2=opus_decode(dec2, packet, len, out2, MAX_FRAME_SAMP, 0);
+                  if(n!=frame_size || n2!=n)test_failed();
+                  if(memcmp(lost, lost2, sizeof(*lost)*c*j*frame_size)!=0)test_failed();
+                  if(memcmp(out, out2, sizeof(*out)*c*n)!=0)test_failed();
+               }
+               if(opus_decoder_ctl(dec, OPUS_GET_FINAL_RANGE(&rng))!=OPUS_OK)test_failed();
+               if(opus_decoder_ctl(dec2, OPUS_GET_FINAL_RANGE(&rng2))!=OPUS_OK)test_failed();
+               if(rng!=rng2)test_failed();
+            }
+            opus_encoder_destroy(enc);
+            opus_decoder_destroy(dec);
+            opus_decoder_destroy(dec2);
+         }
+      }
+   }
+   free(inbuf);
+   free(lost);
+   free(out);
+   free(lost2);
+   free(out2);
+#ifndef DISABLE_FLOAT_API
+   free(flost);
+   free(fout);
+   free(flost2);
+   free(fout2);
+#endif
+   fprintf(stdout,"    opus_decode_recover() OK.\n");
+}
+
+/* Encodes music, two seconds of digital silence and music again with DTX
+   enabled. The silence must go out as TOC-only frames apart from the
+   periodic keep-alive frames, and coding must resume cleanly afterwards. */
+void run_dtx_silence_test(void)
+{
+   static const int applications[2]={OPUS_APPLICATION_VOIP,OPUS_APPLICATION_AUDIO};
+   static const int frame_sizes[2]={960,480};
+   opus_int16 *inbuf;
+   opus_int16 *outbuf;
+   unsigned char packet[MAX_PACKET];
+   opus_uint32 enc_final_range;
+   opus_uint32 dec_final_range;
+   OpusEncoder *enc;
+   OpusDecoder *dec;
+   int ai, fi, i, err;
+
+   inbuf=(opus_int16*)malloc(sizeof(*inbuf)*2*48000*4);
+   outbuf=(opus_int16*)malloc(sizeof(*outbuf)*2*MAX_FRAME_SAMP);
+   generate_music(inbuf, 48000);
+   memset(inbuf+2*48000, 0, sizeof(*inbuf)*2*2*48000);
+   generate_music(inbuf+2*3*48000, 48000);
+   for(ai=0;ai<2;ai++)
+   {
+      for(fi=0;fi<2;fi++)
+      {
+         int frame_size=frame_sizes[fi];
+         int nb_frames=4*48000/frame_size;
+         int nb_dtx=0;
+         enc=opus_encoder_create(48000, 2, applications[ai], &err);
+         if(err!=OPUS_OK || enc==NULL)test_failed();
+         dec=opus_decoder_create(48000, 2, &err);
+         if(err!=OPUS_OK || dec==NULL)test_failed();
+         if(opus_encoder_ctl(enc, OPUS_SET_DTX(1))!=OPUS_OK)test_failed();
+         if(opus_encoder_ctl(enc, OPUS_SET_COMPLEXITY(10))!=OPUS_OK)test_failed();
+         for(i=0;i<nb_frames;i++)
+         {
+            int len;
+            int in_dtx;
+            len=opus_encode(enc, inbuf+2*i*frame_size, frame_size, packet, MAX_PACKET);
+            if(len<1 || len>MAX_PACKET)test_failed();
+            if(opus_encoder_ctl(enc, OPUS_GET_FINAL_RANGE(&enc_final_range))!=OPUS_OK)test_failed();
+            if(opus_encoder_ctl(enc, OPUS_GET_IN_DTX(&in_dtx))!=OPUS_OK)test_failed();
+            if(opus_decode(dec, packet, len, outbuf, MAX_FRAME_SAMP, 0)!=frame_size)test_failed();
+            if(opus_decoder_ctl(dec, OPUS_GET_FINAL_RANGE(&dec_final_range))!=OPUS_OK)test_failed();
+            if(len>1 && enc_final_range!=dec_final_range)test_failed();
+            if(len==1)
+            {
+               /* Only silence is sent as DTX, including the 60 ms that
+                  generate_music() starts with */
+               if(i*frame_size<48000 || i*frame_size>=3*48000+2880 || !in_dtx)test_failed();
+               nb_dtx++;
+            }
+         }
+         /* Everything but the first 200 ms of silence and one keep-alive
+            frame in every 21 is DTX. */
+         if(nb_dtx<(2*48000-9600)/frame_size*3/4)test_failed();
+         opus_encoder_destroy(enc);
+         opus_decoder_destroy(dec);
+      }
+   }
+   free(inbuf);
+   free(outbuf);
+   fprintf(stdout,"    DTX on digital silence OK.\n");
+}
+
+/* The sustained-silence shortcut is not bit-exact: the silent frames it
+   skips would have advanced the CELT rng, the SILK VAD and DTX counters and
+   the analysis history. Compare against an encoder that codes every silent
+   frame, which is forced by setting the bitrate before each frame since that
+   clears the shortcut. DTX decisions and TOCs must match, and the first
+   200 ms coded after the silence must decode to about the same energy. */
+void run_dtx_resume_test(void)
+{
+   static const int applications[2]={OPUS_APPLICATION_VOIP,OPUS_APPLICATION_AUDIO};
+   static const int frame_sizes[2]={960,480};
+   opus_int16 *inbuf;
+   opus_int16 *outbuf;
+   opus_int16 *ref_outbuf;
+   unsigned char packet[MAX_PACKET];
+   unsigned char ref_packet[MAX_PACKET];
+   OpusEncoder *enc;
+   OpusEncoder *ref_enc;
+   OpusDecoder *dec;
+   OpusDecoder *ref_dec;
+   int channels, ai, fi, i, j, err;
+
+   inbuf=(opus_int16*)malloc(sizeof(*inbuf)*2*48000*4);
+   outbuf=(opus_int16*)malloc(sizeof(*outbuf)*2*MAX_FRAME_SAMP);
+   ref_outbuf=(opus_int16*)malloc(sizeof(*ref_outbuf)*2*MAX_FRAME_SAMP);
+   for(channels=1;channels<=2;channels++)
+   {
+      memset(inbuf, 0, sizeof(*inbuf)*2*48000*4);
+      generate_music(inbuf, 48000);
+      generate_music(inbuf+2*3*48000, 48000);
+      if(channels==1)
+      {
+         for(i=0;i<4*48000;i++)inbuf[i]=inbuf[2*i];
+      }
+      for(ai=0;ai<2;ai++)
+      {
+         for(fi=0;fi<2;fi++)
+         {
+            int frame_size=frame_sizes[fi];
+            int resume=3*48000/frame_size;
+            double energy=0;
+            double ref_energy=0;
+            enc=opus_encoder_create(48000, channels, applications[ai], &err);
+            if(err!=OPUS_OK || enc==NULL)test_failed();
+            ref_enc=opus_encoder_create(48000, channels, applications[ai], &err);
+            if(err!=OPUS_OK || ref_enc==NULL)test_failed();
+            dec=opus_decoder_create(48000, channels, &err);
+            if(err!=OPUS_OK || dec==NULL)test_failed();
+            ref_dec=opus_decoder_create(48000, channels, &err);
+            if(err!=OPUS_OK || ref_dec==NULL)test_failed();
+            if(opus_encoder_ctl(enc, OPUS_SET_DTX(1))!=OPUS_OK)test_failed();
+            if(opus_encoder_ctl(enc, OPUS_SET_COMPLEXITY(10))!=OPUS_OK)test_failed();
+            if(opus_encoder_ctl(ref_enc, OPUS_SET_DTX(1))!=OPUS_OK)test_failed();
+            if(opus_encoder_ctl(ref_enc, OPUS_SET_COMPLEXITY(10))!=OPUS_OK)test_failed();
+            for(i=0;i<resume+10;i++)
+            {
+               int len, ref_len;
+               if(opus_encoder_ctl(ref_enc, OPUS_SET_BITRATE(OPUS_AUTO))!=OPUS_OK)test_failed();
+               len=opus_encode(enc, inbuf+channels*i*frame_size, frame_size, packet, MAX_PACKET);
+               if(len<1 || len>MAX_PACKET)test_failed();
+               ref_len=opus_encode(ref_enc, inbuf+channels*i*frame_size, frame_size, ref_packet, MAX_PACKET);
+               if(ref_len<1 || ref_len>MAX_PACKET)test_failed();
+               if((len==1)!=(ref_len==1) || packet[0]!=ref_packet[0])test_failed();
+               if(opus_decode(dec, packet, len, outbuf, MAX_FRAME_SAMP, 0)!=frame_size)test_failed();
+               if(opus_decode(ref_dec, ref_packet, ref_len, ref_outbuf, MAX_FRAME_SAMP, 0)!=frame_size)test_failed();
+               if(i>=resume)
+               {
+                  for(j=0;j<channels*frame_size;j++)
+                  {
+                     energy+=(double)outbuf[j]*outbuf[j];
+                     ref_energy+=(double)ref_outbuf[j]*ref_outbuf[j];
+                  }
+               }
+            }
+            /* Within 1 dB */
+            if(energy<ref_energy*.79 || energy>ref_energy*1.26)test_failed();
+            opus_encoder_destroy(enc);
+            opus_encoder_destroy(ref_enc);
+            opus_decoder_destroy(dec);
+            opus_decoder_destroy(ref_dec);
+         }
+      }
+   }
+   free(inbuf);
+   free(outbuf);
+   free(ref_outbuf);
+   fprintf(stdout,"    Coding after DTX silence OK.\n");
+}
+
+/* OPUS_RESET_STATE only clears what encoding modified since the last reset.
+   Encodes in one mode, resets and switches to another, and checks that the
+   output matches a copy of the encoder taken before anything was encoded. */
+void run_reset_test(void)
+{
+   static const int modes[3]={MODE_SILK_ONLY,MODE_HYBRID,MODE_CELT_ONLY};
+   opus_int16 *inbuf;
+   unsigned char packet[MAX_PACKET];
+   unsigned char packet2[MAX_PACKET];
+   OpusEncoder *enc;
+   OpusEncoder *enc2;
+   int size, m1, m2, i, err;
+
+   inbuf=(opus_int16*)malloc(sizeof(*inbuf)*2*48000);
+   generate_music(inbuf, 48000);
+   size=opus_encoder_get_size(2);
+   enc2=(OpusEncoder*)malloc(size);
+   if(enc2==NULL)test_failed();
+   for(m1=0;m1<3;m1++)
+   {
+      for(m2=0;m2<3;m2++)
+      {
+         enc=opus_encoder_create(48000, 2, OPUS_APPLICATION_AUDIO, &err);
+         if(err!=OPUS_OK || enc==NULL)test_failed();
+         if(opus_encoder_ctl(enc, OPUS_SET_BITRATE(32000))!=OPUS_OK)test_failed();
+         if(opus_encoder_ctl(enc, OPUS_SET_COMPLEXITY(10))!=OPUS_OK)test_failed();
+         /* A reset before anything is encoded leaves the state unchanged */
+         memcpy(enc2, enc, size);
+         if(opus_encoder_ctl(enc, OPUS_RESET_STATE)!=OPUS_OK)test_failed();
+         if(memcmp(enc2, enc, size)!=0)test_failed();
+         if(opus_encoder_ctl(enc, OPUS_SET_FORCE_MODE(modes[m1]))!=OPUS_OK)test_failed();
+         for(i=0;i<25;i++)
+         {
+            if(opus_encode(enc, inbuf+2*i*960, 960, packet, MAX_PACKET)<0)test_failed();
+         }
+         if(opus_encoder_ctl(enc, OPUS_RESET_STATE)!=OPUS_OK)test_failed();
+         if(opus_encoder_ctl(enc, OPUS_SET_FORCE_MODE(modes[m2]))!=OPUS_OK)test_failed();
+         if(opus_encoder_ctl(enc2, OPUS_SET_FORCE_MODE(modes[m2]))!=OPUS_OK)test_failed();
+         for(i=25;i<50;i++)
+         {
+            int len, len2;
+            opus_uint32 rng, rng2;
+            len=opus_encode(enc, inbuf+2*i*960, 960, packet, MAX_PACKET);
+            len2=opus_encode(enc2, inbuf+2*i*960, 960, packet2, MAX_PACKET);
+            if(len<0 || len!=len2 || memcmp(packet, packet2, len)!=0)test_failed();
+            if(opus_encoder_ctl(enc, OPUS_GET_FINAL_RANGE(&rng))!=OPUS_OK)test_failed();
+            if(opus_encoder_ctl(enc2, OPUS_GET_FINAL_RANGE(&rng2))!=OPUS_OK)test_failed();
+            if(rng!=rng2)test_failed();
+         }
+         opus_encoder_destroy(enc);
+      }
+   }
+   free(enc2);
+   free(inbuf);
+   fprintf(stdout,"    Encoder reset after mode switches OK.\n");
+}
+
+void run_no_analysis_test(void)
+{
+   opus_int16 *inbuf;
+   unsigned char packet[MAX_PACKET];
+   unsigned char packet2[MAX_PACKET];
+   OpusEncoder *enc;
+   OpusEncoder *enc2;
+   int c, i, err;
+
+   inbuf=(opus_int16*)malloc(sizeof(*inbuf)*2*48000);
+   generate_music(inbuf, 48000);
+   if(opus_encoder_get_size_ext(2, 2)!=0)test_failed();
+   if(opus_encoder_create_ext(48000, 2, OPUS_APPLICATION_AUDIO, 2, &err)!=NULL || err!=OPUS_BAD_ARG)test_failed();
+   for(c=1;c<=2;c++)
+   {
+      int size;
+      size=opus_encoder_get_size_ext(c, OPUS_ENCODER_NO_ANALYSIS);
+      if(size<=0 || size>opus_encoder_get_size(c))test_failed();
+#ifndef DISABLE_FLOAT_API
+      if(size==opus_encoder_get_size(c))test_failed();
+#endif
+      enc=opus_encoder_create(48000, c, OPUS_APPLICATION_AUDIO, &err);
+      if(err!=OPUS_OK || enc==NULL)test_failed();
+      enc2=(OpusEncoder*)malloc(size);
+      if(enc2==NULL)test_failed();
+      if(opus_encoder_init_ext(enc2, 48000, c, OPUS_APPLICATION_AUDIO, 3)!=OPUS_BAD_ARG)test_failed();
+      if(opus_encoder_init_ext(enc2, 48000, c, OPUS_APPLICATION_AUDIO, OPUS_ENCODER_NO_ANALYSIS)!=OPUS_OK)test_failed();
+      /* Below the complexity that runs the analysis, both give the same packets */
+      if(opus_encoder_ctl(enc, OPUS_SET_COMPLEXITY(5))!=OPUS_OK)test_failed();
+      if(opus_encoder_ctl(enc2, OPUS_SET_COMPLEXITY(5))!=OPUS_OK)test_failed();
+      for(i=0;i<50;i++)
+      {
+         int len, len2;
+         if(i==25)
+         {
+            if(opus_encoder_ctl(enc, OPUS_RESET_STATE)!=OPUS_OK)test_failed();
+            if(opus_encoder_ctl(enc2, OPUS_RESET_STATE)!=OPUS_OK)test_failed();
+         }
+         len=opus_encode(enc, inbuf+c*i*960, 960, packet, MAX_PACKET);
+         len2=opus_encode(enc2, inbuf+c*i*960, 960, packet2, MAX_PACKET);
+         if(len<0 || len!=len2 || memcmp(packet, packet2, len)!=0)test_failed();
+      }
+      /* At complexity 10, the encoder without analysis still works */
+      if(opus_encoder_ctl(enc2, OPUS_SET_COMPLEXITY(10))!=OPUS_OK)test_failed();
+      for(i=0;i<50;i++)
+      {
+         if(opus_encode(enc2, inbuf+c*i*960, 960, packet2, MAX_PACKET)<0)test_failed();
+      }
+      if(opus_encoder_ctl(enc2, OPUS_RESET_STATE)!=OPUS_OK)test_failed();
+      opus_encoder_destroy(enc);
+      free(enc2);
+   }
+   free(inbuf);
+   fprintf(stdout,"    Encoder without analysis state OK.\n");
+}
+
+void run_24bit_test(void)
+{
+   opus_int16 *inbuf;
+   opus_int32 *inbuf24;
+   opus_int16 out[2*960];
+   opus_int32 out24[2*960];
+   unsigned char packet[MAX_PACKET];
+   unsigned char packet24[MAX_PACKET];
+   OpusEncoder *enc;
+   OpusEncoder *enc24;
+   OpusDecoder *dec;
+   OpusDecoder *dec24;
+   int i, j, err;
+
+   inbuf=(opus_int16*)malloc(sizeof(*inbuf)*2*48000);
+   inbuf24=(opus_int32*)malloc(sizeof(*inbuf24)*2*48000);
+   generate_music(inbuf, 48000);
+   for(i=0;i<2*48000;i++)inbuf24[i]=inbuf[i]*256;
+   enc=opus_encoder_create(48000, 2, OPUS_APPLICATION_AUDIO, &err);
+   if(err!=OPUS_OK || enc==NULL)test_failed();
+   enc24=opus_encoder_create(48000, 2, OPUS_APPLICATION_AUDIO, &err);
+   if(err!=OPUS_OK || enc24==NULL)test_failed();
+   dec=opus_decoder_create(48000, 2, &err);
+   if(err!=OPUS_OK || dec==NULL)test_failed();
+   dec24=opus_decoder_create(48000, 2, &err);
+   if(err!=OPUS_OK || dec24==NULL)test_failed();
+   if(opus_encode24(enc24, inbuf24, 100, packet24, MAX_PACKET)!=OPUS_BAD_ARG)test_failed();
+   if(opus_decode24(dec24, NULL, 0, out24, 0, 0)!=OPUS_BAD_ARG)test_failed();
+   for(i=0;i<50;i++)
+   {
+      int len, len24;
+      len=opus_encode(enc, inbuf+2*i*960, 960, packet, MAX_PACKET);
+      len24=opus_encode24(enc24, inbuf24+2*i*960, 960, packet24, MAX_PACKET);
+      if(len<0 || len24<0)test_failed();
+#ifdef FIXED_POINT
+      /* 16-bit input in 24 bits rounds back to the same 16-bit input */
+      if(len!=len24 || memcmp(packet, packet24, len)!=0)test_failed();
+#endif
+      /* The 24-bit output is the 16-bit one with 8 more bits */
+      if(opus_decode(dec, packet24, len24, out, 960, 0)!=960)test_failed();
+      if(opus_decode24(dec24, packet24, len24, out24, 960, 0)!=960)test_failed();
+      for(j=0;j<2*960;j++)
+      {
+#ifdef FIXED_POINT
+         if(out24[j]!=out[j]*256)test_failed();
+#else
+         if(abs(out24[j]-out[j]*256)>128)test_failed();
+#endif
+      }
+   }
+   /* Packet loss concealment */
+   if(opus_decode(dec, NULL, 0, out, 960, 0)!=960)test_failed();
+   if(opus_decode24(dec24, NULL, 0, out24, 960, 0)!=960)test_failed();
+   for(j=0;j<2*960;j++)
+   {
+      if(abs(out24[j]-out[j]*256)>128)test_failed();
+   }
+   opus_encoder_destroy(enc);
+   opus_encoder_destroy(enc24);
+   opus_decoder_destroy(dec);
+   opus_decoder_destroy(dec24);
+   free(inbuf);
+   free(inbuf24);
+   fprintf(stdout,"    24-bit encode and decode OK.\n");
+}
+
 void fuzz_encoder_settings(const int num_encoders, const int num_setting_changes)
 {
    OpusEncoder *enc;
@@ -288,6 +940,9 @@ int run_test1(int no_fuzz)
    short *out2buf;
    opus_int32 bitrate_bps;
    unsigned char packet[MAX_PACKET+257];
+   unsigned char activity[48];
+   opus_int16 level[48];
+   opus_int16 activity_mem[OPUS_ACTIVITY_MEM_SIZE];
    opus_uint32 enc_final_range;
    opus_uint32 dec_final_range;
    int fswitch;
@@ -457,6 +1112,9 @@ int run_test1(int no_fuzz)
             if(out_samples!=frame_size)test_failed();
             if(opus_decoder_ctl(dec, OPUS_GET_FINAL_RANGE(&dec_final_range))!=OPUS_OK)test_failed();
             if(enc_final_range!=dec_final_range)test_failed();
+            /*Activity probe*/
+            if(count==0)memset(activity_mem,0,sizeof(activity_mem));
+            if(opus_packet_get_activity(packet,len,activity,level,activity_mem)!=opus_packet_get_nb_frames(packet,len))test_failed();
             /*LBRR decode*/
             out_samples = opus_decode(dec_err[0], packet, len, out2buf, frame_size, (fast_rand()&3)!=0);
             if(out_samples!=frame_size)test_failed();
@@ -690,6 +1348,17 @@ int main(int _argc, char **_argv)
      may cause the decoders to clip, which angers CLANG IOC.*/
    run_test1(getenv("TEST_OPUS_NOFUZZ")!=NULL);
 
+   run_activity_test();
+   run_bandlimited_test();
+   run_plc_complexity_test();
+   run_recover_test();
+   run_dtx_silence_test();
+   run_dtx_resume_test();
+
+   run_reset_test();
+   run_no_analysis_test();
+   run_24bit_test();
+
    /* Fuzz encoder settings online */
    if(getenv("TEST_OPUS_NOFUZZ")==NULL) {
       fprintf(stderr,"Running fuzz_encoder_settings with %d encoder(s) and %d setting change(s) each.\n",
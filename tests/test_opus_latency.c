@@ -0,0 +1,380 @@
+/* Copyright (c) 2026 Opus contributors */
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Worst-case per-call latency test. Each scenario drives the encoder or
+   decoder through transitions that are known to be expensive (mode switches
+   with CELT redundancy, 120 ms multiframe packets, PLC bursts) and records the
+   cost of every call, normalized to 20 ms of audio. Each scenario runs several
+   times and keeps the smallest cost seen for each call, so that preemption
+   and cache misses from other processes do not count. The test fails when the
+   worst call costs more than the scenario's budget times the median call.
+   Since other load on the machine skews that ratio, it is not run by
+   make check or ctest; run it by hand on an otherwise idle machine. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include "opus.h"
+#include "../src/opus_private.h"
+#include "test_opus_common.h"
+
+#ifndef M_PI
+#define M_PI (3.141592653)
+#endif
+
+#define MAX_PACKET (1500)
+#define MAX_CALLS (400)
+#define NB_RUNS (7)
+/* The first calls include one-time costs (tables, analysis warm-up) that
+   are not transitions */
+#define WARMUP_CALLS (5)
+
+typedef struct {
+   opus_uint64 ns[MAX_CALLS];
+   int samples[MAX_CALLS];
+   int nb_calls;
+} LatencyRecord;
+
+typedef void (*scenario_func)(LatencyRecord *rec, const opus_int16 *pcm, int pcm_len);
+
+typedef struct {
+   const char *name;
+   scenario_func run;
+   double budget;
+} LatencyScenario;
+
+/* Nanoseconds from a monotonic clock where there is one */
+static opus_uint64 latency_ns(void)
+{
+#if defined(_WIN32)
+   LARGE_INTEGER t, f;
+   QueryPerformanceCounter(&t);
+   QueryPerformanceFrequency(&f);
+   return (opus_uint64)((double)t.QuadPart*1e9/(double)f.QuadPart);
+#elif defined(CLOCK_MONOTONIC)
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (opus_uint64)ts.tv_sec*1000000000 + ts.tv_nsec;
+#else
+   return (opus_uint64)((double)clock()*1e9/CLOCKS_PER_SEC);
+#endif
+}
+
+#define TIMED_CALL(rec, nb_samples, call) do { \
+   opus_uint64 start_ = latency_ns(); \
+   call; \
+   (rec)->ns[(rec)->nb_calls] = latency_ns() - start_; \
+   (rec)->samples[(rec)->nb_calls] = (nb_samples); \
+   (rec)->nb_calls++; \
+} while (0)
+
+/* Speech-like test signal: harmonics of a gliding pitch under a syllable
+   envelope, with some noise. */
+static void generate_signal(opus_int16 *pcm, int len)
+{
+   int i;
+   double phase = 0;
+   for (i=0;i<len;i++)
+   {
+      double f0 = 120 + 60*sin(2*M_PI*i/48000.);
+      double env = .5 + .5*sin(2*M_PI*i/12000.);
+      double x;
+      int h;
+      phase += 2*M_PI*f0/48000.;
+      x = 0;
+      for (h=1;h<=8;h++)
+         x += sin(h*phase)/h;
+      x = 6000*env*x + (double)((opus_int32)(fast_rand()%2001)-1000);
+      pcm[2*i] = (opus_int16)x;
+      pcm[2*i+1] = (opus_int16)(.7*x);
+   }
+}
+
+static OpusEncoder *create_encoder(int application)
+{
+   int err;
+   OpusEncoder *enc;
+   enc = opus_encoder_create(48000, 2, application, &err);
+   if (err != OPUS_OK || enc == NULL) test_failed();
+   if (opus_encoder_ctl(enc, OPUS_SET_COMPLEXITY(10)) != OPUS_OK) test_failed();
+   return enc;
+}
+
+/* Forced SILK <-> hybrid <-> CELT switches, each of which codes a CELT
+   redundancy frame. */
+static void run_mode_switch(LatencyRecord *rec, const opus_int16 *pcm, int pcm_len)
+{
+   static const int modes[4][3] = {
+      {MODE_SILK_ONLY, OPUS_BANDWIDTH_WIDEBAND, 24000},
+      {MODE_CELT_ONLY, OPUS_BANDWIDTH_FULLBAND, 64000},
+      {MODE_HYBRID, OPUS_BANDWIDTH_FULLBAND, 32000},
+      {MODE_CELT_ONLY, OPUS_BANDWIDTH_FULLBAND, 64000}
+   };
+   OpusEncoder *enc;
+   unsigned char packet[MAX_PACKET];
+   int i, pos, len;
+   enc = create_encoder(OPUS_APPLICATION_VOIP);
+   pos = 0;
+   for (i=0;i<160;i++)
+   {
+      if (i%10 == 0)
+      {
+         const int *m = modes[(i/10)&3];
+         opus_encoder_ctl(enc, OPUS_SET_FORCE_MODE(m[0]));
+         opus_encoder_ctl(enc, OPUS_SET_BANDWIDTH(m[1]));
+         opus_encoder_ctl(enc, OPUS_SET_BITRATE(m[2]));
+      }
+      if (pos+960 > pcm_len) pos = 0;
+      TIMED_CALL(rec, 960, len = opus_encode(enc, pcm+2*pos, 960, packet, MAX_PACKET));
+      if (len < 0) test_failed();
+      pos += 960;
+   }
+   opus_encoder_destroy(enc);
+}
+
+/* SILK bandwidth switches (NB -> WB -> NB), which the encoder smooths
+   with a redundancy frame. */
+static void run_bandwidth_switch(LatencyRecord *rec, const opus_int16 *pcm, int pcm_len)
+{
+   static const int bandwidths[3] = {OPUS_BANDWIDTH_NARROWBAND,
+         OPUS_BANDWIDTH_WIDEBAND, OPUS_BANDWIDTH_MEDIUMBAND};
+   OpusEncoder *enc;
+   unsigned char packet[MAX_PACKET];
+   int i, pos, len;
+   enc = create_encoder(OPUS_APPLICATION_VOIP);
+   opus_encoder_ctl(enc, OPUS_SET_FORCE_MODE(MODE_SILK_ONLY));
+   opus_encoder_ctl(enc, OPUS_SET_BITRATE(20000));
+   pos = 0;
+   for (i=0;i<150;i++)
+   {
+      if (i%10 == 0)
+         opus_encoder_ctl(enc, OPUS_SET_MAX_BANDWIDTH(bandwidths[(i/10)%3]));
+      if (pos+960 > pcm_len) pos = 0;
+      TIMED_CALL(rec, 960, len = opus_encode(enc, pcm+2*pos, 960, packet, MAX_PACKET));
+      if (len < 0) test_failed();
+      pos += 960;
+   }
+   opus_encoder_destroy(enc);
+}
+
+/* 20 ms frames interleaved with 120 ms packets, which are coded as six
+   frames and repacketized. */
+static void run_multiframe(LatencyRecord *rec, const opus_int16 *pcm, int pcm_len)
+{
+   OpusEncoder *enc;
+   unsigned char packet[MAX_PACKET];
+   int i, pos, len;
+   enc = create_encoder(OPUS_APPLICATION_AUDIO);
+   opus_encoder_ctl(enc, OPUS_SET_BITRATE(48000));
+   opus_encoder_ctl(enc, OPUS_SET_EXPERT_FRAME_DURATION(OPUS_FRAMESIZE_ARG));
+   pos = 0;
+   for (i=0;i<120;i++)
+   {
+      int frame_size = i%4 == 3 ? 5760 : 960;
+      if (pos+frame_size > pcm_len) pos = 0;
+      TIMED_CALL(rec, frame_size, len = opus_encode(enc, pcm+2*pos, frame_size, packet, MAX_PACKET));
+      if (len < 0) test_failed();
+      pos += frame_size;
+   }
+   opus_encoder_destroy(enc);
+}
+
+/* Bursts of lost packets in a CELT stream and then a SILK stream. The first
+   concealed frame of a burst does the pitch search. */
+static void run_plc_burst(LatencyRecord *rec, const opus_int16 *pcm, int pcm_len)
+{
+   OpusEncoder *enc;
+   OpusDecoder *dec;
+   unsigned char packet[MAX_PACKET];
+   opus_int16 out[960*2];
+   int i, pos, len, err, ret;
+   enc = create_encoder(OPUS_APPLICATION_VOIP);
+   dec = opus_decoder_create(48000, 2, &err);
+   if (err != OPUS_OK || dec == NULL) test_failed();
+   pos = 0;
+   for (i=0;i<240;i++)
+   {
+      if (i == 0)
+      {
+         opus_encoder_ctl(enc, OPUS_SET_FORCE_MODE(MODE_CELT_ONLY));
+         opus_encoder_ctl(enc, OPUS_SET_BITRATE(64000));
+      } else if (i == 120)
+      {
+         opus_encoder_ctl(enc, OPUS_SET_FORCE_MODE(MODE_SILK_ONLY));
+         opus_encoder_ctl(enc, OPUS_SET_BITRATE(20000));
+      }
+      if (pos+960 > pcm_len) pos = 0;
+      len = opus_encode(enc, pcm+2*pos, 960, packet, MAX_PACKET);
+      if (len < 0) test_failed();
+      pos += 960;
+      /* Lose 3 out of every 20 packets, after the mode settled */
+      if (i%20 >= 15 && i%20 < 18)
+         TIMED_CALL(rec, 960, ret = opus_decode(dec, NULL, 0, out, 960, 0));
+      else
+         TIMED_CALL(rec, 960, ret = opus_decode(dec, packet, len, out, 960, 0));
+      if (ret != 960) test_failed();
+   }
+   opus_encoder_destroy(enc);
+   opus_decoder_destroy(dec);
+}
+
+static LatencyScenario scenarios[] = {
+   {"mode_switch", run_mode_switch, 4.},
+   {"bandwidth_switch", run_bandwidth_switch, 4.},
+   {"multiframe_120ms", run_multiframe, 4.},
+   {"plc_burst", run_plc_burst, 8.}
+};
+#define NB_SCENARIOS ((int)(sizeof(scenarios)/sizeof(scenarios[0])))
+
+static int compare_cost(const void *a, const void *b)
+{
+   double x = *(const double *)a;
+   double y = *(const double *)b;
+   return (x > y) - (x < y);
+}
+
+/* Returns 1 if the scenario stays within its budget. */
+static int test_scenario(const LatencyScenario *s, double scale,
+      const opus_int16 *pcm, int pcm_len)
+{
+   static LatencyRecord rec;
+   double cost[MAX_CALLS];
+   double sorted[MAX_CALLS];
+   double median, ratio;
+   opus_uint64 max_ns;
+   int run, i, nb_calls, worst;
+
+   nb_calls = 0;
+   for (run=0;run<NB_RUNS;run++)
+   {
+      rec.nb_calls = 0;
+      s->run(&rec, pcm, pcm_len);
+      if (run == 0)
+      {
+         nb_calls = rec.nb_calls;
+         for (i=0;i<nb_calls;i++)
+            cost[i] = 1e300;
+      }
+      if (rec.nb_calls != nb_calls) test_failed();
+      for (i=0;i<nb_calls;i++)
+      {
+         double c = (double)rec.ns[i]*960/rec.samples[i];
+         if (c < cost[i])
+            cost[i] = c;
+      }
+   }
+   if (nb_calls <= WARMUP_CALLS) test_failed();
+
+   worst = WARMUP_CALLS;
+   for (i=WARMUP_CALLS;i<nb_calls;i++)
+   {
+      sorted[i-WARMUP_CALLS] = cost[i];
+      if (cost[i] > cost[worst])
+         worst = i;
+   }
+   qsort(sorted, nb_calls-WARMUP_CALLS, sizeof(sorted[0]), compare_cost);
+   median = sorted[(nb_calls-WARMUP_CALLS)/2];
+   if (median <= 0)
+      median = 1;
+   ratio = cost[worst]/median;
+   max_ns = (opus_uint64)cost[worst];
+   fprintf(stderr, "    %-18s median %10.0f  max %10.0f (call %3d)  %5.2fx of %5.2fx %s\n",
+         s->name, median, (double)max_ns, worst, ratio, s->budget*scale,
+         ratio <= s->budget*scale ? "OK" : "FAILED");
+   return ratio <= s->budget*scale;
+}
+
+static void print_usage(char *argv[])
+{
+   fprintf(stderr, "Usage: %s [-scale <factor>] [-budget <scenario> <ratio>]\n", argv[0]);
+   fprintf(stderr, "  -scale <factor>             : multiply all budgets by <factor>\n");
+   fprintf(stderr, "  -budget <scenario> <ratio>  : worst call / median call budget for one scenario\n");
+}
+
+int main(int argc, char *argv[])
+{
+   opus_int16 *pcm;
+   int pcm_len;
+   double scale;
+   int i, j, failed;
+   const char *oversion;
+
+   scale = 1;
+   for (i=1;i<argc;i++)
+   {
+      if (strcmp(argv[i], "-scale") == 0 && i+1 < argc)
+      {
+         scale = atof(argv[++i]);
+      } else if (strcmp(argv[i], "-budget") == 0 && i+2 < argc)
+      {
+         for (j=0;j<NB_SCENARIOS;j++)
+            if (strcmp(argv[i+1], scenarios[j].name) == 0)
+               break;
+         if (j == NB_SCENARIOS)
+         {
+            fprintf(stderr, "Unknown scenario: %s\n", argv[i+1]);
+            return EXIT_FAILURE;
+         }
+         scenarios[j].budget = atof(argv[i+2]);
+         i += 2;
+      } else {
+         print_usage(argv);
+         return EXIT_FAILURE;
+      }
+   }
+
+   iseed = 0;
+   Rw = Rz = 1;
+   oversion = opus_get_version_string();
+   if (!oversion) test_failed();
+   fprintf(stderr, "Testing %s worst-case latency (cost per 20 ms, in ns).\n", oversion);
+
+   pcm_len = 48000*4;
+   pcm = (opus_int16 *)malloc(sizeof(*pcm)*2*pcm_len);
+   if (!pcm) test_failed();
+   generate_signal(pcm, pcm_len);
+
+   failed = 0;
+   for (i=0;i<NB_SCENARIOS;i++)
+      failed += !test_scenario(&scenarios[i], scale, pcm, pcm_len);
+   free(pcm);
+   if (failed)
+   {
+      fprintf(stderr, "%d latency scenario(s) over budget.\n", failed);
+      test_failed();
+   }
+   fprintf(stderr, "All latency tests passed.\n");
+   return 0;
+}